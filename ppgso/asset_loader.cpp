@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "asset_loader.h"
+#include "image_compressed.h"
+#include "texture_residency.h"
+#include "trace.h"
+
+namespace {
+  struct Entry {
+    std::weak_ptr<void> state;
+    ppgso::assets::detail::Measure measure;
+  };
+
+  struct Job {
+    std::string key;
+    std::function<void()> decode, upload;
+    std::exception_ptr error;
+  };
+
+  /*!
+   * Worker threads and queues shared by all requests.
+   * Jobs wait in the queue for a worker and in decoded for the render thread.
+   */
+  class Pool {
+  public:
+    Pool() {
+      // Keep one core for the render thread
+      auto cores = std::thread::hardware_concurrency();
+      auto count = cores > 1 ? cores - 1 : 1;
+      for (unsigned i = 0; i < count; i++)
+        workers.emplace_back([this, i] {
+          ppgso::trace::setThreadName("asset worker " + std::to_string(i));
+          work();
+        });
+    }
+
+    ~Pool() {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+      }
+      wake.notify_all();
+      for (auto &worker : workers)
+        worker.join();
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::deque<std::shared_ptr<Job>> queue, decoded;
+    std::map<std::string, Entry> registry;
+    size_t pending = 0;
+    ppgso::assets::Statistics statistics{0, 0};
+    std::chrono::steady_clock::time_point start;
+
+  private:
+    void work() {
+      while (true) {
+        std::shared_ptr<Job> job;
+        {
+          std::unique_lock<std::mutex> lock{mutex};
+          wake.wait(lock, [this] { return stopping || !queue.empty(); });
+          if (stopping) return;
+          job = queue.front();
+          queue.pop_front();
+        }
+
+        try {
+          PPGSO_TRACE_SCOPE("decode", job->key);
+          job->decode();
+        } catch (...) {
+          job->error = std::current_exception();
+        }
+
+        {
+          std::lock_guard<std::mutex> lock{mutex};
+          decoded.push_back(job);
+        }
+        done.notify_all();
+      }
+    }
+
+    std::vector<std::thread> workers;
+    bool stopping = false;
+  };
+
+  Pool &pool() {
+    static Pool instance;
+    return instance;
+  }
+}
+
+std::shared_ptr<void> ppgso::assets::detail::enqueue(const std::string &key, std::shared_ptr<void> state,
+                                                      Measure measure, std::function<void()> decode,
+                                                      std::function<void()> upload) {
+  auto &p = pool();
+  {
+    std::lock_guard<std::mutex> lock{p.mutex};
+    p.statistics.requests++;
+    if (auto registered = p.registry[key].state.lock())
+      return registered;
+
+    auto job = std::make_shared<Job>();
+    job->key = key;
+    job->decode = std::move(decode);
+    job->upload = std::move(upload);
+    p.registry[key] = {state, measure};
+    p.statistics.loads++;
+    if (p.pending++ == 0)
+      p.start = std::chrono::steady_clock::now();
+    p.queue.push_back(job);
+  }
+  p.wake.notify_one();
+  return state;
+}
+
+std::shared_ptr<void> ppgso::assets::detail::find(const std::string &key) {
+  auto &p = pool();
+  std::lock_guard<std::mutex> lock{p.mutex};
+  p.statistics.requests++;
+  auto found = p.registry.find(key);
+  if (found == p.registry.end()) return nullptr;
+  if (auto registered = found->second.state.lock())
+    return registered;
+
+  // Last handle is gone, the asset was destroyed
+  p.registry.erase(found);
+  return nullptr;
+}
+
+void ppgso::assets::detail::insert(const std::string &key, std::shared_ptr<void> state, Measure measure) {
+  auto &p = pool();
+  std::lock_guard<std::mutex> lock{p.mutex};
+  p.registry[key] = {state, measure};
+  p.statistics.loads++;
+}
+
+ppgso::Asset<ppgso::Mesh> ppgso::assets::loadMesh(const std::string &obj, Mesh::Format format) {
+  auto key = "mesh:" + std::to_string((int) format) + ":" + obj;
+  return load<Mesh>(key,
+                    [obj] { return mesh::load(obj); },
+                    [format](mesh::Loaded &&loaded) { return std::make_unique<Mesh>(std::move(loaded), format); });
+}
+
+ppgso::Asset<ppgso::Texture> ppgso::assets::loadTexture(const std::string &bmp) {
+  return load<Texture>("texture:" + bmp,
+                       [bmp] { return image::loadCompressedBMP(bmp); },
+                       [bmp](CompressedImage &&image) {
+                         auto tail = image::mipTail(image, residency::getTailSize());
+                         auto texture = std::make_unique<Texture>(std::move(image));
+                         residency::track(*texture, bmp, std::move(tail));
+                         return texture;
+                       });
+}
+
+ppgso::Asset<ppgso::TextureAlpha> ppgso::assets::loadTextureAlpha(const std::string &png) {
+  return load<TextureAlpha>("texture_alpha:" + png,
+                            [png] { return image::loadCompressedPNG(png); },
+                            [png](CompressedImage &&image) {
+                              auto tail = image::mipTail(image, residency::getTailSize());
+                              auto texture = std::make_unique<TextureAlpha>(std::move(image));
+                              residency::track(*texture, png, std::move(tail));
+                              return texture;
+                            });
+}
+
+ppgso::Asset<ppgso::TextureArray> ppgso::assets::loadTextureArray(const std::vector<std::string> &bmps) {
+  std::string key = "texture_array:";
+  for (auto &bmp : bmps) key += bmp + "|";
+  return load<TextureArray>(key,
+                            [bmps] {
+                              std::vector<CompressedImage> layers;
+                              for (auto &bmp : bmps) layers.push_back(image::loadCompressedBMP(bmp));
+                              return layers;
+                            },
+                            [](std::vector<CompressedImage> &&layers) {
+                              return std::make_unique<TextureArray>(std::move(layers));
+                            });
+}
+
+ppgso::Asset<ppgso::Shader> ppgso::assets::loadShader(const std::string &vertex_shader_code,
+                                                      const std::string &fragment_shader_code) {
+  std::hash<std::string> hash;
+  auto key = "shader:" + std::to_string(hash(vertex_shader_code)) + ":" + std::to_string(hash(fragment_shader_code));
+  return share<Shader>(key, [&] { return std::make_unique<Shader>(vertex_shader_code, fragment_shader_code); });
+}
+
+void ppgso::assets::upload(double budget) {
+  auto &p = pool();
+  auto start = std::chrono::steady_clock::now();
+
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::lock_guard<std::mutex> lock{p.mutex};
+      if (p.decoded.empty()) return;
+      job = p.decoded.front();
+      p.decoded.pop_front();
+    }
+
+    auto finished = [&p, &job](bool failed) {
+      std::lock_guard<std::mutex> lock{p.mutex};
+      // Failed assets are not registered so new requests try to load them again
+      if (failed)
+        p.registry.erase(job->key);
+      if (--p.pending == 0) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - p.start;
+        std::cout << "Loaded all assets in " << elapsed.count() << " ms (" << p.statistics.loads << " loads for "
+                  << p.statistics.requests << " requests)" << std::endl;
+      }
+    };
+
+    if (job->error) {
+      finished(true);
+      std::rethrow_exception(job->error);
+    }
+    try {
+      PPGSO_TRACE_SCOPE("upload", job->key);
+      job->upload();
+    } catch (...) {
+      finished(true);
+      throw;
+    }
+    finished(false);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed.count() >= budget) return;
+  }
+}
+
+void ppgso::assets::finish() {
+  auto &p = pool();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{p.mutex};
+      p.done.wait(lock, [&p] { return p.pending == 0 || !p.decoded.empty(); });
+      if (p.pending == 0) return;
+    }
+    upload(std::numeric_limits<double>::infinity());
+  }
+}
+
+size_t ppgso::assets::getPending() {
+  auto &p = pool();
+  std::lock_guard<std::mutex> lock{p.mutex};
+  return p.pending;
+}
+
+ppgso::assets::Statistics ppgso::assets::getStatistics() {
+  auto &p = pool();
+  std::lock_guard<std::mutex> lock{p.mutex};
+  return p.statistics;
+}
+
+std::vector<ppgso::assets::Usage> ppgso::assets::getMemoryUsage() {
+  auto &p = pool();
+  std::vector<std::pair<std::string, Entry>> entries;
+  {
+    std::lock_guard<std::mutex> lock{p.mutex};
+    entries.assign(p.registry.begin(), p.registry.end());
+  }
+
+  // Assets are only modified on the render thread, measure them without holding the lock
+  std::vector<Usage> usage;
+  for (auto &entry : entries) {
+    if (auto state = entry.second.state.lock())
+      usage.push_back({entry.first, entry.second.measure(state.get())});
+  }
+  return usage;
+}
+
+void ppgso::assets::reportMemory(std::ostream &out) {
+  auto usage = getMemoryUsage();
+  std::stable_sort(usage.begin(), usage.end(), [](const Usage &a, const Usage &b) {
+    return a.memory.gpu > b.memory.gpu;
+  });
+
+  MemoryUsage total{0, 0};
+  auto flags = out.flags();
+  out << std::fixed << std::setprecision(1);
+  out << std::setw(12) << "CPU KiB" << std::setw(12) << "GPU KiB" << "  Asset" << std::endl;
+  for (auto &asset : usage) {
+    out << std::setw(12) << asset.memory.cpu / 1024.0 << std::setw(12) << asset.memory.gpu / 1024.0
+        << "  " << asset.key << std::endl;
+    total.cpu += asset.memory.cpu;
+    total.gpu += asset.memory.gpu;
+  }
+  out << std::setw(12) << total.cpu / 1024.0 << std::setw(12) << total.gpu / 1024.0
+      << "  Total of " << usage.size() << " assets" << std::endl;
+  out.flags(flags);
+}
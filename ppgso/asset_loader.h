@@ -0,0 +1,255 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include "memory_usage.h"
+#include "mesh.h"
+#include "shader.h"
+#include "texture.h"
+#include "texture_alpha.h"
+#include "texture_array.h"
+
+namespace ppgso {
+
+  /*!
+   * Reference counted handle to an asset of the registry (see ppgso::assets).
+   * The handle is empty until the asset is requested, the asset can be used once it is ready.
+   * Handles to the same key share the asset, it is destroyed with its OpenGL objects when the last handle goes away.
+   */
+  template<typename T>
+  class Asset {
+  public:
+    struct State {
+      std::unique_ptr<T> asset;
+    };
+
+    Asset() = default;
+    explicit Asset(std::shared_ptr<State> state) : state{std::move(state)} {}
+
+    /*!
+     * Check whether the asset was uploaded and can be used.
+     *
+     * @return - True when the asset is available.
+     */
+    bool ready() const { return state && state->asset; }
+
+    /*!
+     * Get the asset.
+     *
+     * @return - Pointer to the asset, nullptr until it is ready.
+     */
+    T *get() const { return state ? state->asset.get() : nullptr; }
+
+    T &operator*() const { return *state->asset; }
+    T *operator->() const { return state->asset.get(); }
+
+    /*!
+     * Check whether the asset was requested, use ready() to check whether it can be used.
+     */
+    explicit operator bool() const { return state != nullptr; }
+
+  private:
+    std::shared_ptr<State> state;
+  };
+
+  /*!
+   * Asset registry with asynchronous loading.
+   * Assets are registered by key (kind and file path), so every file is loaded once while any handle to it lives.
+   * Files are read and decoded by a pool of worker threads, one less than the number of cores.
+   * OpenGL objects are created on the render thread by calling upload every frame.
+   * Errors of the workers are rethrown by upload.
+   */
+  namespace assets {
+
+    /*!
+     * Counters of requested and loaded assets.
+     */
+    struct Statistics {
+      unsigned long requests, loads;
+    };
+
+    /*!
+     * Memory held by a registered asset.
+     */
+    struct Usage {
+      std::string key;
+      MemoryUsage memory;
+    };
+
+    namespace detail {
+      // Measures the asset held by a state, assets without getMemoryUsage report nothing
+      using Measure = MemoryUsage (*)(const void *state);
+
+      template<typename T>
+      auto measure(const T &asset, int) -> decltype(asset.getMemoryUsage()) { return asset.getMemoryUsage(); }
+
+      template<typename T>
+      MemoryUsage measure(const T &, long) { return {0, 0}; }
+
+      template<typename T>
+      MemoryUsage measureState(const void *state) {
+        auto &asset = static_cast<const typename Asset<T>::State *>(state)->asset;
+        return asset ? measure(*asset, 0) : MemoryUsage{0, 0};
+      }
+
+      /*!
+       * Queue decoding of an asset unless an asset with the same key is registered.
+       *
+       * @param key - Unique key of the asset.
+       * @param state - State of the new asset.
+       * @param measure - Reports memory of the asset once uploaded.
+       * @param decode - Called on a worker thread.
+       * @param upload - Called on the render thread after decode finished.
+       * @return - State of the registered asset or the new state.
+       */
+      std::shared_ptr<void> enqueue(const std::string &key, std::shared_ptr<void> state, Measure measure,
+                                    std::function<void()> decode, std::function<void()> upload);
+
+      /*!
+       * Find registered asset.
+       *
+       * @param key - Unique key of the asset.
+       * @return - State of the asset or nullptr when no handle to it lives.
+       */
+      std::shared_ptr<void> find(const std::string &key);
+
+      /*!
+       * Register asset created on the render thread.
+       *
+       * @param key - Unique key of the asset.
+       * @param state - State of the asset.
+       * @param measure - Reports memory of the asset.
+       */
+      void insert(const std::string &key, std::shared_ptr<void> state, Measure measure);
+    }
+
+    /*!
+     * Load custom asset in two stages.
+     *
+     * @param key - Unique key of the asset, requests with the same key share the asset.
+     * @param decode - Function returning the decoded data, called on a worker thread without OpenGL context.
+     * @param upload - Function creating the asset from the decoded data, called on the render thread.
+     * @return - Handle that becomes ready after upload.
+     */
+    template<typename T, typename Decode, typename Upload>
+    Asset<T> load(const std::string &key, Decode decode, Upload upload) {
+      using Decoded = decltype(decode());
+      auto state = std::make_shared<typename Asset<T>::State>();
+      auto decoded = std::make_shared<std::unique_ptr<Decoded>>();
+      auto shared = detail::enqueue(key, state, &detail::measureState<T>,
+                                    [decoded, decode] { decoded->reset(new Decoded(decode())); },
+                                    [decoded, state, upload] {
+                                      state->asset = upload(std::move(**decoded));
+                                      decoded->reset();
+                                    });
+      return Asset<T>{std::static_pointer_cast<typename Asset<T>::State>(shared)};
+    }
+
+    /*!
+     * Get registered asset or create it right away, must be called on the render thread.
+     *
+     * @param key - Unique key of the asset.
+     * @param create - Function creating the asset when it is not registered.
+     * @return - Ready handle.
+     */
+    template<typename T, typename Create>
+    Asset<T> share(const std::string &key, Create create) {
+      auto state = std::static_pointer_cast<typename Asset<T>::State>(detail::find(key));
+      if (!state) {
+        state = std::make_shared<typename Asset<T>::State>();
+        state->asset = create();
+        detail::insert(key, state, &detail::measureState<T>);
+      }
+      return Asset<T>{state};
+    }
+
+    /*!
+     * Load mesh in the background (see Mesh and mesh::load).
+     *
+     * @param obj - File path to the obj file to load.
+     * @param format - Vertex format used on the GPU.
+     * @return - Handle to the mesh.
+     */
+    Asset<Mesh> loadMesh(const std::string &obj, Mesh::Format format = Mesh::Format::Float);
+
+    /*!
+     * Load texture from a BMP file in the background, compressed to BC1 (see image::loadCompressedBMP).
+     * The texture is tracked by the residency manager (see residency).
+     *
+     * @param bmp - File path to the BMP file to load.
+     * @return - Handle to the texture.
+     */
+    Asset<Texture> loadTexture(const std::string &bmp);
+
+    /*!
+     * Load texture with alpha channel from a PNG file in the background, compressed to BC3 (see image::loadCompressedPNG).
+     * The texture is tracked by the residency manager (see residency).
+     *
+     * @param png - File path to the PNG file to load.
+     * @return - Handle to the texture.
+     */
+    Asset<TextureAlpha> loadTextureAlpha(const std::string &png);
+
+    /*!
+     * Load same sized BMP files into the layers of a texture array in the background, compressed to BC1.
+     * Requests for the same list of files share the array.
+     *
+     * @param bmps - File paths to the BMP files, the layer of a file is its index in the list.
+     * @return - Handle to the texture array.
+     */
+    Asset<TextureArray> loadTextureArray(const std::vector<std::string> &bmps);
+
+    /*!
+     * Get shader shared by all users of the same sources, must be called on the render thread.
+     *
+     * @param vertex_shader_code - Vertex shader source code.
+     * @param fragment_shader_code - Fragment shader source code.
+     * @return - Ready handle to the shader.
+     */
+    Asset<Shader> loadShader(const std::string &vertex_shader_code, const std::string &fragment_shader_code);
+
+    /*!
+     * Upload decoded assets, must be called on the render thread.
+     * At least one asset is uploaded when any is decoded, then uploading stops once the budget is spent.
+     *
+     * @param budget - Time budget in milliseconds.
+     */
+    void upload(double budget);
+
+    /*!
+     * Block until all requested assets are decoded and uploaded, must be called on the render thread.
+     */
+    void finish();
+
+    /*!
+     * Get number of requested assets that are not uploaded yet.
+     *
+     * @return - Number of pending assets.
+     */
+    size_t getPending();
+
+    /*!
+     * Get counters of requested and loaded assets, requests exceeding loads were served by the registry.
+     *
+     * @return - Counters since start.
+     */
+    Statistics getStatistics();
+
+    /*!
+     * Get memory held by the registered assets that are alive, must be called on the render thread.
+     *
+     * @return - Memory per asset key, ordered by key.
+     */
+    std::vector<Usage> getMemoryUsage();
+
+    /*!
+     * Print CPU and GPU memory per asset and the totals, largest GPU users first.
+     *
+     * @param out - Stream to print to.
+     */
+    void reportMemory(std::ostream &out);
+  }
+}
@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include "asset_pack.h"
+#include "lodepng.h"
+
+namespace ppgso {
+  namespace pack {
+
+    namespace {
+      const char PACK_MAGIC[4] = {'P', 'P', 'A', 'K'};
+      const uint32_t PACK_VERSION = 1;
+
+      enum Compression : uint32_t {
+        STORED = 0,
+        DEFLATED = 1
+      };
+
+      struct PackHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount, slotCount;
+        uint64_t entriesOffset, slotsOffset, namesOffset, fileSize;
+      };
+
+      struct PackEntry {
+        uint64_t pathHash, offset, size, storedSize;
+        uint32_t nameOffset, nameLength, compression, reserved;
+      };
+
+      uint64_t align(uint64_t offset) {
+        return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+      }
+
+      // Paths are stored relative to the data directory with forward slashes
+      std::string normalize(const std::string &path) {
+        std::string result = path;
+        std::replace(result.begin(), result.end(), '\\', '/');
+        while (result.compare(0, 2, "./") == 0)
+          result.erase(0, 2);
+        return result;
+      }
+
+      // FNV-1a
+      uint64_t hashPath(const std::string &path) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (auto c : path) {
+          hash ^= (unsigned char) c;
+          hash *= 1099511628211ULL;
+        }
+        return hash;
+      }
+
+      struct Mounted {
+        std::unique_ptr<MappedFile> file;
+        uint32_t serial = 0;
+        int64_t modified = 0;
+        const PackHeader *header;
+        const PackEntry *entries;
+        const uint32_t *slots;
+        const char *names;
+
+        const PackEntry *find(const std::string &path, uint64_t hash) const {
+          auto mask = header->slotCount - 1;
+          for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+            auto index = slots[slot];
+            if (index == 0) return nullptr;
+            auto &entry = entries[index - 1];
+            if (entry.pathHash == hash && entry.nameLength == path.size() &&
+                memcmp(names + entry.nameOffset, path.data(), path.size()) == 0)
+              return &entry;
+          }
+        }
+      };
+
+      struct Mounts {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Mounted>> packs;
+        uint32_t serial = 0;
+        bool defaultChecked = false;
+      };
+
+      Mounts &mounts() {
+        static Mounts instance;
+        return instance;
+      }
+
+      std::unique_ptr<Mounted> map(const std::string &pack) {
+        auto mounted = std::make_unique<Mounted>();
+        mounted->file = std::make_unique<MappedFile>(pack, MappedFile::Access::Random);
+        auto base = mounted->file->data();
+        auto size = (uint64_t) mounted->file->size();
+
+        std::stringstream msg;
+        msg << "Invalid asset pack. " << pack;
+        if (size < sizeof(PackHeader)) throw std::runtime_error(msg.str());
+
+        auto header = reinterpret_cast<const PackHeader *>(base);
+        if (memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 ||
+            header->version != PACK_VERSION ||
+            header->fileSize != size ||
+            header->slotCount == 0 || (header->slotCount & (header->slotCount - 1)) != 0 ||
+            header->slotCount <= header->entryCount ||
+            header->entriesOffset % alignof(PackEntry) != 0 ||
+            header->slotsOffset % alignof(uint32_t) != 0 ||
+            header->entriesOffset + (uint64_t) header->entryCount * sizeof(PackEntry) > header->slotsOffset ||
+            header->slotsOffset + (uint64_t) header->slotCount * sizeof(uint32_t) > header->namesOffset ||
+            header->namesOffset > size)
+          throw std::runtime_error(msg.str());
+
+        mounted->header = header;
+        mounted->entries = reinterpret_cast<const PackEntry *>(base + header->entriesOffset);
+        mounted->slots = reinterpret_cast<const uint32_t *>(base + header->slotsOffset);
+        mounted->names = base + header->namesOffset;
+
+        uint64_t fileSize;
+        MappedFile::stat(pack, fileSize, mounted->modified);
+
+        // Entries must lie within the file so lookups need no further checks
+        for (uint32_t i = 0; i < header->entryCount; i++) {
+          auto &entry = mounted->entries[i];
+          if (entry.offset + entry.storedSize > header->entriesOffset ||
+              header->namesOffset + entry.nameOffset + entry.nameLength > size ||
+              entry.compression > DEFLATED)
+            throw std::runtime_error(msg.str());
+        }
+        for (uint32_t i = 0; i < header->slotCount; i++) {
+          if (mounted->slots[i] > header->entryCount)
+            throw std::runtime_error(msg.str());
+        }
+        return mounted;
+      }
+
+      // Must be called with the mutex locked
+      void mountDefault(Mounts &m) {
+        if (m.defaultChecked) return;
+        m.defaultChecked = true;
+        if (!MappedFile::exists(DEFAULT_PACK)) return;
+
+        // Loose files are still available without the pack
+        try {
+          m.packs.insert(m.packs.begin(), map(DEFAULT_PACK));
+          m.packs.front()->serial = ++m.serial;
+        } catch (std::runtime_error &e) {
+          std::cerr << e.what() << std::endl;
+        }
+      }
+
+      // Find entry in the most recently mounted pack containing it
+      const PackEntry *find(const std::string &path, const char *&base, const Mounted **found = nullptr) {
+        auto &m = mounts();
+        std::lock_guard<std::mutex> lock{m.mutex};
+        mountDefault(m);
+
+        auto hash = hashPath(path);
+        for (auto pack = m.packs.rbegin(); pack != m.packs.rend(); ++pack) {
+          if (auto entry = (*pack)->find(path, hash)) {
+            base = (*pack)->file->data();
+            if (found) *found = pack->get();
+            return entry;
+          }
+        }
+        return nullptr;
+      }
+    }
+
+    File::File(const char *data, size_t size) : begin{data}, length{size} {}
+
+    File::File(std::vector<unsigned char> &&buffer) : buffer{std::move(buffer)} {
+      begin = (const char *) this->buffer.data();
+      length = this->buffer.size();
+    }
+
+    File::File(std::unique_ptr<MappedFile> &&mapping) : mapping{std::move(mapping)} {
+      begin = this->mapping->data();
+      length = this->mapping->size();
+    }
+
+    const char *File::data() const {
+      return begin;
+    }
+
+    size_t File::size() const {
+      return length;
+    }
+
+    void mount(const std::string &pack) {
+      auto mounted = map(pack);
+      auto &m = mounts();
+      std::lock_guard<std::mutex> lock{m.mutex};
+      mountDefault(m);
+      mounted->serial = ++m.serial;
+      m.packs.push_back(std::move(mounted));
+    }
+
+    bool exists(const std::string &path) {
+      const char *base;
+      return find(normalize(path), base) || MappedFile::exists(path);
+    }
+
+    Stamp stamp(const std::string &path) {
+      const char *base = nullptr;
+      const Mounted *pack = nullptr;
+      if (auto entry = find(normalize(path), base, &pack))
+        return {entry->size, pack->modified, pack->serial};
+
+      Stamp result = {0, 0, 0};
+      if (!MappedFile::stat(path, result.size, result.modified)) {
+        std::stringstream msg;
+        msg << "Could not find asset. " << path;
+        throw std::runtime_error(msg.str());
+      }
+      return result;
+    }
+
+    File open(const std::string &path) {
+      const char *base = nullptr;
+      auto entry = find(normalize(path), base);
+      if (!entry)
+        return File{std::make_unique<MappedFile>(path)};
+
+      auto data = base + entry->offset;
+      if (entry->compression == STORED)
+        return File{data, (size_t) entry->size};
+
+      std::vector<unsigned char> buffer;
+      buffer.reserve(entry->size);
+      auto error = lodepng::decompress(buffer, (const unsigned char *) data, entry->storedSize);
+      if (error || buffer.size() != entry->size) {
+        std::stringstream msg;
+        msg << "Could not decompress asset. " << path;
+        throw std::runtime_error(msg.str());
+      }
+      return File{std::move(buffer)};
+    }
+
+    Writer::Writer(const std::string &pack) : path{pack}, output{pack + ".tmp", std::ios::binary} {
+      if (!output.is_open()) {
+        std::stringstream msg;
+        msg << "Could not open asset pack for writing. " << pack;
+        throw std::runtime_error(msg.str());
+      }
+
+      // Header is written by finish
+      PackHeader header = {};
+      output.write((const char *) &header, sizeof(PackHeader));
+    }
+
+    void Writer::add(const std::string &asset, const char *data, size_t size, bool compress) {
+      Pending entry = {normalize(asset), 0, size, size, STORED};
+      for (auto &other : entries) {
+        if (other.path == entry.path) {
+          std::stringstream msg;
+          msg << "Duplicate asset in pack. " << entry.path;
+          throw std::runtime_error(msg.str());
+        }
+      }
+
+      std::vector<unsigned char> compressed;
+      if (compress && size > 0 &&
+          lodepng::compress(compressed, (const unsigned char *) data, size) == 0 &&
+          compressed.size() <= size - size / 8) {
+        data = (const char *) compressed.data();
+        entry.storedSize = compressed.size();
+        entry.compression = DEFLATED;
+      }
+
+      std::vector<char> padding(BLOB_ALIGNMENT, 0);
+      auto position = (uint64_t) output.tellp();
+      entry.offset = align(position);
+      output.write(padding.data(), entry.offset - position);
+      output.write(data, entry.storedSize);
+      entries.push_back(entry);
+    }
+
+    uint64_t Writer::finish() {
+      std::sort(entries.begin(), entries.end(), [](const Pending &a, const Pending &b) { return a.path < b.path; });
+
+      // Hash table at most half full keeps probe sequences short
+      uint32_t slotCount = 1;
+      while (slotCount < entries.size() * 2) slotCount *= 2;
+      std::vector<uint32_t> slots(slotCount, 0);
+
+      std::vector<PackEntry> table;
+      std::string names;
+      for (uint32_t i = 0; i < entries.size(); i++) {
+        auto &pending = entries[i];
+        PackEntry entry = {};
+        entry.pathHash = hashPath(pending.path);
+        entry.offset = pending.offset;
+        entry.size = pending.size;
+        entry.storedSize = pending.storedSize;
+        entry.nameOffset = (uint32_t) names.size();
+        entry.nameLength = (uint32_t) pending.path.size();
+        entry.compression = pending.compression;
+        table.push_back(entry);
+        names += pending.path;
+
+        auto slot = entry.pathHash & (slotCount - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (slotCount - 1);
+        slots[slot] = i + 1;
+      }
+
+      PackHeader header = {};
+      memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+      header.version = PACK_VERSION;
+      header.entryCount = (uint32_t) table.size();
+      header.slotCount = slotCount;
+
+      std::vector<char> padding(BLOB_ALIGNMENT, 0);
+      auto position = (uint64_t) output.tellp();
+      header.entriesOffset = align(position);
+      header.slotsOffset = header.entriesOffset + table.size() * sizeof(PackEntry);
+      header.namesOffset = header.slotsOffset + slots.size() * sizeof(uint32_t);
+      header.fileSize = header.namesOffset + names.size();
+
+      output.write(padding.data(), header.entriesOffset - position);
+      output.write((const char *) table.data(), table.size() * sizeof(PackEntry));
+      output.write((const char *) slots.data(), slots.size() * sizeof(uint32_t));
+      output.write(names.data(), names.size());
+      output.seekp(0);
+      output.write((const char *) &header, sizeof(PackHeader));
+      output.close();
+
+      // Write to a temporary file first so a partially written pack is never mounted
+      auto temporary = path + ".tmp";
+      if (!output) {
+        std::remove(temporary.c_str());
+        std::stringstream msg;
+        msg << "Could not write asset pack. " << path;
+        throw std::runtime_error(msg.str());
+      }
+
+      std::remove(path.c_str());
+      if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        std::stringstream msg;
+        msg << "Could not replace asset pack. " << path;
+        throw std::runtime_error(msg.str());
+      }
+      return header.fileSize;
+    }
+  }
+}
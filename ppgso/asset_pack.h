@@ -0,0 +1,143 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace ppgso {
+  namespace pack {
+
+    /*!
+     * Read-only contents of an asset.
+     * Uncompressed pack entries point directly into the mapped pack, compressed entries are inflated
+     * into memory and loose files are mapped on their own.
+     */
+    class File {
+    public:
+      File(const char *data, size_t size);
+      File(std::vector<unsigned char> &&buffer);
+      File(std::unique_ptr<MappedFile> &&mapping);
+
+      /*!
+       * Get pointer to the first byte of the asset.
+       *
+       * @return - Pointer to data, valid while the object lives.
+       */
+      const char *data() const;
+
+      /*!
+       * Get size of the asset.
+       *
+       * @return - Size in bytes.
+       */
+      size_t size() const;
+
+    private:
+      std::unique_ptr<MappedFile> mapping;
+      std::vector<unsigned char> buffer;
+      const char *begin = nullptr;
+      size_t length = 0;
+    };
+
+    /*!
+     * Name of the pack mounted automatically when it exists in the working directory.
+     */
+    const std::string DEFAULT_PACK = "data.pack";
+
+    /*!
+     * Map pack into memory, its entries take precedence over loose files and packs mounted earlier.
+     * Mounted packs stay mapped until the program ends.
+     *
+     * @param pack - File path to the pack.
+     */
+    void mount(const std::string &pack);
+
+    /*!
+     * Check whether an asset exists in a mounted pack or as a loose file.
+     *
+     * @param path - Path of the asset relative to the data directory.
+     * @return - True when the asset can be opened.
+     */
+    bool exists(const std::string &path);
+
+    /*!
+     * Size and modification time of an asset, identifies its contents without reading them.
+     * Caches derived from an asset store its stamp and compare it to detect that the asset changed.
+     */
+    struct Stamp {
+      uint64_t size;
+      // Modification time of the loose file or of the pack file containing the asset in nanoseconds
+      int64_t modified;
+      // Serial number of the mounted pack containing the asset, 0 for loose files
+      uint32_t pack;
+    };
+
+    /*!
+     * Get stamp of an asset from a mounted pack or of a loose file when no pack contains it.
+     * Compressed pack entries are not inflated. Can be called from any thread.
+     *
+     * @param path - Path of the asset relative to the data directory.
+     * @return - Stamp of the asset, throws when it does not exist.
+     */
+    Stamp stamp(const std::string &path);
+
+    /*!
+     * Open asset from a mounted pack or as a loose file when no pack contains it.
+     * Can be called from any thread.
+     *
+     * @param path - Path of the asset relative to the data directory.
+     * @return - Contents of the asset.
+     */
+    File open(const std::string &path);
+
+    /*!
+     * Writer of asset packs.
+     *
+     * Layout: header, entry blobs aligned to BLOB_ALIGNMENT bytes, entry table sorted by path,
+     * open addressing hash table of entry indices keyed by path hash and the path strings.
+     * Entries are stored raw or zlib compressed.
+     */
+    class Writer {
+    public:
+      /*!
+       * Start writing a pack, entries are added by add and the pack is valid after finish.
+       *
+       * @param pack - File path of the pack to write.
+       */
+      Writer(const std::string &pack);
+
+      /*!
+       * Add entry to the pack.
+       *
+       * @param path - Path of the asset relative to the data directory.
+       * @param data - Contents of the asset.
+       * @param size - Size of the contents in bytes.
+       * @param compress - Store the entry compressed when it saves at least an eighth of the size.
+       */
+      void add(const std::string &path, const char *data, size_t size, bool compress);
+
+      /*!
+       * Write index and header.
+       *
+       * @return - Size of the pack in bytes.
+       */
+      uint64_t finish();
+
+    private:
+      struct Pending {
+        std::string path;
+        uint64_t offset, size, storedSize;
+        uint32_t compression;
+      };
+
+      std::string path;
+      std::ofstream output;
+      std::vector<Pending> entries;
+    };
+
+    const uint32_t BLOB_ALIGNMENT = 16;
+  }
+}
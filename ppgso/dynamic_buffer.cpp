@@ -0,0 +1,107 @@
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include "dynamic_buffer.h"
+#include "gl_state.h"
+
+ppgso::DynamicBuffer::DynamicBuffer(size_t size) : size{size} {
+  glGenBuffers(1, &buffer);
+  gl::bindBuffer(GL_ARRAY_BUFFER, buffer);
+
+  if (GLEW_ARB_buffer_storage) {
+    // Mapped once for the lifetime of the buffer, coherent so writes need no flush
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr) size, nullptr, flags);
+    mapped = (uint8_t *) glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr) size, flags);
+  }
+
+  if (!mapped) {
+    // Storage of glBufferStorage is immutable, start over with a regular buffer
+    if (GLEW_ARB_buffer_storage) {
+      gl::deleteBuffer(buffer);
+      glGenBuffers(1, &buffer);
+      gl::bindBuffer(GL_ARRAY_BUFFER, buffer);
+    }
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) size, nullptr, GL_STREAM_DRAW);
+  }
+}
+
+ppgso::DynamicBuffer::~DynamicBuffer() {
+  for (auto &frame : frames)
+    glDeleteSync(frame.fence);
+  if (mapped) {
+    gl::bindBuffer(GL_ARRAY_BUFFER, buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+  }
+  gl::deleteBuffer(buffer);
+}
+
+bool ppgso::DynamicBuffer::overlaps(const Frame &frame, size_t offset, size_t length) const {
+  auto end = offset + length;
+  if (frame.start <= frame.end)
+    return offset < frame.end && frame.start < end;
+  return end > frame.start || offset < frame.end;
+}
+
+size_t ppgso::DynamicBuffer::upload(const void *data, size_t length, size_t alignment) {
+  auto offset = (head + alignment - 1) / alignment * alignment;
+  bool wrap = offset + length > size;
+  if (wrap) offset = 0;
+
+  // Data of the current frame must not be overwritten before it is drawn
+  auto used = frameUsed + (wrap ? size - head : offset - head) + length;
+  if (length > size || used >= size) {
+    std::stringstream msg;
+    msg << "Dynamic buffer of " << size << " bytes is too small for " << used << " bytes of a single frame";
+    throw std::runtime_error(msg.str());
+  }
+
+  gl::bindBuffer(GL_ARRAY_BUFFER, buffer);
+  if (mapped) {
+    // Wait until the GPU finished the frames that used the region, usually they are long done
+    while (!frames.empty() && overlaps(frames.front(), offset, length)) {
+      glClientWaitSync(frames.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+      glDeleteSync(frames.front().fence);
+      frames.pop_front();
+    }
+    memcpy(mapped + offset, data, length);
+  } else {
+    // Orphaned storage is released by the driver once draws using it are done
+    if (wrap) glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) size, nullptr, GL_STREAM_DRAW);
+    auto target = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr) offset, (GLsizeiptr) length,
+                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (target) {
+      memcpy(target, data, length);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+      glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) offset, (GLsizeiptr) length, data);
+    }
+  }
+
+  frameUsed = used;
+  head = offset + length;
+  return offset;
+}
+
+void ppgso::DynamicBuffer::endFrame() {
+  if (mapped && frameUsed > 0) {
+    frames.push_back({frameStart, head, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+
+    // Forget frames the GPU already finished without waiting
+    while (frames.size() > 1 && glClientWaitSync(frames.front().fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+      glDeleteSync(frames.front().fence);
+      frames.pop_front();
+    }
+  }
+  frameStart = head;
+  frameUsed = 0;
+}
+
+GLuint ppgso::DynamicBuffer::getBuffer() const {
+  return buffer;
+}
+
+bool ppgso::DynamicBuffer::isPersistent() const {
+  return mapped != nullptr;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Ring buffer for vertex data that changes every frame.
+   * Objects copy their data into the ring and point their vertex attributes at the returned offset,
+   * so no OpenGL objects are created while rendering.
+   *
+   * With ARB_buffer_storage the buffer is persistently mapped and regions are reused once the fence of the
+   * frame that wrote them has signaled. Otherwise regions are mapped unsynchronized and the storage is
+   * orphaned whenever the ring wraps around.
+   */
+  class DynamicBuffer {
+  public:
+    /*!
+     * Create buffer.
+     *
+     * @param size - Size of the ring in bytes, should hold the data of about three frames.
+     */
+    DynamicBuffer(size_t size);
+
+    DynamicBuffer(const DynamicBuffer&) = delete;
+    DynamicBuffer& operator=(const DynamicBuffer&) = delete;
+
+    ~DynamicBuffer();
+
+    /*!
+     * Copy data into the ring, the data stays valid until the end of the next frames in flight.
+     *
+     * @param data - Data to copy.
+     * @param size - Number of bytes to copy, at most the size of the ring.
+     * @param alignment - Alignment of the returned offset, does not have to be a power of two.
+     * @return - Offset of the data in the buffer returned by getBuffer.
+     */
+    size_t upload(const void *data, size_t size, size_t alignment = 16);
+
+    /*!
+     * Mark the end of a frame, data uploaded since the previous call is reused once the GPU finished reading it.
+     */
+    void endFrame();
+
+    /*!
+     * Get OpenGL buffer to bind as vertex attribute source.
+     *
+     * @return - OpenGL buffer.
+     */
+    GLuint getBuffer() const;
+
+    /*!
+     * Check whether the buffer is persistently mapped.
+     *
+     * @return - True when ARB_buffer_storage is used.
+     */
+    bool isPersistent() const;
+
+  private:
+    // Region written during a frame, start > end when the frame wrapped around
+    struct Frame {
+      size_t start, end;
+      GLsync fence;
+    };
+
+    bool overlaps(const Frame &frame, size_t offset, size_t length) const;
+
+    GLuint buffer = 0;
+    size_t size;
+    size_t head = 0, frameStart = 0, frameUsed = 0;
+    uint8_t *mapped = nullptr;
+    std::deque<Frame> frames;
+  };
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <iterator>
+
+#include "gl_state.h"
+
+// Value of state that has not been set through this module yet
+static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+// Tracked texture units and targets, bindings outside of these are always issued
+static const int MAX_UNITS = 32;
+static const GLenum TEXTURE_TARGETS[] = {GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_3D};
+static const int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+// Tracked buffer targets and indexed uniform buffer binding points
+static const GLenum BUFFER_TARGETS[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER,
+                                        GL_PIXEL_UNPACK_BUFFER, GL_PIXEL_PACK_BUFFER, GL_COPY_WRITE_BUFFER};
+static const int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+static const int MAX_UNIFORM_BINDINGS = 16;
+
+// Tracked capabilities
+static const GLenum CAPABILITIES[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST};
+static const int CAPABILITY_COUNT = sizeof(CAPABILITIES) / sizeof(CAPABILITIES[0]);
+
+struct State {
+  GLuint program;
+  GLuint vao;
+  GLuint activeUnit;
+  GLuint textures[MAX_UNITS][TEXTURE_TARGET_COUNT];
+  GLuint buffers[BUFFER_TARGET_COUNT];
+  GLuint uniformBindings[MAX_UNIFORM_BINDINGS];
+  GLuint capabilities[CAPABILITY_COUNT];
+  GLenum blendSource, blendDestination;
+  GLenum depthFunction;
+  GLuint depthMask;
+  GLenum cullMode;
+};
+
+// State with every value unknown, so the first call of each kind is always issued
+static State unknownState() {
+  State result;
+  result.program = UNKNOWN;
+  result.vao = UNKNOWN;
+  result.activeUnit = UNKNOWN;
+  for (auto &unit : result.textures)
+    std::fill(std::begin(unit), std::end(unit), UNKNOWN);
+  std::fill(std::begin(result.buffers), std::end(result.buffers), UNKNOWN);
+  std::fill(std::begin(result.uniformBindings), std::end(result.uniformBindings), UNKNOWN);
+  std::fill(std::begin(result.capabilities), std::end(result.capabilities), UNKNOWN);
+  result.blendSource = result.blendDestination = UNKNOWN;
+  result.depthFunction = UNKNOWN;
+  result.depthMask = UNKNOWN;
+  result.cullMode = UNKNOWN;
+  return result;
+}
+
+static State state = unknownState();
+static ppgso::gl::Counters counters;
+
+template<typename T, size_t N>
+static int indexOf(const T (&values)[N], T value) {
+  auto found = std::find(values, values + N, value);
+  return found == values + N ? -1 : (int) (found - values);
+}
+
+// Update tracked value, return true when OpenGL needs to be called
+static bool change(GLuint &tracked, GLuint value) {
+  if (tracked == value) {
+    counters.skipped++;
+    return false;
+  }
+  tracked = value;
+  counters.issued++;
+  return true;
+}
+
+void ppgso::gl::useProgram(GLuint program) {
+  if (change(state.program, program)) glUseProgram(program);
+}
+
+GLuint ppgso::gl::currentProgram() {
+  return state.program == UNKNOWN ? 0 : state.program;
+}
+
+void ppgso::gl::bindVertexArray(GLuint vao) {
+  if (!change(state.vao, vao)) return;
+  glBindVertexArray(vao);
+  state.buffers[indexOf(BUFFER_TARGETS, (GLenum) GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void ppgso::gl::bindBuffer(GLenum target, GLuint buffer) {
+  auto index = indexOf(BUFFER_TARGETS, target);
+  if (index < 0) {
+    counters.issued++;
+    glBindBuffer(target, buffer);
+  } else if (change(state.buffers[index], buffer)) {
+    glBindBuffer(target, buffer);
+  }
+}
+
+void ppgso::gl::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  auto generic = indexOf(BUFFER_TARGETS, target);
+  if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS) {
+    counters.issued++;
+    glBindBufferBase(target, index, buffer);
+    if (generic >= 0) state.buffers[generic] = buffer;
+  } else if (change(state.uniformBindings[index], buffer)) {
+    glBindBufferBase(target, index, buffer);
+    state.buffers[generic] = buffer;
+  }
+}
+
+void ppgso::gl::bindTexture(GLenum target, GLuint unit, GLuint texture) {
+  auto index = indexOf(TEXTURE_TARGETS, target);
+  if (index < 0 || unit >= MAX_UNITS) {
+    counters.issued++;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    state.activeUnit = unit;
+    glBindTexture(target, texture);
+    return;
+  }
+
+  // The unit is activated even when the binding is skipped, texture updates apply to the active unit
+  if (change(state.activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+  if (change(state.textures[unit][index], texture)) glBindTexture(target, texture);
+}
+
+void ppgso::gl::setEnabled(GLenum capability, bool enabled) {
+  auto index = indexOf(CAPABILITIES, capability);
+  if (index >= 0 && !change(state.capabilities[index], enabled)) return;
+  if (index < 0) counters.issued++;
+  if (enabled)
+    glEnable(capability);
+  else
+    glDisable(capability);
+}
+
+void ppgso::gl::blendFunc(GLenum source, GLenum destination) {
+  if (state.blendSource == source && state.blendDestination == destination) {
+    counters.skipped++;
+    return;
+  }
+  counters.issued++;
+  state.blendSource = source;
+  state.blendDestination = destination;
+  glBlendFunc(source, destination);
+}
+
+void ppgso::gl::depthFunc(GLenum function) {
+  if (change(state.depthFunction, function)) glDepthFunc(function);
+}
+
+void ppgso::gl::depthMask(bool enabled) {
+  if (change(state.depthMask, enabled)) glDepthMask((GLboolean) enabled);
+}
+
+void ppgso::gl::cullFace(GLenum mode) {
+  if (change(state.cullMode, mode)) glCullFace(mode);
+}
+
+void ppgso::gl::deleteProgram(GLuint program) {
+  glDeleteProgram(program);
+  if (state.program == program) state.program = UNKNOWN;
+}
+
+void ppgso::gl::deleteVertexArray(GLuint vao) {
+  glDeleteVertexArrays(1, &vao);
+  if (state.vao == vao) state.vao = 0;
+}
+
+void ppgso::gl::deleteBuffer(GLuint buffer) {
+  glDeleteBuffers(1, &buffer);
+  // Deleted buffers are unbound from the generic targets, indexed bindings are unbound too
+  for (auto &bound : state.buffers)
+    if (bound == buffer) bound = 0;
+  for (auto &bound : state.uniformBindings)
+    if (bound == buffer) bound = 0;
+}
+
+void ppgso::gl::deleteTexture(GLuint texture) {
+  glDeleteTextures(1, &texture);
+  for (auto &unit : state.textures)
+    for (auto &bound : unit)
+      if (bound == texture) bound = 0;
+}
+
+void ppgso::gl::invalidate() {
+  state = unknownState();
+}
+
+void ppgso::gl::count(bool issued) {
+  if (issued)
+    counters.issued++;
+  else
+    counters.skipped++;
+}
+
+const ppgso::gl::Counters &ppgso::gl::getCounters() {
+  return counters;
+}
+
+void ppgso::gl::resetCounters() {
+  counters = {};
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <GL/glew.h>
+
+namespace ppgso {
+  /*!
+   * Shadow copy of the OpenGL binding and fixed function state. Calls that would set a value that is
+   * already current are skipped. Shader, Texture, Mesh and UniformBuffer go through these functions,
+   * code that changes the same state with plain OpenGL calls has to call invalidate afterwards.
+   */
+  namespace gl {
+
+    /*!
+     * Number of state changes passed to OpenGL and skipped as redundant since the last resetCounters.
+     */
+    struct Counters {
+      unsigned long issued = 0;
+      unsigned long skipped = 0;
+    };
+
+    /*!
+     * Bind shader program.
+     *
+     * @param program - OpenGL program to use.
+     */
+    void useProgram(GLuint program);
+
+    /*!
+     * Get program bound with useProgram, without querying OpenGL.
+     *
+     * @return - OpenGL program, 0 when none or unknown.
+     */
+    GLuint currentProgram();
+
+    /*!
+     * Bind vertex array object. The element array buffer binding is part of it and becomes unknown.
+     *
+     * @param vao - OpenGL vertex array object.
+     */
+    void bindVertexArray(GLuint vao);
+
+    /*!
+     * Bind buffer to a target such as GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER.
+     *
+     * @param target - Buffer binding target.
+     * @param buffer - OpenGL buffer.
+     */
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    /*!
+     * Bind buffer to an indexed binding point, also binds it to the generic target.
+     *
+     * @param target - Indexed target such as GL_UNIFORM_BUFFER.
+     * @param index - Binding point index.
+     * @param buffer - OpenGL buffer.
+     */
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    /*!
+     * Bind texture to a texture unit, the unit also becomes active.
+     *
+     * @param target - Texture target such as GL_TEXTURE_2D.
+     * @param unit - Texture unit number, 0 for GL_TEXTURE0.
+     * @param texture - OpenGL texture.
+     */
+    void bindTexture(GLenum target, GLuint unit, GLuint texture);
+
+    /*!
+     * Enable or disable a capability such as GL_BLEND, GL_DEPTH_TEST or GL_CULL_FACE.
+     *
+     * @param capability - OpenGL capability.
+     * @param enabled - True to enable.
+     */
+    void setEnabled(GLenum capability, bool enabled);
+
+    /*!
+     * Set blending factors, see glBlendFunc.
+     */
+    void blendFunc(GLenum source, GLenum destination);
+
+    /*!
+     * Set depth comparison, see glDepthFunc.
+     */
+    void depthFunc(GLenum function);
+
+    /*!
+     * Enable or disable writing to the depth buffer, see glDepthMask.
+     */
+    void depthMask(bool enabled);
+
+    /*!
+     * Select faces to cull, see glCullFace.
+     */
+    void cullFace(GLenum mode);
+
+    /*!
+     * Delete objects and forget their bindings, so a new object reusing the name is bound again.
+     *
+     * @param name - OpenGL object name.
+     */
+    void deleteProgram(GLuint program);
+    void deleteVertexArray(GLuint vao);
+    void deleteBuffer(GLuint buffer);
+    void deleteTexture(GLuint texture);
+
+    /*!
+     * Forget all shadowed state, the next call of each function is always passed to OpenGL.
+     * Needed after changing state with plain OpenGL calls or switching contexts.
+     */
+    void invalidate();
+
+    /*!
+     * Count a state change made outside of this module, for example a uniform update skipped by Shader.
+     *
+     * @param issued - True when the call was passed to OpenGL.
+     */
+    void count(bool issued);
+
+    /*!
+     * Get counters of issued and skipped calls.
+     *
+     * @return - Counters since the last reset.
+     */
+    const Counters &getCounters();
+
+    /*!
+     * Reset counters, typically at the start of each frame.
+     */
+    void resetCounters();
+  }
+}
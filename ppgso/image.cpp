@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include "image.h"
 
 uint8_t clamp(float value) {
@@ -13,6 +14,10 @@ std::vector<ppgso::Image::Pixel>& ppgso::Image::getFramebuffer() {
   return framebuffer;
 }
 
+const std::vector<ppgso::Image::Pixel>& ppgso::Image::getFramebuffer() const {
+  return framebuffer;
+}
+
 ppgso::Image::Pixel& ppgso::Image::getPixel(int x, int y) {
   return framebuffer[x+y*width];
 }
@@ -32,3 +37,143 @@ void ppgso::Image::setPixel(int x, int y, int r, int g, int b) {
 void ppgso::Image::setPixel(int x, int y, float r, float g, float b) {
   setPixel(x,y,{clamp(r), clamp(g), clamp(b)});
 }
+
+namespace {
+  const float PI = 3.14159265358979f;
+  const float LANCZOS_RADIUS = 3.0f;
+
+  float lanczos(float x) {
+    if (x == 0.0f) return 1.0f;
+    if (std::abs(x) >= LANCZOS_RADIUS) return 0.0f;
+    return LANCZOS_RADIUS * std::sin(PI * x) * std::sin(PI * x / LANCZOS_RADIUS) / (PI * PI * x * x);
+  }
+
+  // Source pixels and normalized weights contributing to one destination pixel
+  struct Contribution {
+    int start;
+    std::vector<float> weights;
+  };
+
+  std::vector<Contribution> lanczosWeights(int srcSize, int dstSize) {
+    std::vector<Contribution> contributions((size_t) dstSize);
+    float scale = (float) srcSize / (float) dstSize;
+    // Widen the filter when minifying so it also acts as a low-pass filter
+    float filterScale = std::max(scale, 1.0f);
+    float support = LANCZOS_RADIUS * filterScale;
+
+    for (int i = 0; i < dstSize; ++i) {
+      float center = ((float) i + 0.5f) * scale;
+      int start = std::max((int) std::floor(center - support), 0);
+      int end = std::min((int) std::ceil(center + support), srcSize);
+
+      auto &contribution = contributions[i];
+      contribution.start = start;
+      float sum = 0.0f;
+      for (int j = start; j < end; ++j) {
+        float weight = lanczos(((float) j + 0.5f - center) / filterScale);
+        contribution.weights.push_back(weight);
+        sum += weight;
+      }
+      for (auto &weight : contribution.weights) weight /= sum;
+    }
+    return contributions;
+  }
+}
+
+ppgso::Image ppgso::Image::downsample() const {
+  Image result{std::max(1, width / 2), std::max(1, height / 2)};
+  downsample(result, 0, 0, width, height);
+  return result;
+}
+
+void ppgso::Image::downsample(Image &destination, int x, int y, int width, int height) const {
+  // Destination texels that depend on the changed region
+  int x0 = x / 2, y0 = y / 2;
+  int x1 = std::min((x + width + 1) / 2, destination.width);
+  int y1 = std::min((y + height + 1) / 2, destination.height);
+
+  auto src = reinterpret_cast<const uint8_t *>(framebuffer.data());
+  auto dst = reinterpret_cast<uint8_t *>(destination.framebuffer.data());
+  int srcStride = this->width * 3;
+  int dstStride = destination.width * 3;
+  int maxX = this->width - 1, maxY = this->height - 1;
+
+  #pragma omp parallel for
+  for (int j = y0; j < y1; ++j) {
+    auto row0 = src + std::min(2 * j, maxY) * srcStride;
+    auto row1 = src + std::min(2 * j + 1, maxY) * srcStride;
+    auto out = dst + j * dstStride;
+
+    #pragma omp simd
+    for (int i = x0 * 3; i < x1 * 3; ++i) {
+      int pixel = i / 3, channel = i % 3;
+      int left = std::min(2 * pixel, maxX) * 3 + channel;
+      int right = std::min(2 * pixel + 1, maxX) * 3 + channel;
+      out[i] = (uint8_t) ((row0[left] + row0[right] + row1[left] + row1[right] + 2) / 4);
+    }
+  }
+}
+
+ppgso::Image ppgso::Image::resize(int width, int height) const {
+  auto horizontal = lanczosWeights(this->width, width);
+  auto vertical = lanczosWeights(this->height, height);
+
+  // Horizontal pass into a float buffer with source height and destination width
+  std::vector<float> temporary((size_t) (this->height * width * 3));
+  auto src = reinterpret_cast<const uint8_t *>(framebuffer.data());
+
+  #pragma omp parallel for
+  for (int y = 0; y < this->height; ++y) {
+    auto row = src + y * this->width * 3;
+    auto out = temporary.data() + y * width * 3;
+    for (int x = 0; x < width; ++x) {
+      auto &contribution = horizontal[x];
+      float r = 0, g = 0, b = 0;
+      for (size_t k = 0; k < contribution.weights.size(); ++k) {
+        auto pixel = row + (contribution.start + k) * 3;
+        float weight = contribution.weights[k];
+        r += weight * pixel[0];
+        g += weight * pixel[1];
+        b += weight * pixel[2];
+      }
+      out[x * 3 + 0] = r;
+      out[x * 3 + 1] = g;
+      out[x * 3 + 2] = b;
+    }
+  }
+
+  // Vertical pass, whole rows are accumulated at once which vectorizes well
+  Image result{width, height};
+  auto dst = reinterpret_cast<uint8_t *>(result.framebuffer.data());
+  int stride = width * 3;
+
+  #pragma omp parallel for
+  for (int y = 0; y < height; ++y) {
+    auto &contribution = vertical[y];
+    std::vector<float> accumulator((size_t) stride, 0.0f);
+    auto acc = accumulator.data();
+    for (size_t k = 0; k < contribution.weights.size(); ++k) {
+      auto row = temporary.data() + (contribution.start + k) * stride;
+      float weight = contribution.weights[k];
+      #pragma omp simd
+      for (int i = 0; i < stride; ++i)
+        acc[i] += weight * row[i];
+    }
+    auto out = dst + y * stride;
+    #pragma omp simd
+    for (int i = 0; i < stride; ++i)
+      out[i] = (uint8_t) std::min(std::max(acc[i] + 0.5f, 0.0f), 255.0f);
+  }
+
+  return result;
+}
+
+std::vector<ppgso::Image> ppgso::Image::generateMipmaps(int levels) const {
+  std::vector<Image> mipmaps;
+  const Image *previous = this;
+  while ((previous->width > 1 || previous->height > 1) && (levels == 0 || (int) mipmaps.size() < levels)) {
+    mipmaps.push_back(previous->downsample());
+    previous = &mipmaps.back();
+  }
+  return mipmaps;
+}
@@ -26,6 +26,7 @@ namespace ppgso {
      * @return - Pointer to the raw RGB framebuffer data.
      */
     std::vector<Pixel>& getFramebuffer();
+    const std::vector<Pixel>& getFramebuffer() const;
 
     /*!
      * Get single pixel from the framebuffer.
@@ -70,6 +71,42 @@ namespace ppgso {
      */
     void clear(const Pixel& color = {0,0,0});
 
+    /*!
+     * Create a half resolution copy of the image using a 2x2 box filter.
+     * Odd sizes are rounded down, the last row/column is clamped.
+     *
+     * @return - Downsampled image of size max(1, width/2) x max(1, height/2).
+     */
+    Image downsample() const;
+
+    /*!
+     * Recompute only the part of a half resolution image that depends on the given region of this image.
+     *
+     * @param destination - Image previously created by downsample(), updated in place.
+     * @param x - Horizontal start of the changed region in this image.
+     * @param y - Vertical start of the changed region in this image.
+     * @param width - Width of the changed region.
+     * @param height - Height of the changed region.
+     */
+    void downsample(Image &destination, int x, int y, int width, int height) const;
+
+    /*!
+     * Resample the image to arbitrary size using a separable Lanczos-3 filter.
+     *
+     * @param width - New width in pixels.
+     * @param height - New height in pixels.
+     * @return - Resized image.
+     */
+    Image resize(int width, int height) const;
+
+    /*!
+     * Generate a chain of mipmaps, each level half the size of the previous one.
+     *
+     * @param levels - Number of levels to generate (not including this image), 0 generates the full chain down to 1x1.
+     * @return - Mipmap levels 1..n
+     */
+    std::vector<Image> generateMipmaps(int levels = 0) const;
+
     int width, height;
   private:
     std::vector<Pixel> framebuffer;
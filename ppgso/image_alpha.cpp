@@ -13,6 +13,10 @@ std::vector<ppgso::ImageAlpha::Pixel>& ppgso::ImageAlpha::getFramebuffer() {
     return framebuffer;
 }
 
+const std::vector<ppgso::ImageAlpha::Pixel>& ppgso::ImageAlpha::getFramebuffer() const {
+    return framebuffer;
+}
+
 ppgso::ImageAlpha::Pixel& ppgso::ImageAlpha::getPixel(int x, int y) {
     return framebuffer[x + y * width];
 }
@@ -32,3 +36,38 @@ void ppgso::ImageAlpha::setPixel(int x, int y, int r, int g, int b, int a) {
 void ppgso::ImageAlpha::setPixel(int x, int y, float r, float g, float b, float a) {
     setPixel(x, y,{clamp(r), clamp(g), clamp(b), clamp(a)});
 }
+
+ppgso::ImageAlpha ppgso::ImageAlpha::downsample() const {
+    ImageAlpha result{std::max(1, width / 2), std::max(1, height / 2)};
+    auto src = reinterpret_cast<const uint8_t *>(framebuffer.data());
+    auto dst = reinterpret_cast<uint8_t *>(result.framebuffer.data());
+    int srcStride = width * 4;
+    int dstStride = result.width * 4;
+    int maxX = width - 1, maxY = height - 1;
+
+    #pragma omp parallel for
+    for (int j = 0; j < result.height; ++j) {
+        auto row0 = src + std::min(2 * j, maxY) * srcStride;
+        auto row1 = src + std::min(2 * j + 1, maxY) * srcStride;
+        auto out = dst + j * dstStride;
+
+        #pragma omp simd
+        for (int i = 0; i < result.width * 4; ++i) {
+            int pixel = i / 4, channel = i % 4;
+            int left = std::min(2 * pixel, maxX) * 4 + channel;
+            int right = std::min(2 * pixel + 1, maxX) * 4 + channel;
+            out[i] = (uint8_t) ((row0[left] + row0[right] + row1[left] + row1[right] + 2) / 4);
+        }
+    }
+    return result;
+}
+
+std::vector<ppgso::ImageAlpha> ppgso::ImageAlpha::generateMipmaps(int levels) const {
+    std::vector<ImageAlpha> mipmaps;
+    const ImageAlpha *previous = this;
+    while ((previous->width > 1 || previous->height > 1) && (levels == 0 || (int) mipmaps.size() < levels)) {
+        mipmaps.push_back(previous->downsample());
+        previous = &mipmaps.back();
+    }
+    return mipmaps;
+}
@@ -28,6 +28,7 @@ namespace ppgso {
          * @return - Pointer to the raw RGBA framebuffer data.
          */
         std::vector<Pixel>& getFramebuffer();
+        const std::vector<Pixel>& getFramebuffer() const;
 
         /*!
          * Get single pixel from the framebuffer.
@@ -74,6 +75,22 @@ namespace ppgso {
          */
         void clear(const Pixel& color = {0, 0, 0, 0});
 
+        /*!
+         * Create a half resolution copy of the image using a 2x2 box filter.
+         * Odd sizes are rounded down, the last row/column is clamped.
+         *
+         * @return - Downsampled image of size max(1, width/2) x max(1, height/2).
+         */
+        ImageAlpha downsample() const;
+
+        /*!
+         * Generate a chain of mipmaps, each level half the size of the previous one.
+         *
+         * @param levels - Number of levels to generate (not including this image), 0 generates the full chain down to 1x1.
+         * @return - Mipmap levels 1..n
+         */
+        std::vector<ImageAlpha> generateMipmaps(int levels = 0) const;
+
         int width, height;
     private:
         std::vector<Pixel> framebuffer;
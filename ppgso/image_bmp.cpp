@@ -1,7 +1,9 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
 #include "image_bmp.h"
+#include "asset_pack.h"
 
 namespace ppgso {
   namespace image {
@@ -37,17 +39,24 @@ namespace ppgso {
       BITMAPFILEHEADER bmpFileHeader = {};
       BITMAPINFOHEADER bmpInfoHeader = {};
 
-      std::ifstream input_file(bmp, std::ios::binary);
+      std::unique_ptr<pack::File> input_file;
+      try {
+        input_file = std::make_unique<pack::File>(pack::open(bmp));
+      } catch (std::runtime_error &) {
+        std::stringstream msg;
+        msg << "Could not open BMP file. " << bmp;
+        throw std::runtime_error(msg.str());
+      }
 
       // Check headers
-      if (!input_file.is_open()) {
+      if (input_file->size() < sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER)) {
         std::stringstream msg;
-        msg << "Could not open BMP file. " << bmp;
+        msg << "BMP file is truncated. " << bmp;
         throw std::runtime_error(msg.str());
       }
 
-      input_file.read((char *) &bmpFileHeader, sizeof(BITMAPFILEHEADER));
-      input_file.read((char *) &bmpInfoHeader, sizeof(BITMAPINFOHEADER));
+      memcpy(&bmpFileHeader, input_file->data(), sizeof(BITMAPFILEHEADER));
+      memcpy(&bmpInfoHeader, input_file->data() + sizeof(BITMAPFILEHEADER), sizeof(BITMAPINFOHEADER));
 
       if (bmpFileHeader.bfType != 19778) {
         std::stringstream msg;
@@ -80,15 +89,20 @@ namespace ppgso {
       Image image{width, height};
       auto &framebuffer = image.getFramebuffer();
 
-      // Load data
-      input_file.seekg(bmpFileHeader.bfOffBits, input_file.beg);
-
       // BMP uses padding for rows
       unsigned int row_padded = (width * sizeof(Image::Pixel) + 3) & (~3);
 
+      if ((uint64_t) bmpFileHeader.bfOffBits + (uint64_t) row_padded * height > input_file->size()) {
+        std::stringstream msg;
+        msg << "BMP file is truncated. " << bmp;
+        throw std::runtime_error(msg.str());
+      }
+
+      // Load data
+      auto data = input_file->data() + bmpFileHeader.bfOffBits;
+
       for (int j = 0; j < height; j++) {
-        auto row_data = std::vector<Image::Pixel>(row_padded);
-        input_file.read((char *) row_data.data(), row_padded);
+        auto row_data = reinterpret_cast<const Image::Pixel *>(data + (size_t) j * row_padded);
         for (int i = 0; i < width; i++) {
           auto pixel = row_data[i];
           std::swap(pixel.r, pixel.b);
@@ -99,7 +113,6 @@ namespace ppgso {
           }
         }
       }
-      input_file.close();
 
       return image;
     }
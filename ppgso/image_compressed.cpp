@@ -0,0 +1,547 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "image_compressed.h"
+#include "image_bmp.h"
+#include "image_png.h"
+
+namespace ppgso {
+
+  namespace {
+    const char CONTAINER_MAGIC[4] = {'P', 'P', 'B', 'C'};
+    const uint32_t CONTAINER_VERSION = 1;
+    // Levels are aligned so they can be uploaded straight from the mapping
+    const uint64_t CONTAINER_ALIGNMENT = 16;
+    // Iterations used to find the principal axis of the block colors
+    const int POWER_ITERATIONS = 8;
+
+    struct ContainerHeader {
+      char magic[4];
+      uint32_t version;
+      uint32_t format, width, height, levelCount;
+      uint64_t sourceSize;
+      int64_t sourceModified;
+      uint64_t fileSize;
+    };
+
+    struct ContainerLevel {
+      uint32_t width, height;
+      uint64_t offset, size;
+    };
+
+    uint64_t align(uint64_t offset) {
+      return (offset + CONTAINER_ALIGNMENT - 1) / CONTAINER_ALIGNMENT * CONTAINER_ALIGNMENT;
+    }
+
+    // 4x4 texels of a block, channels are stored separately so loops over texels vectorize
+    struct Block {
+      float r[16], g[16], b[16], a[16];
+    };
+
+    int blocks(int size) {
+      return std::max(1, (size + 3) / 4);
+    }
+
+    size_t levelSize(CompressedImage::Format format, int width, int height) {
+      return (size_t) blocks(width) * blocks(height) * CompressedImage::blockSize(format);
+    }
+
+    uint8_t alpha(const Image::Pixel &) {
+      return 255;
+    }
+
+    uint8_t alpha(const ImageAlpha::Pixel &pixel) {
+      return pixel.a;
+    }
+
+    // Texels outside of the image repeat the last row and column
+    template<typename Pixel>
+    void gather(const std::vector<Pixel> &pixels, int width, int height, int bx, int by, Block &block) {
+      for (int y = 0; y < 4; y++) {
+        auto row = pixels.data() + std::min(by * 4 + y, height - 1) * width;
+        for (int x = 0; x < 4; x++) {
+          auto &pixel = row[std::min(bx * 4 + x, width - 1)];
+          block.r[y * 4 + x] = pixel.r;
+          block.g[y * 4 + x] = pixel.g;
+          block.b[y * 4 + x] = pixel.b;
+          block.a[y * 4 + x] = alpha(pixel);
+        }
+      }
+    }
+
+    uint16_t pack565(float r, float g, float b) {
+      auto quantize = [](float value, int max) {
+        return std::min(max, std::max(0, (int) (value * max / 255.0f + 0.5f)));
+      };
+      return (uint16_t) (quantize(r, 31) << 11 | quantize(g, 63) << 5 | quantize(b, 31));
+    }
+
+    void unpack565(uint16_t color, int rgb[3]) {
+      int r = color >> 11 & 31, g = color >> 5 & 63, b = color & 31;
+      rgb[0] = r << 3 | r >> 2;
+      rgb[1] = g << 2 | g >> 4;
+      rgb[2] = b << 3 | b >> 2;
+    }
+
+    void write16(uint8_t *out, uint16_t value) {
+      out[0] = (uint8_t) value;
+      out[1] = (uint8_t) (value >> 8);
+    }
+
+    /*!
+     * Encode colors of a block as a BC1 color block of 8 bytes.
+     * Endpoints lie on the principal axis of the colors, inset by 1/16 of their distance to reduce the error.
+     */
+    void encodeColor(const Block &block, uint8_t *out) {
+      float mr = 0, mg = 0, mb = 0;
+      #pragma omp simd reduction(+:mr, mg, mb)
+      for (int i = 0; i < 16; i++) {
+        mr += block.r[i];
+        mg += block.g[i];
+        mb += block.b[i];
+      }
+      mr /= 16;
+      mg /= 16;
+      mb /= 16;
+
+      float rr = 0, rg = 0, rb = 0, gg = 0, gb = 0, bb = 0;
+      #pragma omp simd reduction(+:rr, rg, rb, gg, gb, bb)
+      for (int i = 0; i < 16; i++) {
+        float r = block.r[i] - mr, g = block.g[i] - mg, b = block.b[i] - mb;
+        rr += r * r;
+        rg += r * g;
+        rb += r * b;
+        gg += g * g;
+        gb += g * b;
+        bb += b * b;
+      }
+
+      // Power iteration converges to the eigenvector with the largest eigenvalue
+      float ar = 1, ag = 1, ab = 1;
+      for (int i = 0; i < POWER_ITERATIONS; i++) {
+        float r = ar * rr + ag * rg + ab * rb;
+        float g = ar * rg + ag * gg + ab * gb;
+        float b = ar * rb + ag * gb + ab * bb;
+        float length = std::max(std::fabs(r), std::max(std::fabs(g), std::fabs(b)));
+        if (length < 1e-6f) break;
+        ar = r / length;
+        ag = g / length;
+        ab = b / length;
+      }
+      float length = std::sqrt(ar * ar + ag * ag + ab * ab);
+      ar /= length;
+      ag /= length;
+      ab /= length;
+
+      float low = 0, high = 0;
+      #pragma omp simd reduction(min:low) reduction(max:high)
+      for (int i = 0; i < 16; i++) {
+        float t = (block.r[i] - mr) * ar + (block.g[i] - mg) * ag + (block.b[i] - mb) * ab;
+        low = std::min(low, t);
+        high = std::max(high, t);
+      }
+      float inset = (high - low) / 16;
+      low += inset;
+      high -= inset;
+
+      auto c0 = pack565(mr + ar * high, mg + ag * high, mb + ab * high);
+      auto c1 = pack565(mr + ar * low, mg + ag * low, mb + ab * low);
+      // Four color mode requires c0 > c1, swapping the endpoints mirrors the indices
+      if (c0 < c1) std::swap(c0, c1);
+      write16(out, c0);
+      write16(out + 2, c1);
+
+      uint32_t indices = 0;
+      if (c0 != c1) {
+        int p0[3], p1[3];
+        unpack565(c0, p0);
+        unpack565(c1, p1);
+        float palette[4][3];
+        for (int c = 0; c < 3; c++) {
+          palette[0][c] = (float) p0[c];
+          palette[1][c] = (float) p1[c];
+          palette[2][c] = (2.0f * p0[c] + p1[c]) / 3.0f;
+          palette[3][c] = (p0[c] + 2.0f * p1[c]) / 3.0f;
+        }
+
+        int selected[16];
+        #pragma omp simd
+        for (int i = 0; i < 16; i++) {
+          float best = 1e30f;
+          int index = 0;
+          for (int p = 0; p < 4; p++) {
+            float r = block.r[i] - palette[p][0], g = block.g[i] - palette[p][1], b = block.b[i] - palette[p][2];
+            float distance = r * r + g * g + b * b;
+            if (distance < best) {
+              best = distance;
+              index = p;
+            }
+          }
+          selected[i] = index;
+        }
+        for (int i = 0; i < 16; i++)
+          indices |= (uint32_t) selected[i] << (2 * i);
+      }
+      for (int i = 0; i < 4; i++)
+        out[4 + i] = (uint8_t) (indices >> (8 * i));
+    }
+
+    /*!
+     * Encode alpha of a block as a BC3 alpha block of 8 bytes using the eight value mode.
+     */
+    void encodeAlpha(const Block &block, uint8_t *out) {
+      float low = 255, high = 0;
+      #pragma omp simd reduction(min:low) reduction(max:high)
+      for (int i = 0; i < 16; i++) {
+        low = std::min(low, block.a[i]);
+        high = std::max(high, block.a[i]);
+      }
+      auto a0 = (int) high, a1 = (int) low;
+      out[0] = (uint8_t) a0;
+      out[1] = (uint8_t) a1;
+
+      uint64_t indices = 0;
+      if (a0 != a1) {
+        float palette[8] = {(float) a0, (float) a1};
+        for (int p = 1; p < 7; p++)
+          palette[p + 1] = ((7 - p) * a0 + p * a1) / 7.0f;
+
+        int selected[16];
+        #pragma omp simd
+        for (int i = 0; i < 16; i++) {
+          float best = 1e30f;
+          int index = 0;
+          for (int p = 0; p < 8; p++) {
+            float distance = std::fabs(block.a[i] - palette[p]);
+            if (distance < best) {
+              best = distance;
+              index = p;
+            }
+          }
+          selected[i] = index;
+        }
+        for (int i = 0; i < 16; i++)
+          indices |= (uint64_t) selected[i] << (3 * i);
+      }
+      for (int i = 0; i < 6; i++)
+        out[2 + i] = (uint8_t) (indices >> (8 * i));
+    }
+
+    template<typename Pixel>
+    void compressLevel(const std::vector<Pixel> &pixels, int width, int height, CompressedImage::Format format,
+                       uint8_t *out) {
+      int blocksX = blocks(width), blocksY = blocks(height);
+      auto size = CompressedImage::blockSize(format);
+
+      #pragma omp parallel for
+      for (int by = 0; by < blocksY; by++) {
+        Block block;
+        for (int bx = 0; bx < blocksX; bx++) {
+          gather(pixels, width, height, bx, by, block);
+          auto target = out + ((size_t) by * blocksX + bx) * size;
+          if (format == CompressedImage::Format::BC3) {
+            encodeAlpha(block, target);
+            target += 8;
+          }
+          encodeColor(block, target);
+        }
+      }
+    }
+
+    template<typename T>
+    CompressedImage compress(const T &image, CompressedImage::Format format) {
+      auto mipmaps = image.generateMipmaps();
+      std::vector<const T *> chain{&image};
+      for (auto &mipmap : mipmaps) chain.push_back(&mipmap);
+
+      CompressedImage result;
+      result.format = format;
+      result.width = image.width;
+      result.height = image.height;
+
+      std::vector<size_t> offsets;
+      size_t total = 0;
+      for (auto level : chain) {
+        offsets.push_back(total);
+        total += levelSize(format, level->width, level->height);
+      }
+      result.storage.resize(total);
+
+      for (size_t i = 0; i < chain.size(); i++) {
+        auto level = chain[i];
+        auto data = result.storage.data() + offsets[i];
+        compressLevel(level->getFramebuffer(), level->width, level->height, format, data);
+        result.levels.push_back({level->width, level->height, data, levelSize(format, level->width, level->height)});
+      }
+      return result;
+    }
+
+    // Decode one block into RGBA8 texels
+    void decodeBlock(const uint8_t *in, CompressedImage::Format format, uint8_t texels[16][4]) {
+      uint8_t alphas[16];
+      if (format == CompressedImage::Format::BC3) {
+        int a0 = in[0], a1 = in[1];
+        int palette[8] = {a0, a1};
+        for (int p = 1; p < 7; p++)
+          palette[p + 1] = a0 > a1 ? ((7 - p) * a0 + p * a1) / 7 : 0;
+        if (a0 <= a1) {
+          for (int p = 1; p < 5; p++)
+            palette[p + 1] = ((5 - p) * a0 + p * a1) / 5;
+          palette[6] = 0;
+          palette[7] = 255;
+        }
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++)
+          indices |= (uint64_t) in[2 + i] << (8 * i);
+        for (int i = 0; i < 16; i++)
+          alphas[i] = (uint8_t) palette[indices >> (3 * i) & 7];
+        in += 8;
+      } else {
+        std::fill(alphas, alphas + 16, 255);
+      }
+
+      auto c0 = (uint16_t) (in[0] | in[1] << 8);
+      auto c1 = (uint16_t) (in[2] | in[3] << 8);
+      int palette[4][4];
+      unpack565(c0, palette[0]);
+      unpack565(c1, palette[1]);
+      palette[0][3] = palette[1][3] = palette[2][3] = 255;
+      bool fourColors = c0 > c1 || format == CompressedImage::Format::BC3;
+      for (int c = 0; c < 3; c++) {
+        palette[2][c] = fourColors ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+        palette[3][c] = fourColors ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+      }
+      palette[3][3] = fourColors ? 255 : 0;
+
+      uint32_t indices = in[4] | in[5] << 8 | in[6] << 16 | (uint32_t) in[7] << 24;
+      for (int i = 0; i < 16; i++) {
+        auto &color = palette[indices >> (2 * i) & 3];
+        texels[i][0] = (uint8_t) color[0];
+        texels[i][1] = (uint8_t) color[1];
+        texels[i][2] = (uint8_t) color[2];
+        texels[i][3] = (uint8_t) std::min<int>(color[3], alphas[i]);
+      }
+    }
+
+    template<typename Compress>
+    CompressedImage loadOrCompress(const std::string &source, Compress compress) {
+      auto start = std::chrono::steady_clock::now();
+
+      // Stale containers are detected by the size and modification time of the source without reading it,
+      // a container without its source is used as is
+      pack::Stamp stamp = {0, 0, 0};
+      auto hasSource = pack::exists(source);
+      if (hasSource) stamp = pack::stamp(source);
+
+      auto path = image::compressedPath(source);
+      std::stringstream msg;
+      if (auto cached = image::loadCompressed(path, hasSource ? &stamp : nullptr)) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        msg << "Loaded " << path << " in " << elapsed.count() << " ms" << std::endl;
+        std::cout << msg.str();
+        return std::move(*cached);
+      }
+
+      auto result = compress();
+
+      // The container is only an optimization, read-only data directories are fine
+      try {
+        image::saveCompressed(result, stamp, path);
+      } catch (std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+      }
+
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      msg << "Compressed " << source << " in " << elapsed.count() << " ms" << std::endl;
+      std::cout << msg.str();
+      return result;
+    }
+  }
+
+  size_t CompressedImage::blockSize(Format format) {
+    return format == Format::BC3 ? 16 : 8;
+  }
+
+  size_t CompressedImage::getSize() const {
+    size_t size = 0;
+    for (auto &level : levels) size += level.size;
+    return size;
+  }
+
+  std::vector<uint8_t> CompressedImage::decode(size_t index) const {
+    auto &level = levels.at(index);
+    std::vector<uint8_t> pixels((size_t) level.width * level.height * 4);
+    int blocksX = blocks(level.width), blocksY = blocks(level.height);
+    auto size = blockSize(format);
+
+    #pragma omp parallel for
+    for (int by = 0; by < blocksY; by++) {
+      uint8_t texels[16][4];
+      for (int bx = 0; bx < blocksX; bx++) {
+        decodeBlock(level.data + ((size_t) by * blocksX + bx) * size, format, texels);
+        for (int y = 0; y < 4 && by * 4 + y < level.height; y++) {
+          for (int x = 0; x < 4 && bx * 4 + x < level.width; x++)
+            memcpy(&pixels[((size_t) (by * 4 + y) * level.width + bx * 4 + x) * 4], texels[y * 4 + x], 4);
+        }
+      }
+    }
+    return pixels;
+  }
+
+  namespace image {
+
+    CompressedImage compressBC1(const Image &image) {
+      return compress(image, CompressedImage::Format::BC1);
+    }
+
+    CompressedImage compressBC3(const ImageAlpha &image) {
+      return compress(image, CompressedImage::Format::BC3);
+    }
+
+    CompressedImage mipTail(const CompressedImage &image, int size) {
+      if (image.levels.empty()) throw std::runtime_error("Compressed image has no levels");
+
+      auto first = image.levels.size() - 1;
+      while (first > 0 && image.levels[first - 1].width <= size && image.levels[first - 1].height <= size)
+        first--;
+
+      CompressedImage result;
+      result.format = image.format;
+      result.width = image.levels[first].width;
+      result.height = image.levels[first].height;
+
+      size_t total = 0;
+      for (auto i = first; i < image.levels.size(); i++) total += image.levels[i].size;
+      result.storage.resize(total);
+
+      size_t offset = 0;
+      for (auto i = first; i < image.levels.size(); i++) {
+        auto &level = image.levels[i];
+        auto data = result.storage.data() + offset;
+        memcpy(data, level.data, level.size);
+        result.levels.push_back({level.width, level.height, data, level.size});
+        offset += level.size;
+      }
+      return result;
+    }
+
+    void saveCompressed(const CompressedImage &image, const pack::Stamp &source, const std::string &path) {
+      ContainerHeader header = {};
+      memcpy(header.magic, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+      header.version = CONTAINER_VERSION;
+      header.format = (uint32_t) image.format;
+      header.width = (uint32_t) image.width;
+      header.height = (uint32_t) image.height;
+      header.levelCount = (uint32_t) image.levels.size();
+      header.sourceSize = source.size;
+      header.sourceModified = source.modified;
+
+      std::vector<ContainerLevel> table;
+      auto offset = align(sizeof(ContainerHeader) + image.levels.size() * sizeof(ContainerLevel));
+      for (auto &level : image.levels) {
+        table.push_back({(uint32_t) level.width, (uint32_t) level.height, offset, level.size});
+        offset = align(offset + level.size);
+      }
+      header.fileSize = table.empty() ? offset : table.back().offset + table.back().size;
+
+      // Write to a temporary file first so a partially written container is never picked up
+      auto temporary = path + ".tmp";
+      std::ofstream output_file(temporary, std::ios::binary);
+      if (!output_file.is_open()) {
+        std::stringstream msg;
+        msg << "Could not open compressed image for writing. " << path;
+        throw std::runtime_error(msg.str());
+      }
+
+      std::vector<char> padding(CONTAINER_ALIGNMENT, 0);
+      output_file.write((const char *) &header, sizeof(ContainerHeader));
+      output_file.write((const char *) table.data(), table.size() * sizeof(ContainerLevel));
+      for (size_t i = 0; i < table.size(); i++) {
+        output_file.write(padding.data(), table[i].offset - (uint64_t) output_file.tellp());
+        output_file.write((const char *) image.levels[i].data, image.levels[i].size);
+      }
+      output_file.close();
+
+      if (!output_file) {
+        std::remove(temporary.c_str());
+        std::stringstream msg;
+        msg << "Could not write compressed image. " << path;
+        throw std::runtime_error(msg.str());
+      }
+
+      std::remove(path.c_str());
+      if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        std::stringstream msg;
+        msg << "Could not replace compressed image. " << path;
+        throw std::runtime_error(msg.str());
+      }
+    }
+
+    std::unique_ptr<CompressedImage> loadCompressed(const std::string &path, const pack::Stamp *source) {
+      if (!pack::exists(path)) return nullptr;
+
+      // A pack is built from the source and its container together, so a container next to its source is current
+      auto trusted = !source || (source->pack != 0 && pack::stamp(path).pack == source->pack);
+
+      auto image = std::make_unique<CompressedImage>();
+      try {
+        image->file = std::make_unique<pack::File>(pack::open(path));
+      } catch (std::runtime_error &) {
+        return nullptr;
+      }
+
+      // Reject containers from other versions, other sources or truncated files
+      auto &file = *image->file;
+      if (file.size() < sizeof(ContainerHeader)) return nullptr;
+      ContainerHeader header;
+      memcpy(&header, file.data(), sizeof(ContainerHeader));
+      auto format = (CompressedImage::Format) header.format;
+      if (memcmp(header.magic, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0 ||
+          header.version != CONTAINER_VERSION ||
+          (format != CompressedImage::Format::BC1 && format != CompressedImage::Format::BC3) ||
+          header.width == 0 || header.height == 0 || header.levelCount == 0 ||
+          header.fileSize != file.size() ||
+          sizeof(ContainerHeader) + (uint64_t) header.levelCount * sizeof(ContainerLevel) > file.size() ||
+          (!trusted && (header.sourceSize != source->size || header.sourceModified != source->modified)))
+        return nullptr;
+
+      image->format = format;
+      image->width = (int) header.width;
+      image->height = (int) header.height;
+
+      // Levels must lie within the file and match the size of their blocks
+      auto table = reinterpret_cast<const ContainerLevel *>(file.data() + sizeof(ContainerHeader));
+      for (uint32_t i = 0; i < header.levelCount; i++) {
+        ContainerLevel level;
+        memcpy(&level, &table[i], sizeof(ContainerLevel));
+        if (level.width == 0 || level.height == 0 ||
+            level.size != levelSize(format, (int) level.width, (int) level.height) ||
+            level.offset + level.size > file.size())
+          return nullptr;
+        image->levels.push_back({(int) level.width, (int) level.height,
+                                 reinterpret_cast<const uint8_t *>(file.data() + level.offset), (size_t) level.size});
+      }
+      return image;
+    }
+
+    std::string compressedPath(const std::string &image) {
+      return image + ".ctex";
+    }
+
+    CompressedImage loadCompressedBMP(const std::string &bmp) {
+      return loadOrCompress(bmp, [&bmp] { return compressBC1(loadBMP(bmp)); });
+    }
+
+    CompressedImage loadCompressedPNG(const std::string &png) {
+      return loadOrCompress(png, [&png] { return compressBC3(loadPNG(png)); });
+    }
+  }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "image.h"
+#include "image_alpha.h"
+#include "asset_pack.h"
+
+namespace ppgso {
+
+  /*!
+   * Block compressed image with all mipmap levels, ready for glCompressedTexSubImage2D.
+   * BC1 (DXT1) stores 4x4 RGB texels in 8 bytes, BC3 (DXT5) stores 4x4 RGBA texels in 16 bytes.
+   * Levels point either into storage (freshly encoded) or into file (loaded from a container).
+   */
+  struct CompressedImage {
+    enum class Format : uint32_t {
+      BC1 = 1,
+      BC3 = 3
+    };
+
+    struct Level {
+      int width, height;
+      const uint8_t *data;
+      size_t size;
+    };
+
+    Format format = Format::BC1;
+    int width = 0, height = 0;
+    std::vector<Level> levels;
+    std::vector<uint8_t> storage;
+    std::unique_ptr<pack::File> file;
+
+    /*!
+     * Get size of a 4x4 block.
+     *
+     * @param format - Compression format.
+     * @return - Size of the block in bytes.
+     */
+    static size_t blockSize(Format format);
+
+    /*!
+     * Get size of all levels.
+     *
+     * @return - Size in bytes.
+     */
+    size_t getSize() const;
+
+    /*!
+     * Decode level back to pixels, used when the GPU does not support S3TC.
+     *
+     * @param level - Index of the mipmap level.
+     * @return - RGBA8 pixels of the level, rows from top to bottom.
+     */
+    std::vector<uint8_t> decode(size_t level) const;
+  };
+
+  namespace image {
+    /*!
+     * Compress image and its full mipmap chain to BC1.
+     * Blocks are encoded in parallel, endpoints follow the principal axis of the block colors.
+     *
+     * @param image - Image to compress.
+     * @return - Compressed image.
+     */
+    CompressedImage compressBC1(const Image &image);
+
+    /*!
+     * Compress image and its full mipmap chain to BC3.
+     *
+     * @param image - Image with alpha channel to compress.
+     * @return - Compressed image.
+     */
+    CompressedImage compressBC3(const ImageAlpha &image);
+
+    /*!
+     * Copy the smallest levels of a compressed image, used as a low resolution stand-in for the full image.
+     *
+     * @param image - Image with mipmap levels.
+     * @param size - Maximal width and height of the first copied level, the last level is copied regardless.
+     * @return - Image owning copies of the levels.
+     */
+    CompressedImage mipTail(const CompressedImage &image, int size);
+
+    /*!
+     * Save compressed image into a container file that maps directly into memory.
+     *
+     * @param image - Image to save.
+     * @param source - Stamp of the source image, compared when the container is loaded.
+     * @param path - File path to write.
+     */
+    void saveCompressed(const CompressedImage &image, const pack::Stamp &source, const std::string &path);
+
+    /*!
+     * Load compressed image from a container file or asset pack.
+     *
+     * @param path - File path to the container.
+     * @param source - Stamp of the source image, nullptr accepts any container. A container from the same pack as
+     *                 its source is accepted, otherwise the stamp must match the one the container was saved with.
+     * @return - Compressed image or nullptr when the container is missing, invalid or stale.
+     */
+    std::unique_ptr<CompressedImage> loadCompressed(const std::string &path, const pack::Stamp *source);
+
+    /*!
+     * Get path of the container generated for an image.
+     *
+     * @param image - File path to the source image.
+     * @return - File path of the container.
+     */
+    std::string compressedPath(const std::string &image);
+
+    /*!
+     * Load BMP image as BC1 using the container next to it, the container is regenerated when missing or stale.
+     *
+     * @param bmp - File path to a BMP image.
+     * @return - Compressed image.
+     */
+    CompressedImage loadCompressedBMP(const std::string &bmp);
+
+    /*!
+     * Load PNG image as BC3 using the container next to it, the container is regenerated when missing or stale.
+     *
+     * @param png - File path to a PNG image.
+     * @return - Compressed image.
+     */
+    CompressedImage loadCompressedPNG(const std::string &png);
+  }
+}
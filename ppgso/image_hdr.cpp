@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include "image_hdr.h"
+
+namespace {
+  // Normalized 4x4 Bayer matrix
+  const float BAYER[4][4] = {
+      { 0.0f / 16.0f,  8.0f / 16.0f,  2.0f / 16.0f, 10.0f / 16.0f},
+      {12.0f / 16.0f,  4.0f / 16.0f, 14.0f / 16.0f,  6.0f / 16.0f},
+      { 3.0f / 16.0f, 11.0f / 16.0f,  1.0f / 16.0f,  9.0f / 16.0f},
+      {15.0f / 16.0f,  7.0f / 16.0f, 13.0f / 16.0f,  5.0f / 16.0f},
+  };
+
+  // Dump file header
+  const char HDR_MAGIC[8] = {'P', 'P', 'G', 'S', 'O', 'H', 'D', 'R'};
+  const uint32_t HDR_VERSION = 1;
+
+  struct HDRHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t width, height;
+    uint32_t samples;
+  };
+
+  inline float reinhard(float value) {
+    return value / (1.0f + value);
+  }
+
+  inline float aces(float value) {
+    return (value * (2.51f * value + 0.03f)) / (value * (2.43f * value + 0.59f) + 0.14f);
+  }
+
+  inline uint8_t quantize(float value, float offset) {
+    return (uint8_t) std::min(std::max(value * 255.0f + offset, 0.0f), 255.0f);
+  }
+}
+
+ppgso::ImageHDR::ImageHDR(int width, int height) : width{width}, height{height} {
+  framebuffer.resize((size_t) (width * height));
+}
+
+std::vector<ppgso::ImageHDR::Pixel>& ppgso::ImageHDR::getFramebuffer() {
+  return framebuffer;
+}
+
+ppgso::ImageHDR::Pixel& ppgso::ImageHDR::getPixel(int x, int y) {
+  return framebuffer[x+y*width];
+}
+
+void ppgso::ImageHDR::setPixel(int x, int y, const ImageHDR::Pixel& color) {
+  framebuffer[x+y*width] = color;
+}
+
+void ppgso::ImageHDR::addPixel(int x, int y, const ImageHDR::Pixel& color) {
+  auto &pixel = framebuffer[x+y*width];
+  pixel.r += color.r;
+  pixel.g += color.g;
+  pixel.b += color.b;
+}
+
+void ppgso::ImageHDR::clear(const ppgso::ImageHDR::Pixel &color) {
+  framebuffer = std::vector<Pixel>(framebuffer.size(), color);
+  samples = 0;
+}
+
+void ppgso::ImageHDR::toneMap(Image &image, ToneMapping toneMapping, float exposure, bool dither) const {
+  if (image.width != width || image.height != height)
+    throw std::runtime_error("Tone mapping requires images of the same size!");
+
+  auto scale = exposure / (float) std::max(samples, 1u);
+  auto src = reinterpret_cast<const float *>(framebuffer.data());
+  auto dst = image.getFramebuffer().data();
+
+  // Rows are independent, channels within a row are processed as a flat float array so the loop vectorizes
+  #pragma omp parallel for
+  for (int y = 0; y < height; ++y) {
+    auto row = src + (size_t) y * width * 3;
+    auto out = reinterpret_cast<uint8_t *>(dst + (size_t) y * width);
+    const float *bayer = BAYER[y & 3];
+
+    #pragma omp simd
+    for (int i = 0; i < width * 3; ++i) {
+      float value = row[i] * scale;
+      switch (toneMapping) {
+        case ToneMapping::Reinhard:
+          value = reinhard(value);
+          break;
+        case ToneMapping::ACES:
+          value = aces(value);
+          break;
+        default:
+          break;
+      }
+      // Ordered dither threshold in <0, 1) spreads the truncation error evenly over the 4x4 tile
+      float offset = dither ? bayer[(i / 3) & 3] + 0.5f / 16.0f : 0.0f;
+      out[i] = quantize(value, offset);
+    }
+  }
+}
+
+namespace ppgso {
+  namespace image {
+
+    ImageHDR loadHDR(const std::string &hdr) {
+      std::ifstream input_file(hdr, std::ios::binary);
+
+      if (!input_file.is_open()) {
+        std::stringstream msg;
+        msg << "Could not open HDR file. " << hdr;
+        throw std::runtime_error(msg.str());
+      }
+
+      HDRHeader header = {};
+      input_file.read((char *) &header, sizeof(HDRHeader));
+
+      if (!input_file || memcmp(header.magic, HDR_MAGIC, sizeof(HDR_MAGIC)) != 0 || header.version != HDR_VERSION) {
+        std::stringstream msg;
+        msg << "HDR file does not contain supported HDR format. " << hdr;
+        throw std::runtime_error(msg.str());
+      }
+
+      if (header.width <= 0 || header.height <= 0) {
+        std::stringstream msg;
+        msg << "HDR file does not contain any data. " << hdr;
+        throw std::runtime_error(msg.str());
+      }
+
+      ImageHDR image{header.width, header.height};
+      image.samples = header.samples;
+
+      auto &framebuffer = image.getFramebuffer();
+      input_file.read((char *) framebuffer.data(), framebuffer.size() * sizeof(ImageHDR::Pixel));
+
+      if (!input_file) {
+        std::stringstream msg;
+        msg << "HDR file is truncated. " << hdr;
+        throw std::runtime_error(msg.str());
+      }
+
+      return image;
+    }
+
+    void saveHDR(ImageHDR &image, const std::string &hdr) {
+      std::ofstream output_file(hdr, std::ios::binary);
+
+      if (!output_file.is_open()) {
+        std::stringstream msg;
+        msg << "Could not open HDR file for writing. " << hdr;
+        throw std::runtime_error(msg.str());
+      }
+
+      HDRHeader header = {};
+      memcpy(header.magic, HDR_MAGIC, sizeof(HDR_MAGIC));
+      header.version = HDR_VERSION;
+      header.width = image.width;
+      header.height = image.height;
+      header.samples = image.samples;
+
+      auto &framebuffer = image.getFramebuffer();
+      output_file.write((char *) &header, sizeof(HDRHeader));
+      output_file.write((char *) framebuffer.data(), framebuffer.size() * sizeof(ImageHDR::Pixel));
+    }
+  }
+}
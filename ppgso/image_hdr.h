@@ -0,0 +1,112 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+
+#include "image.h"
+
+namespace ppgso {
+
+  /*!
+   * Floating point RGB image used to accumulate high dynamic range samples.
+   * Pixel values hold the sum of all accumulated samples, the sample count is kept in "samples".
+   */
+  class ImageHDR {
+  public:
+    struct Pixel {
+      float r, g, b;
+    };
+
+    /*!
+     * Tone mapping operators available when converting to 8bit images.
+     */
+    enum class ToneMapping {
+      Linear,   // Clamp to <0, 1>
+      Reinhard, // c / (1 + c)
+      ACES      // Narkowicz fit of the ACES filmic curve
+    };
+
+    /*!
+     * Create new empty image.
+     *
+     * @param width - Width in pixels.
+     * @param height - Height in pixels.
+     */
+    ImageHDR(int width, int height);
+
+    /*!
+     * Get raw access to the image data.
+     *
+     * @return - Pointer to the raw RGB framebuffer data.
+     */
+    std::vector<Pixel>& getFramebuffer();
+
+    /*!
+     * Get single pixel from the framebuffer.
+     *
+     * @param x - X position of the pixel in the framebuffer.
+     * @param y - Y position of the pixel in the framebuffer.
+     * @return - Reference to the pixel.
+     */
+    Pixel& getPixel(int x, int y);
+
+    /*!
+     * Set pixel on coordinates x and y
+     * @param x Horizontal coordinate
+     * @param y Vertical coordinate
+     * @param color Pixel color to set
+     */
+    void setPixel(int x, int y, const Pixel& color);
+
+    /*!
+     * Add color to the accumulated value of the pixel on coordinates x and y
+     * @param x Horizontal coordinate
+     * @param y Vertical coordinate
+     * @param color Pixel color to accumulate
+     */
+    void addPixel(int x, int y, const Pixel& color);
+
+    /*!
+     * Clear the image using single color and reset the sample count
+     * @param color Pixel color to set the image to
+     */
+    void clear(const Pixel& color = {0,0,0});
+
+    /*!
+     * Convert accumulated values to an 8bit image.
+     * Values are divided by the sample count, scaled by exposure, tone mapped and quantized using
+     * a 4x4 ordered (Bayer) dither to avoid banding in smooth gradients.
+     *
+     * @param image - Destination image, must have the same size.
+     * @param toneMapping - Tone mapping operator to use.
+     * @param exposure - Linear exposure multiplier applied before tone mapping.
+     * @param dither - Use ordered dithering when quantizing to 8bits.
+     */
+    void toneMap(Image &image, ToneMapping toneMapping = ToneMapping::Linear, float exposure = 1.0f, bool dither = true) const;
+
+    int width, height;
+
+    // Number of samples accumulated in each pixel
+    unsigned int samples = 0;
+  private:
+    std::vector<Pixel> framebuffer;
+  };
+
+  namespace image {
+/*!
+ * Load HDR accumulation dump from file.
+ * The format is a small header (magic, version, width, height, samples) followed by raw float RGB data.
+ *
+ * @param hdr - File path to the dump.
+ */
+  ppgso::ImageHDR loadHDR(const std::string &hdr);
+
+/*!
+ * Save HDR accumulation dump so rendering can be resumed or post-processed later.
+ * @param image - Image to save.
+ * @param hdr - Name of the file to save image to.
+ */
+  void saveHDR(ppgso::ImageHDR &image, const std::string &hdr);
+  }
+}
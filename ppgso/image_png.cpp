@@ -1,6 +1,7 @@
 #include <iostream>
 #include "image_png.h"
 #include "lodepng.h"
+#include "asset_pack.h"
 
 namespace ppgso {
     namespace image {
@@ -9,8 +10,9 @@ namespace ppgso {
             std::vector<unsigned char> result;
             unsigned int width, height, k = 0;
 
-            // Use lodepng library to read PNG image
-            unsigned int error = lodepng::decode(result, width, height, png);
+            // Use lodepng library to read PNG image from a pack or a loose file
+            auto file = pack::open(png);
+            unsigned int error = lodepng::decode(result, width, height, (const unsigned char *) file.data(), file.size());
             if (error) std::cout << "decoder error";
 
             ppgso::ImageAlpha image{static_cast<int>(width), static_cast<int>(height)};
@@ -0,0 +1,112 @@
+#include <sstream>
+#include <stdexcept>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+ppgso::MappedFile::MappedFile(const std::string &path, Access access) {
+#ifdef _WIN32
+  file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = nullptr;
+    std::stringstream msg;
+    msg << "Could not open file for mapping. " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  length = (size_t) fileSize.QuadPart;
+  if (length == 0) return;
+
+  view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (view) mapping = (const char *) MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+#else
+  file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    std::stringstream msg;
+    msg << "Could not open file for mapping. " << path;
+    throw std::runtime_error(msg.str());
+  }
+
+  struct stat info = {};
+  fstat(file, &info);
+  length = (size_t) info.st_size;
+  if (length == 0) return;
+
+  auto result = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+  if (result != MAP_FAILED) {
+    mapping = (const char *) result;
+    // Files are mostly parsed front to back, archives are read at random
+    madvise(result, length, access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+  }
+#endif
+
+  if (!mapping) {
+    release();
+    std::stringstream msg;
+    msg << "Could not map file into memory. " << path;
+    throw std::runtime_error(msg.str());
+  }
+}
+
+ppgso::MappedFile::~MappedFile() {
+  release();
+}
+
+void ppgso::MappedFile::release() {
+#ifdef _WIN32
+  if (mapping) UnmapViewOfFile(mapping);
+  if (view) CloseHandle(view);
+  if (file) CloseHandle(file);
+  view = file = nullptr;
+#else
+  if (mapping) munmap((void *) mapping, length);
+  if (file >= 0) close(file);
+  file = -1;
+#endif
+  mapping = nullptr;
+}
+
+const char *ppgso::MappedFile::data() const {
+  return mapping;
+}
+
+size_t ppgso::MappedFile::size() const {
+  return length;
+}
+
+bool ppgso::MappedFile::stat(const std::string &path, uint64_t &size, int64_t &modified) {
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA info;
+  if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info)) return false;
+  size = ((uint64_t) info.nFileSizeHigh << 32) | info.nFileSizeLow;
+  // FILETIME counts 100 ns intervals
+  modified = (int64_t) ((((uint64_t) info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime) * 100);
+#else
+  struct stat info = {};
+  if (::stat(path.c_str(), &info) != 0) return false;
+  size = (uint64_t) info.st_size;
+#ifdef __APPLE__
+  modified = (int64_t) info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+  modified = (int64_t) info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+#endif
+  return true;
+}
+
+bool ppgso::MappedFile::exists(const std::string &path) {
+  std::ifstream file{path, std::ios::binary};
+  return file.is_open();
+}
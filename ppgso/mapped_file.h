@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace ppgso {
+
+  /*!
+   * Read-only memory mapping of a whole file.
+   * The mapping is released when the object is destroyed.
+   */
+  class MappedFile {
+  public:
+    /*!
+     * Expected access pattern, used as a read-ahead hint.
+     */
+    enum class Access {
+      Sequential,
+      Random
+    };
+
+    /*!
+     * Map file into memory.
+     *
+     * @param path - File path to map.
+     * @param access - Expected access pattern.
+     */
+    MappedFile(const std::string &path, Access access = Access::Sequential);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    /*!
+     * Get pointer to the first byte of the file.
+     *
+     * @return - Pointer to mapped data, nullptr for empty files.
+     */
+    const char *data() const;
+
+    /*!
+     * Get size of the mapped file.
+     *
+     * @return - Size in bytes.
+     */
+    size_t size() const;
+
+    /*!
+     * Check whether a file exists and can be opened for reading.
+     *
+     * @param path - File path to check.
+     * @return - True when the file can be mapped.
+     */
+    static bool exists(const std::string &path);
+
+    /*!
+     * Get size and modification time of a file without opening it.
+     *
+     * @param path - File path to query.
+     * @param size - Size in bytes.
+     * @param modified - Time of the last modification in nanoseconds since the epoch of the platform.
+     * @return - False when the file does not exist.
+     */
+    static bool stat(const std::string &path, uint64_t &size, int64_t &modified);
+
+  private:
+    void release();
+
+    const char *mapping = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *view = nullptr;
+#else
+    int file = -1;
+#endif
+  };
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+namespace ppgso {
+
+  /*!
+   * Memory held by a resource: CPU side copies and OpenGL storage.
+   * GPU sizes are estimated from dimensions and formats, drivers may pad or compress further.
+   */
+  struct MemoryUsage {
+    size_t cpu, gpu;
+  };
+}
@@ -1,87 +1,208 @@
 #include <glm/glm.hpp>
 #include <sstream>
+#include <stdexcept>
+#include <glm/gtc/matrix_access.hpp>
 
 #include "mesh.h"
+#include "gl_state.h"
 
-ppgso::Mesh::Mesh(const std::string &obj_file) {
-  // Load OBJ file
-  shapes.clear();
-  materials.clear();
-  std::string err = tinyobj::LoadObj(shapes, materials, obj_file.c_str());
+namespace {
+  // Normalized frustum planes in model space, points inside have non-negative distance to all of them
+  void frustumPlanes(const glm::mat4 &clip, glm::vec4 planes[6]) {
+    for (int i = 0; i < 3; i++) {
+      planes[i * 2] = glm::row(clip, 3) + glm::row(clip, i);
+      planes[i * 2 + 1] = glm::row(clip, 3) - glm::row(clip, i);
+    }
+    for (int i = 0; i < 6; i++) planes[i] /= glm::length(glm::vec3{planes[i]});
+  }
+}
+
+ppgso::Mesh::Mesh(const std::string &obj_file, Format format) : Mesh{mesh::load(obj_file), format} {}
+
+ppgso::Mesh::Mesh(mesh::Loaded &&loaded, Format format) : format{format} {
+  // Shapes and materials parsed from the obj file are not needed once the buffers are filled
+  upload(loaded.geometry);
+}
+
+void ppgso::Mesh::upload(const mesh::Geometry &geometry) {
+  parts.assign(geometry.parts, geometry.parts + geometry.partCount * geometry.lodCount);
+  lodErrors.assign(geometry.lodErrors, geometry.lodErrors + geometry.lodCount);
+  partCount = geometry.partCount;
+  meshlets.assign(geometry.meshlets, geometry.meshlets + geometry.meshletCount);
+  min = geometry.min;
+  max = geometry.max;
+
+  // Generate a vertex array object
+  glGenVertexArrays(1, &vao);
+  gl::bindVertexArray(vao);
+
+  // Generate and upload a single interleaved buffer shared by all parts
+  glGenBuffers(1, &vbo);
+  gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
+
+  if (format == Format::Quantized) {
+    auto vertices = mesh::quantize(geometry, positionScale, positionOffset);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(mesh::QuantizedVertex), vertices.data(), GL_STATIC_DRAW);
+    gpuSize = vertices.size() * sizeof(mesh::QuantizedVertex);
 
-  if (!err.empty()) {
-    std::stringstream msg;
-    msg << err << std::endl << "Failed to load OBJ file " << obj_file << "!" << std::endl;
-    throw std::runtime_error(msg.str());
+    // Positions are normalized to <0, 1> and normals stay integers, both are decoded in the vertex shader
+    auto stride = (GLsizei) sizeof(mesh::QuantizedVertex);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *) offsetof(mesh::QuantizedVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *) offsetof(mesh::QuantizedVertex, texCoord));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_BYTE, GL_FALSE, stride, (void *) offsetof(mesh::QuantizedVertex, normal));
+  } else {
+    glBufferData(GL_ARRAY_BUFFER, geometry.vertexCount * sizeof(mesh::Vertex), geometry.vertices, GL_STATIC_DRAW);
+    gpuSize = geometry.vertexCount * sizeof(mesh::Vertex);
+
+    // Bind the buffer to "Position", "TexCoord" and "Normal" attributes in program
+    auto stride = (GLsizei) sizeof(mesh::Vertex);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *) offsetof(mesh::Vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void *) offsetof(mesh::Vertex, texCoord));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void *) offsetof(mesh::Vertex, normal));
   }
 
-  // Initialize OpenGL Buffers
-  for(auto& shape : shapes) {
-    gl_buffer buffer;
+  // Generate and upload a buffer with indices to GPU
+  glGenBuffers(1, &ibo);
+  gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry.indexCount * geometry.indexSize, geometry.indices, GL_STATIC_DRAW);
+  gpuSize += geometry.indexCount * geometry.indexSize;
+  indexSize = geometry.indexSize;
+  indexType = indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-    if(!shape.mesh.positions.empty()) {
-      // Generate a vertex array object
-      glGenVertexArrays(1, &buffer.vao);
-      glBindVertexArray(buffer.vao);
+  gl::bindVertexArray(0);
+}
 
-      // Generate and upload a buffer with vertex positions to GPU
-      glGenBuffers(1, &buffer.vbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.vbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.positions.size() * sizeof(float), shape.mesh.positions.data(),
-                   GL_STATIC_DRAW);
+ppgso::Mesh::~Mesh() {
+  gl::deleteBuffer(ibo);
+  gl::deleteBuffer(vbo);
+  gl::deleteVertexArray(vao);
+}
 
-      // Bind the buffer to "Position" attribute in program
-      glEnableVertexAttribArray(0);
-      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
+void ppgso::Mesh::setDecodeUniforms(const Shader &shader) const {
+  // Uniforms persist in the program so float meshes have to reset them too
+  shader.setUniform("PositionScale", positionScale);
+  shader.setUniform("PositionOffset", positionOffset);
+  // Bool uniforms accept the float variant of glUniform
+  shader.setUniform("OctahedralNormals", format == Format::Quantized ? 1.0f : 0.0f);
+}
 
-    if(!shape.mesh.texcoords.empty()) {
-      // Generate and upload a buffer with texture coordinates to GPU
-      glGenBuffers(1, &buffer.tbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.tbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.texcoords.size() * sizeof(float), shape.mesh.texcoords.data(),
-                   GL_STATIC_DRAW);
+int ppgso::Mesh::selectLod(const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix, float threshold) const {
+  // Bounding sphere in camera space
+  auto center = glm::vec3{modelViewMatrix * glm::vec4{(min + max) * 0.5f, 1.0f}};
+  auto scale = std::max(glm::length(glm::vec3{modelViewMatrix[0]}),
+                        std::max(glm::length(glm::vec3{modelViewMatrix[1]}), glm::length(glm::vec3{modelViewMatrix[2]})));
+  auto radius = glm::length(max - min) * 0.5f * scale;
+  auto distance = std::max(glm::length(center) - radius, 0.001f);
 
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
+  // Size of one model unit at the nearest point of the sphere relative to the viewport height
+  auto unit = scale * projectionMatrix[1][1] * 0.5f / distance;
 
-    if(!shape.mesh.normals.empty()) {
-      // Generate and upload a buffer with texture coordinates to GPU
-      glGenBuffers(1, &buffer.nbo);
-      glBindBuffer(GL_ARRAY_BUFFER, buffer.nbo);
-      glBufferData(GL_ARRAY_BUFFER, shape.mesh.normals.size() * sizeof(float), shape.mesh.normals.data(),
-                   GL_STATIC_DRAW);
+  int lod = 0;
+  for (int i = 1; i < getLodCount(); i++) {
+    if (lodErrors[i] * unit > threshold) break;
+    lod = i;
+  }
+  return lod;
+}
 
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-    }
+int ppgso::Mesh::getLodCount() const {
+  return (int) lodErrors.size();
+}
 
-    // Generate and upload a buffer with indices to GPU
-    glGenBuffers(1, &buffer.ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shape.mesh.indices.size() * sizeof(unsigned int), shape.mesh.indices.data(), GL_STATIC_DRAW);
-    buffer.size = (GLsizei) shape.mesh.indices.size();
+void ppgso::Mesh::render(int lod) {
+  if (format == Format::Quantized)
+    throw std::runtime_error("Quantized meshes must be rendered with the shader that decodes them");
+  draw(lod);
+}
+
+void ppgso::Mesh::render(const Shader &shader, int lod) {
+  setDecodeUniforms(shader);
+  draw(lod);
+}
 
-    // Copy it to the end of the buffers vector
-    buffers.push_back(buffer);
+void ppgso::Mesh::draw(int lod) {
+  if (parts.empty()) return;
+
+  // Draw object, parts index their own range of the shared vertex buffer
+  lod = std::min(std::max(lod, 0), getLodCount() - 1);
+  auto first = parts.begin() + lod * partCount;
+  gl::bindVertexArray(vao);
+  for(auto part = first; part != first + partCount; ++part) {
+    glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei) part->indexCount, indexType,
+                             (void *) ((size_t) part->indexOffset * indexSize), (GLint) part->baseVertex);
   }
 }
 
-ppgso::Mesh::~Mesh() {
-  for(auto& buffer : buffers) {
-    glDeleteBuffers(1, &buffer.ibo);
-    glDeleteBuffers(1, &buffer.nbo);
-    glDeleteBuffers(1, &buffer.tbo);
-    glDeleteBuffers(1, &buffer.vbo);
-    glDeleteVertexArrays(1, &buffer.vao);
+bool ppgso::Mesh::isVisible(const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix) const {
+  glm::vec4 planes[6];
+  frustumPlanes(projectionMatrix * modelViewMatrix, planes);
+
+  // The box is outside when its corner furthest along the plane normal is behind the plane
+  for (auto &plane : planes) {
+    glm::vec3 corner{plane.x >= 0 ? max.x : min.x, plane.y >= 0 ? max.y : min.y, plane.z >= 0 ? max.z : min.z};
+    if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0) return false;
   }
+  return true;
 }
 
-void ppgso::Mesh::render() {
-  for(auto& buffer : buffers) {
-    // Draw object
-    glBindVertexArray(buffer.vao);
-    glDrawElements(GL_TRIANGLES, buffer.size, GL_UNSIGNED_INT, nullptr);
+void ppgso::Mesh::render(const Shader &shader, const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix) {
+  auto lod = selectLod(modelViewMatrix, projectionMatrix);
+  if (lod > 0 || meshlets.empty()) {
+    render(shader, lod);
+    return;
+  }
+
+  // Frustum planes and camera position in model space
+  glm::vec4 planes[6];
+  frustumPlanes(projectionMatrix * modelViewMatrix, planes);
+  auto camera = glm::vec3{glm::inverse(modelViewMatrix)[3]};
+
+  drawCounts.clear();
+  drawOffsets.clear();
+  drawBaseVertices.clear();
+  size_t rangeEnd = 0;
+  for (auto &meshlet : meshlets) {
+    glm::vec3 center{meshlet.center[0], meshlet.center[1], meshlet.center[2]};
+    glm::vec3 axis{meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2]};
+
+    bool visible = true;
+    for (auto &plane : planes)
+      visible = visible && glm::dot(glm::vec3{plane}, center) + plane.w >= -meshlet.radius;
+
+    // All triangles of the meshlet face away from the camera
+    auto direction = center - camera;
+    if (!visible || glm::dot(direction, axis) >= meshlet.coneCutoff * glm::length(direction) + meshlet.radius)
+      continue;
+
+    // Neighbouring visible meshlets are merged into one range
+    auto offset = (size_t) meshlet.indexOffset * indexSize;
+    auto baseVertex = (GLint) parts[meshlet.part].baseVertex;
+    if (!drawCounts.empty() && rangeEnd == offset && drawBaseVertices.back() == baseVertex) {
+      drawCounts.back() += (GLsizei) meshlet.indexCount;
+    } else {
+      drawCounts.push_back((GLsizei) meshlet.indexCount);
+      drawOffsets.push_back((const GLvoid *) offset);
+      drawBaseVertices.push_back(baseVertex);
+    }
+    rangeEnd = offset + (size_t) meshlet.indexCount * indexSize;
   }
+  if (drawCounts.empty()) return;
+
+  setDecodeUniforms(shader);
+  gl::bindVertexArray(vao);
+  glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), indexType, drawOffsets.data(),
+                                (GLsizei) drawCounts.size(), drawBaseVertices.data());
+}
+
+ppgso::MemoryUsage ppgso::Mesh::getMemoryUsage() const {
+  auto cpu = parts.capacity() * sizeof(mesh::Part) + lodErrors.capacity() * sizeof(float) +
+             meshlets.capacity() * sizeof(mesh::Meshlet) + drawCounts.capacity() * sizeof(GLsizei) +
+             drawOffsets.capacity() * sizeof(const GLvoid *) + drawBaseVertices.capacity() * sizeof(GLint);
+  return {cpu, gpuSize};
 }
@@ -12,39 +12,143 @@
 #include "shader.h"
 #include "texture.h"
 #include "tiny_obj_loader.h"
+#include "mesh_cache.h"
+#include "memory_usage.h"
 
 namespace ppgso {
 
   class Mesh {
-    struct gl_buffer {
-    public:
-      GLuint vao, vbo, tbo, nbo, ibo = 0;
-      GLsizei size = 0;
+  public:
+    /*!
+     * Vertex format used on the GPU.
+     * Quantized meshes need vertex shaders that decode them (see light_vert.glsl).
+     */
+    enum class Format {
+      Float,
+      Quantized
     };
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::vector<gl_buffer> buffers;
+
+  private:
+    std::vector<mesh::Part> parts;
+    std::vector<float> lodErrors;
+    std::vector<mesh::Meshlet> meshlets;
+    size_t partCount = 0;
+
+    // Ranges of visible meshlets collected every frame for glMultiDrawElementsBaseVertex
+    std::vector<GLsizei> drawCounts;
+    std::vector<const GLvoid *> drawOffsets;
+    std::vector<GLint> drawBaseVertices;
+    GLuint vao = 0, vbo = 0, ibo = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    GLsizei indexSize = sizeof(uint32_t);
+    size_t gpuSize = 0;
+
+    Format format;
+    glm::vec3 positionScale{1}, positionOffset{0};
+
+    void upload(const mesh::Geometry &geometry);
+    void setDecodeUniforms(const Shader &shader) const;
+    void draw(int lod);
 
   public:
 
     /*!
      * Load 3D geometry from a na Wavefront .obj file.
      *
+     * The geometry is cached in a binary file next to the obj file (see mesh_cache.h).
+     * When the cache matches the obj file it is memory mapped and uploaded directly,
+     * otherwise the obj file is parsed and the cache is regenerated.
+     *
      * The shader program passed to the object will be bound to the geometry as follows:
      * vec3 Position - Vertex position, position 0
      * vec2 TexCoord - Texture coordinate, position 1
      * vec3 Normal - Normal vector, position 2
      *
+     * Quantized meshes use less than half of the vertex memory. When rendered with a shader, the mesh sets
+     * its PositionScale, PositionOffset and OctahedralNormals uniforms so the vertex shader can decode
+     * the attributes, float meshes set them to identity.
+     *
      * @param obj - File path to the obj file to load.
+     * @param format - Vertex format used on the GPU.
+     */
+    Mesh(const std::string &obj, Format format = Format::Float);
+
+    /*!
+     * Upload geometry loaded by mesh::load, possibly on another thread.
+     * Must be called on the thread that owns the OpenGL context.
+     *
+     * @param loaded - Geometry to upload, the mapping, parsed shapes and materials it owns are released afterwards.
+     * @param format - Vertex format used on the GPU.
      */
-    Mesh(const std::string &obj);
+    Mesh(mesh::Loaded &&loaded, Format format = Format::Float);
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
 
     ~Mesh();
 
+    /*!
+     * Select the coarsest level of detail whose geometric error projects below the threshold.
+     *
+     * @param modelViewMatrix - Transformation of the mesh to the camera space.
+     * @param projectionMatrix - Perspective projection of the camera.
+     * @param threshold - Maximal projected error as a fraction of the viewport height.
+     * @return - Level of detail to render.
+     */
+    int selectLod(const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix, float threshold = 0.002f) const;
+
+    /*!
+     * Get number of levels of detail, level 0 is the full resolution mesh.
+     *
+     * @return - Number of levels.
+     */
+    int getLodCount() const;
+
+    /*!
+     * Check whether the bounding box of the mesh intersects the view frustum.
+     *
+     * @param modelViewMatrix - Transformation of the mesh to the camera space.
+     * @param projectionMatrix - Perspective projection of the camera.
+     * @return - False when the mesh is certainly not visible.
+     */
+    bool isVisible(const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix) const;
+
     /*!
      * Render the geometry associated with the mesh using glDrawElements.
+     * The current program must not decode meshes, throws for quantized meshes.
+     *
+     * @param lod - Level of detail to render.
+     */
+    void render(int lod = 0);
+
+    /*!
+     * Render the geometry with a shader that decodes meshes (see light_vert.glsl).
+     *
+     * @param shader - Shader in use, its decoding uniforms are set for the mesh.
+     * @param lod - Level of detail to render.
+     */
+    void render(const Shader &shader, int lod = 0);
+
+    /*!
+     * Render the mesh as seen by a camera.
+     * The level of detail is selected by the projected size, at full resolution only meshlets
+     * inside the view frustum and not facing away from the camera are drawn.
+     *
+     * @param shader - Shader in use, its decoding uniforms are set for the mesh.
+     * @param modelViewMatrix - Transformation of the mesh to the camera space.
+     * @param projectionMatrix - Perspective projection of the camera.
      */
-    void render();
+    void render(const Shader &shader, const glm::mat4 &modelViewMatrix, const glm::mat4 &projectionMatrix);
+
+    /*!
+     * Get memory held by the mesh, only culling data stays on the CPU after upload.
+     *
+     * @return - CPU and GPU bytes.
+     */
+    MemoryUsage getMemoryUsage() const;
+
+    // Axis aligned bounding box of the geometry in model space
+    glm::vec3 min{0}, max{0};
   };
 }
 
@@ -0,0 +1,708 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <set>
+#include <tuple>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+
+#include <glm/gtc/packing.hpp>
+
+#include "mesh_cache.h"
+#include "mesh_simplify.h"
+
+namespace ppgso {
+  namespace mesh {
+
+    namespace {
+      const char CACHE_MAGIC[4] = {'P', 'P', 'G', 'M'};
+      const uint32_t CACHE_VERSION = 4;
+      // Size of the simulated post-transform vertex cache
+      const uint32_t VERTEX_CACHE_SIZE = 16;
+      // Overdraw clusters may have this much higher cache miss ratio than the range they are split from
+      const float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+      // Levels of detail halve the triangle count until it gets small or stops improving
+      const uint32_t MAX_LODS = 5;
+      const uint32_t MIN_LOD_TRIANGLES = 32;
+      // Sections are aligned so they can be used straight from the mapping
+      const uint32_t CACHE_ALIGNMENT = 16;
+
+      struct CacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceModified;
+        uint32_t vertexCount, indexCount, partCount, vertexStride;
+        uint32_t partsOffset, lodErrorsOffset, meshletsOffset, verticesOffset, indicesOffset, fileSize;
+        uint32_t indexSize, lodCount, meshletCount, reserved;
+        float min[3], max[3];
+      };
+
+      uint32_t align(uint32_t offset) {
+        return (offset + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1);
+      }
+
+      /*!
+       * Reorder triangles for the post-transform vertex cache using Tipsify (Sander et al. 2007).
+       * Triangles are emitted as fans around the vertex that is most likely still cached.
+       *
+       * @param indices - Triangle list to reorder in place.
+       * @param vertexCount - Number of vertices referenced by the indices.
+       * @param clusters - Output offsets (in triangles) where the cache was restarted, ends with the triangle count.
+       */
+      void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount, std::vector<uint32_t> &clusters) {
+        auto triangleCount = (uint32_t) (indices.size() / 3);
+
+        // Vertex to triangle adjacency in compressed row form
+        std::vector<uint32_t> live(vertexCount, 0);
+        for (auto index : indices) live[index]++;
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + live[v];
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (uint32_t t = 0; t < triangleCount * 3; t++) adjacency[fill[indices[t]]++] = t / 3;
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnd, candidates, result;
+        result.reserve(triangleCount * 3);
+        clusters.clear();
+
+        uint32_t time = VERTEX_CACHE_SIZE + 1, cursor = 0;
+        int64_t fanning = triangleCount ? indices[0] : -1;
+        clusters.push_back(0);
+
+        while (fanning >= 0) {
+          candidates.clear();
+          for (auto i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+            auto t = adjacency[i];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            for (int k = 0; k < 3; k++) {
+              auto v = indices[t * 3 + k];
+              result.push_back(v);
+              deadEnd.push_back(v);
+              candidates.push_back(v);
+              live[v]--;
+              if (time - cacheTime[v] > VERTEX_CACHE_SIZE) cacheTime[v] = time++;
+            }
+          }
+
+          // Prefer a candidate that stays in cache while its remaining triangles are emitted
+          fanning = -1;
+          int64_t best = -1;
+          for (auto v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= VERTEX_CACHE_SIZE) priority = time - cacheTime[v];
+            if (priority > best) {
+              best = priority;
+              fanning = v;
+            }
+          }
+          if (fanning >= 0) continue;
+
+          // Dead end, continue with a recently used vertex or the next one with triangles left
+          while (!deadEnd.empty() && fanning < 0) {
+            auto v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) fanning = v;
+          }
+          while (cursor < vertexCount && fanning < 0) {
+            if (live[cursor] > 0) fanning = cursor;
+            cursor++;
+          }
+          if (fanning >= 0) clusters.push_back((uint32_t) (result.size() / 3));
+        }
+
+        clusters.push_back(triangleCount);
+        indices.swap(result);
+      }
+
+      /*!
+       * Split the ranges between cache restarts further (soft boundaries of Sander et al. 2007).
+       * A cluster ends as soon as its average cache miss ratio drops to the one of the whole range,
+       * the simulated vertex cache is flushed there so every cluster can be drawn in any order.
+       *
+       * @param indices - Triangle list ordered by optimizeVertexCache.
+       * @param vertexCount - Number of vertices referenced by the indices.
+       * @param clusters - Cluster offsets produced by optimizeVertexCache.
+       * @return - Finer cluster offsets, ends with the triangle count.
+       */
+      std::vector<uint32_t> splitClusters(const std::vector<uint32_t> &indices, uint32_t vertexCount,
+                                          const std::vector<uint32_t> &clusters) {
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        uint32_t time = VERTEX_CACHE_SIZE + 1;
+        auto misses = [&](uint32_t t) {
+          uint32_t count = 0;
+          for (int k = 0; k < 3; k++) {
+            auto v = indices[t * 3 + k];
+            if (time - cacheTime[v] > VERTEX_CACHE_SIZE) {
+              cacheTime[v] = time++;
+              count++;
+            }
+          }
+          return count;
+        };
+
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i + 1 < clusters.size(); i++) {
+          auto start = clusters[i], end = clusters[i + 1];
+          if (start == end) continue;
+
+          // Cache miss ratio of the whole range, the cache starts empty like after a restart
+          time += VERTEX_CACHE_SIZE + 1;
+          uint32_t rangeMisses = 0;
+          for (auto t = start; t < end; t++) rangeMisses += misses(t);
+          auto threshold = OVERDRAW_ACMR_THRESHOLD * rangeMisses / (end - start);
+
+          time += VERTEX_CACHE_SIZE + 1;
+          result.push_back(start);
+          uint32_t clusterMisses = 0, clusterTriangles = 0;
+          for (auto t = start; t < end; t++) {
+            clusterMisses += misses(t);
+            clusterTriangles++;
+            if ((float) clusterMisses / clusterTriangles <= threshold && t + 1 < end) {
+              result.push_back(t + 1);
+              time += VERTEX_CACHE_SIZE + 1;
+              clusterMisses = clusterTriangles = 0;
+            }
+          }
+        }
+        result.push_back((uint32_t) (indices.size() / 3));
+        return result;
+      }
+
+      /*!
+       * Sort triangle clusters so the outward facing ones are drawn first which reduces overdraw
+       * for any view direction (Sander et al. 2007). The clusters between cache restarts are split
+       * first (see splitClusters), otherwise most meshes would be a single cluster.
+       *
+       * @param indices - Triangle list to reorder in place.
+       * @param vertices - Vertices referenced by the indices.
+       * @param restarts - Cluster offsets produced by optimizeVertexCache.
+       */
+      void optimizeOverdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &restarts) {
+        auto clusters = splitClusters(indices, (uint32_t) vertices.size(), restarts);
+
+        struct Cluster {
+          uint32_t start, end;
+          float sortKey;
+        };
+
+        // Area weighted centroid and normal of a triangle range
+        auto measure = [&](uint32_t start, uint32_t end, glm::vec3 &centroid, glm::vec3 &normal) {
+          float area = 0;
+          centroid = normal = glm::vec3{0};
+          for (auto t = start; t < end; t++) {
+            auto &a = vertices[indices[t * 3]].position;
+            auto &b = vertices[indices[t * 3 + 1]].position;
+            auto &c = vertices[indices[t * 3 + 2]].position;
+            auto cross = glm::cross(b - a, c - a);
+            auto weight = glm::length(cross);
+            centroid += (a + b + c) * (weight / 3.0f);
+            normal += cross;
+            area += weight;
+          }
+          if (area > 0) centroid /= area;
+        };
+
+        glm::vec3 meshCentroid, meshNormal;
+        measure(0, (uint32_t) (indices.size() / 3), meshCentroid, meshNormal);
+
+        std::vector<Cluster> sorted;
+        for (size_t i = 0; i + 1 < clusters.size(); i++) {
+          if (clusters[i] == clusters[i + 1]) continue;
+          glm::vec3 centroid, normal;
+          measure(clusters[i], clusters[i + 1], centroid, normal);
+          auto length = glm::length(normal);
+          auto key = length > 0 ? glm::dot(centroid - meshCentroid, normal / length) : 0.0f;
+          sorted.push_back({clusters[i], clusters[i + 1], key});
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) {
+          return a.sortKey > b.sortKey;
+        });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (auto &cluster : sorted)
+          result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+        indices.swap(result);
+      }
+
+      /*!
+       * Renumber vertices in the order of first use so vertex fetches are sequential.
+       * Unreferenced vertices are removed.
+       *
+       * @param indices - Triangle list to remap in place.
+       * @param vertices - Vertices to reorder in place.
+       */
+      void optimizeVertexFetch(std::vector<uint32_t> &indices, std::vector<Vertex> &vertices) {
+        const auto unused = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(vertices.size(), unused);
+        std::vector<Vertex> result;
+        result.reserve(vertices.size());
+        for (auto &index : indices) {
+          if (remap[index] == unused) {
+            remap[index] = (uint32_t) result.size();
+            result.push_back(vertices[index]);
+          }
+          index = remap[index];
+        }
+        vertices.swap(result);
+      }
+
+      /*!
+       * Split triangles into meshlets by scanning them in order, a meshlet is closed when the next
+       * triangle would exceed MESHLET_VERTICES or MESHLET_TRIANGLES. The order produced by
+       * optimizeVertexCache and optimizeOverdraw is kept, so every meshlet is a contiguous range of it.
+       *
+       * @param indices - Optimized triangle list.
+       * @param vertices - Vertices referenced by the indices.
+       * @param part - Index of the part the triangles belong to.
+       * @param indexOffset - Offset of the first index in the final index buffer.
+       * @param meshlets - Output meshlets are appended here.
+       */
+      void buildMeshlets(const std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices, uint32_t part,
+                         uint32_t indexOffset, std::vector<Meshlet> &meshlets) {
+        auto triangleCount = (uint32_t) (indices.size() / 3);
+
+        // Vertices of the current meshlet are stamped by meshlet number
+        std::vector<uint32_t> stamp(vertices.size(), 0);
+        std::vector<uint32_t> meshletVertices;
+        std::vector<glm::vec3> normals;
+        uint32_t current = 0;
+
+        uint32_t first = 0;
+        while (first < triangleCount) {
+          current++;
+          meshletVertices.clear();
+          auto last = first;
+          for (; last < triangleCount && last - first < MESHLET_TRIANGLES; last++) {
+            uint32_t added = 0;
+            for (int k = 0; k < 3; k++) added += stamp[indices[last * 3 + k]] != current;
+            if (meshletVertices.size() + added > MESHLET_VERTICES) break;
+            for (int k = 0; k < 3; k++) {
+              auto v = indices[last * 3 + k];
+              if (stamp[v] != current) {
+                stamp[v] = current;
+                meshletVertices.push_back(v);
+              }
+            }
+          }
+
+          Meshlet meshlet;
+          meshlet.indexOffset = indexOffset + first * 3;
+          meshlet.indexCount = (last - first) * 3;
+          meshlet.part = part;
+
+          // Bounding sphere around the center of the bounding box
+          glm::vec3 lower{std::numeric_limits<float>::max()}, upper{-std::numeric_limits<float>::max()};
+          for (auto v : meshletVertices) {
+            lower = glm::min(lower, vertices[v].position);
+            upper = glm::max(upper, vertices[v].position);
+          }
+          auto center = (lower + upper) * 0.5f;
+          float radius = 0;
+          for (auto v : meshletVertices) radius = std::max(radius, glm::length(vertices[v].position - center));
+
+          // Normal cone, the axis is the average triangle normal and the cutoff its widest deviation
+          glm::vec3 axis{0};
+          normals.clear();
+          for (auto t = first; t < last; t++) {
+            auto &a = vertices[indices[t * 3]].position;
+            auto &b = vertices[indices[t * 3 + 1]].position;
+            auto &c = vertices[indices[t * 3 + 2]].position;
+
+            auto normal = glm::cross(b - a, c - a);
+            auto length = glm::length(normal);
+            if (length == 0) continue;
+            normals.push_back(normal / length);
+            axis += normals.back();
+          }
+
+          auto axisLength = glm::length(axis);
+          float minimum = 1;
+          if (axisLength > 0) {
+            axis /= axisLength;
+            for (auto &normal : normals) minimum = std::min(minimum, glm::dot(axis, normal));
+          }
+          for (int k = 0; k < 3; k++) {
+            meshlet.center[k] = center[k];
+            meshlet.coneAxis[k] = axis[k];
+          }
+          meshlet.radius = radius;
+          // Cones wider than a hemisphere can not be culled, a cutoff of 1 never passes the test
+          meshlet.coneCutoff = (axisLength > 0 && minimum > 0.1f) ? std::sqrt(1.0f - minimum * minimum) : 1.0f;
+          meshlets.push_back(meshlet);
+          first = last;
+        }
+      }
+    }
+
+    Geometry MeshData::view() const {
+      Geometry geometry;
+      geometry.vertices = vertices.data();
+      geometry.vertexCount = (uint32_t) vertices.size();
+      if (!shortIndices.empty()) {
+        geometry.indices = shortIndices.data();
+        geometry.indexCount = (uint32_t) shortIndices.size();
+        geometry.indexSize = sizeof(uint16_t);
+      } else {
+        geometry.indices = indices.data();
+        geometry.indexCount = (uint32_t) indices.size();
+        geometry.indexSize = sizeof(uint32_t);
+      }
+      geometry.parts = parts.data();
+      geometry.lodErrors = lodErrors.data();
+      geometry.lodCount = (uint32_t) lodErrors.size();
+      geometry.meshlets = meshlets.data();
+      geometry.meshletCount = (uint32_t) meshlets.size();
+      geometry.partCount = geometry.lodCount ? (uint32_t) parts.size() / geometry.lodCount : 0;
+      geometry.min = min;
+      geometry.max = max;
+      return geometry;
+    }
+
+    MeshData build(const std::vector<tinyobj::shape_t> &shapes) {
+      MeshData data;
+      data.min = glm::vec3{std::numeric_limits<float>::max()};
+      data.max = glm::vec3{-std::numeric_limits<float>::max()};
+      std::vector<std::vector<Part>> shapeParts;
+      std::vector<std::vector<float>> shapeErrors;
+
+      // Positions shared by several shapes stay in place so the levels of detail of the shapes do not crack apart
+      std::map<std::tuple<float, float, float>, size_t> shapePositions;
+      std::set<std::tuple<float, float, float>> sharedPositions;
+      for (size_t i = 0; i < shapes.size(); i++) {
+        auto &positions = shapes[i].mesh.positions;
+        for (size_t k = 0; k + 2 < positions.size(); k += 3) {
+          auto key = std::make_tuple(positions[k], positions[k + 1], positions[k + 2]);
+          auto found = shapePositions.emplace(key, i);
+          if (found.first->second != i) sharedPositions.insert(key);
+        }
+      }
+
+      for (auto &shape : shapes) {
+        auto &mesh = shape.mesh;
+        if (mesh.positions.empty() || mesh.indices.empty()) continue;
+
+        // Missing attributes are zero, same as a disabled vertex attribute array
+        auto vertexCount = mesh.positions.size() / 3;
+        bool hasTexCoords = mesh.texcoords.size() >= vertexCount * 2;
+        bool hasNormals = mesh.normals.size() >= vertexCount * 3;
+        std::vector<Vertex> vertices(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+          auto &vertex = vertices[i];
+          vertex.position = {mesh.positions[3 * i], mesh.positions[3 * i + 1], mesh.positions[3 * i + 2]};
+          if (hasTexCoords) vertex.texCoord = {mesh.texcoords[2 * i], mesh.texcoords[2 * i + 1]};
+          if (hasNormals) vertex.normal = {mesh.normals[3 * i], mesh.normals[3 * i + 1], mesh.normals[3 * i + 2]};
+        }
+
+        std::vector<uint32_t> indices = mesh.indices;
+        std::vector<uint32_t> clusters;
+        optimizeVertexCache(indices, (uint32_t) vertices.size(), clusters);
+        optimizeOverdraw(indices, vertices, clusters);
+        optimizeVertexFetch(indices, vertices);
+
+        // Levels of detail share the optimized vertices
+        std::vector<bool> locked;
+        if (!sharedPositions.empty()) {
+          locked.resize(vertices.size());
+          for (size_t i = 0; i < vertices.size(); i++) {
+            auto &position = vertices[i].position;
+            locked[i] = sharedPositions.count(std::make_tuple(position.x, position.y, position.z)) > 0;
+          }
+        }
+
+        std::vector<std::vector<uint32_t>> levels{indices};
+        std::vector<float> errors{0.0f};
+        while (levels.size() < MAX_LODS && levels.back().size() / 3 > MIN_LOD_TRIANGLES) {
+          float lodError;
+          auto lod = simplify(vertices, indices, levels.back().size() / 2, lodError, locked);
+          if (lod.size() > levels.back().size() * 3 / 4) break;
+          optimizeVertexCache(lod, (uint32_t) vertices.size(), clusters);
+          levels.push_back(std::move(lod));
+          errors.push_back(lodError);
+        }
+
+        for (auto &vertex : vertices) {
+          data.min = glm::min(data.min, vertex.position);
+          data.max = glm::max(data.max, vertex.position);
+        }
+
+        // Meshlets are ranges of the full resolution level, so its vertex cache and fetch order is kept.
+        // Their index offsets point to the final index buffer
+        buildMeshlets(levels[0], vertices, (uint32_t) shapeParts.size(), (uint32_t) data.indices.size(), data.meshlets);
+
+        std::vector<Part> lodParts;
+        for (auto &level : levels) {
+          Part part;
+          part.indexOffset = (uint32_t) data.indices.size();
+          part.indexCount = (uint32_t) level.size();
+          part.baseVertex = (uint32_t) data.vertices.size();
+          part.vertexCount = (uint32_t) vertices.size();
+          lodParts.push_back(part);
+          data.indices.insert(data.indices.end(), level.begin(), level.end());
+        }
+        data.vertices.insert(data.vertices.end(), vertices.begin(), vertices.end());
+        shapeParts.push_back(std::move(lodParts));
+        shapeErrors.push_back(std::move(errors));
+      }
+
+      // Parts are stored per level, shapes with a shorter chain repeat their coarsest level
+      size_t lodCount = 0;
+      for (auto &lodParts : shapeParts) lodCount = std::max(lodCount, lodParts.size());
+      for (size_t lod = 0; lod < lodCount; lod++) {
+        float lodError = 0;
+        for (size_t i = 0; i < shapeParts.size(); i++) {
+          auto level = std::min(lod, shapeParts[i].size() - 1);
+          data.parts.push_back(shapeParts[i][level]);
+          lodError = std::max(lodError, shapeErrors[i][level]);
+        }
+        data.lodErrors.push_back(lodError);
+      }
+
+      if (data.vertices.empty()) data.min = data.max = glm::vec3{0};
+
+      // Indices are relative to the base vertex of each part, so only the largest part decides the index size
+      bool fitsShort = true;
+      for (auto &part : data.parts)
+        fitsShort = fitsShort && part.vertexCount <= std::numeric_limits<uint16_t>::max() + 1u;
+      if (fitsShort) {
+        data.shortIndices.assign(data.indices.begin(), data.indices.end());
+        data.indices = std::vector<uint32_t>{};
+      }
+
+      return data;
+    }
+
+    std::vector<QuantizedVertex> quantize(const Geometry &geometry, glm::vec3 &scale, glm::vec3 &offset) {
+      offset = geometry.min;
+      scale = geometry.max - geometry.min;
+      // Flat meshes quantize the degenerate axis to zero
+      glm::vec3 inverse;
+      for (int i = 0; i < 3; i++)
+        inverse[i] = scale[i] > 0 ? 65535.0f / scale[i] : 0.0f;
+
+      std::vector<QuantizedVertex> result(geometry.vertexCount);
+
+      #pragma omp parallel for
+      for (int64_t i = 0; i < (int64_t) geometry.vertexCount; i++) {
+        auto &vertex = geometry.vertices[i];
+        auto &quantized = result[i];
+
+        auto position = glm::clamp((vertex.position - offset) * inverse + 0.5f, glm::vec3{0}, glm::vec3{65535});
+        for (int k = 0; k < 3; k++)
+          quantized.position[k] = (uint16_t) position[k];
+
+        quantized.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+        quantized.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+
+        // Octahedral projection, the lower hemisphere is folded over the diagonals
+        auto normal = vertex.normal;
+        auto length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (length == 0) {
+          quantized.normal[0] = quantized.normal[1] = 0;
+          continue;
+        }
+        normal /= length;
+        glm::vec2 encoded{normal.x, normal.y};
+        if (normal.z < 0)
+          encoded = (1.0f - glm::abs(glm::vec2{encoded.y, encoded.x})) *
+                    glm::vec2{encoded.x >= 0 ? 1.0f : -1.0f, encoded.y >= 0 ? 1.0f : -1.0f};
+
+        // Pick the rounding direction of each component that decodes closest to the original normal
+        auto target = glm::normalize(vertex.normal);
+        auto best = -2.0f;
+        auto base = glm::floor(glm::clamp(encoded, -1.0f, 1.0f) * 127.0f);
+        for (int k = 0; k < 4; k++) {
+          auto candidate = glm::clamp(base + glm::vec2{k & 1, k >> 1}, -127.0f, 127.0f);
+          auto decoded = candidate / 127.0f;
+          glm::vec3 direction{decoded, 1.0f - std::abs(decoded.x) - std::abs(decoded.y)};
+          auto t = std::max(-direction.z, 0.0f);
+          direction.x += direction.x >= 0 ? -t : t;
+          direction.y += direction.y >= 0 ? -t : t;
+          auto similarity = glm::dot(glm::normalize(direction), target);
+          if (similarity > best) {
+            best = similarity;
+            quantized.normal[0] = (int8_t) candidate.x;
+            quantized.normal[1] = (int8_t) candidate.y;
+          }
+        }
+      }
+
+      return result;
+    }
+
+    std::string cachePath(const std::string &obj) {
+      return obj + ".mesh";
+    }
+
+    void saveCache(const Geometry &geometry, const pack::Stamp &source, const std::string &path) {
+      CacheHeader header = {};
+      memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+      header.version = CACHE_VERSION;
+      header.sourceSize = source.size;
+      header.sourceModified = source.modified;
+      header.vertexCount = geometry.vertexCount;
+      header.indexCount = geometry.indexCount;
+      header.partCount = geometry.partCount;
+      header.vertexStride = sizeof(Vertex);
+      header.indexSize = geometry.indexSize;
+      header.lodCount = geometry.lodCount;
+      header.meshletCount = geometry.meshletCount;
+      header.partsOffset = align(sizeof(CacheHeader));
+      header.lodErrorsOffset = align(header.partsOffset + geometry.partCount * geometry.lodCount * sizeof(Part));
+      header.meshletsOffset = align(header.lodErrorsOffset + geometry.lodCount * sizeof(float));
+      header.verticesOffset = align(header.meshletsOffset + geometry.meshletCount * sizeof(Meshlet));
+      header.indicesOffset = align(header.verticesOffset + geometry.vertexCount * sizeof(Vertex));
+      header.fileSize = header.indicesOffset + geometry.indexCount * geometry.indexSize;
+      for (int i = 0; i < 3; i++) {
+        header.min[i] = geometry.min[i];
+        header.max[i] = geometry.max[i];
+      }
+
+      // Write to a temporary file first so a partially written cache is never picked up
+      auto temporary = path + ".tmp";
+      std::ofstream output_file(temporary, std::ios::binary);
+      if (!output_file.is_open()) {
+        std::stringstream msg;
+        msg << "Could not open mesh cache for writing. " << path;
+        throw std::runtime_error(msg.str());
+      }
+
+      std::vector<char> padding(CACHE_ALIGNMENT, 0);
+      auto pad = [&](uint32_t offset) {
+        output_file.write(padding.data(), offset - (uint32_t) output_file.tellp());
+      };
+
+      output_file.write((char *) &header, sizeof(CacheHeader));
+      pad(header.partsOffset);
+      output_file.write((const char *) geometry.parts, geometry.partCount * geometry.lodCount * sizeof(Part));
+      pad(header.lodErrorsOffset);
+      output_file.write((const char *) geometry.lodErrors, geometry.lodCount * sizeof(float));
+      pad(header.meshletsOffset);
+      output_file.write((const char *) geometry.meshlets, geometry.meshletCount * sizeof(Meshlet));
+      pad(header.verticesOffset);
+      output_file.write((char *) geometry.vertices, geometry.vertexCount * sizeof(Vertex));
+      pad(header.indicesOffset);
+      output_file.write((const char *) geometry.indices, geometry.indexCount * geometry.indexSize);
+      output_file.close();
+
+      if (!output_file) {
+        std::remove(temporary.c_str());
+        std::stringstream msg;
+        msg << "Could not write mesh cache. " << path;
+        throw std::runtime_error(msg.str());
+      }
+
+      std::remove(path.c_str());
+      if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        std::stringstream msg;
+        msg << "Could not replace mesh cache. " << path;
+        throw std::runtime_error(msg.str());
+      }
+    }
+
+    std::unique_ptr<pack::File> loadCache(const std::string &path, const pack::Stamp *source, Geometry &geometry) {
+      if (!pack::exists(path)) return nullptr;
+
+      // A pack is built from the source and its cache together, so a cache next to its source is current
+      auto trusted = !source || (source->pack != 0 && pack::stamp(path).pack == source->pack);
+
+      std::unique_ptr<pack::File> file;
+      try {
+        file = std::make_unique<pack::File>(pack::open(path));
+      } catch (std::runtime_error &) {
+        return nullptr;
+      }
+
+      // Reject caches from other versions, other sources or truncated files
+      if (file->size() < sizeof(CacheHeader)) return nullptr;
+      CacheHeader header;
+      memcpy(&header, file->data(), sizeof(CacheHeader));
+      if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+          header.version != CACHE_VERSION ||
+          header.vertexStride != sizeof(Vertex) ||
+          (header.indexSize != sizeof(uint16_t) && header.indexSize != sizeof(uint32_t)) ||
+          header.fileSize != file->size() ||
+          (!trusted && (header.sourceSize != source->size || header.sourceModified != source->modified)))
+        return nullptr;
+
+      // Sections must lie within the file
+      if ((uint64_t) header.partsOffset + (uint64_t) header.partCount * header.lodCount * sizeof(Part) > header.lodErrorsOffset ||
+          (uint64_t) header.lodErrorsOffset + (uint64_t) header.lodCount * sizeof(float) > header.meshletsOffset ||
+          (uint64_t) header.meshletsOffset + (uint64_t) header.meshletCount * sizeof(Meshlet) > header.verticesOffset ||
+          (uint64_t) header.verticesOffset + (uint64_t) header.vertexCount * sizeof(Vertex) > header.indicesOffset ||
+          (uint64_t) header.indicesOffset + (uint64_t) header.indexCount * header.indexSize > header.fileSize)
+        return nullptr;
+
+      auto base = file->data();
+      geometry.parts = reinterpret_cast<const Part *>(base + header.partsOffset);
+      geometry.partCount = header.partCount;
+      geometry.lodErrors = reinterpret_cast<const float *>(base + header.lodErrorsOffset);
+      geometry.lodCount = header.lodCount;
+      geometry.meshlets = reinterpret_cast<const Meshlet *>(base + header.meshletsOffset);
+      geometry.meshletCount = header.meshletCount;
+      geometry.vertices = reinterpret_cast<const Vertex *>(base + header.verticesOffset);
+      geometry.vertexCount = header.vertexCount;
+      geometry.indices = base + header.indicesOffset;
+      geometry.indexCount = header.indexCount;
+      geometry.indexSize = header.indexSize;
+      geometry.min = {header.min[0], header.min[1], header.min[2]};
+      geometry.max = {header.max[0], header.max[1], header.max[2]};
+      return file;
+    }
+
+    Loaded load(const std::string &obj) {
+      auto start = std::chrono::steady_clock::now();
+      Loaded loaded;
+
+      // Stale caches are detected by the size and modification time of the source without reading it,
+      // a cache without its obj file is used as is
+      pack::Stamp source = {0, 0, 0};
+      auto hasSource = pack::exists(obj);
+      if (hasSource) source = pack::stamp(obj);
+
+      // Use the mapped cache directly when possible
+      auto cache_file = cachePath(obj);
+      std::stringstream msg;
+      if ((loaded.cache = loadCache(cache_file, hasSource ? &source : nullptr, loaded.geometry))) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        msg << "Loaded " << cache_file << " in " << elapsed.count() << " ms" << std::endl;
+        std::cout << msg.str();
+        return loaded;
+      }
+
+      // Load OBJ file
+      std::string err = tinyobj::LoadObjParallel(loaded.shapes, loaded.materials, obj.c_str());
+
+      if (!err.empty()) {
+        msg << err << std::endl << "Failed to load OBJ file " << obj << "!" << std::endl;
+        throw std::runtime_error(msg.str());
+      }
+
+      loaded.data = build(loaded.shapes);
+      loaded.geometry = loaded.data.view();
+
+      // The cache is only an optimization, read-only data directories are fine
+      try {
+        saveCache(loaded.geometry, source, cache_file);
+      } catch (std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+      }
+
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      msg << "Loaded " << obj << " in " << elapsed.count() << " ms" << std::endl;
+      std::cout << msg.str();
+      return loaded;
+    }
+  }
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "asset_pack.h"
+#include "tiny_obj_loader.h"
+
+namespace ppgso {
+  namespace mesh {
+
+    /*!
+     * Interleaved vertex as stored in GPU buffers and mesh caches.
+     */
+    struct Vertex {
+      glm::vec3 position;
+      glm::vec2 texCoord;
+      glm::vec3 normal;
+    };
+
+    /*!
+     * Compressed vertex, 12 bytes instead of 32.
+     * Positions are 16bit unsigned normalized relative to the mesh bounds,
+     * normals are octahedral encoded to 2x8bit signed integers in <-127, 127> and texture coordinates are half floats.
+     */
+    struct QuantizedVertex {
+      uint16_t position[3];
+      int8_t normal[2];
+      uint16_t texCoord[2];
+    };
+
+    /*!
+     * Range of indices drawn with a single call, one per shape of the source OBJ file and level of detail.
+     * Indices are relative to baseVertex, indexOffset is counted in indices.
+     */
+    struct Part {
+      uint32_t indexOffset, indexCount;
+      uint32_t baseVertex, vertexCount;
+    };
+
+    /*!
+     * Cluster of at most MESHLET_VERTICES vertices and MESHLET_TRIANGLES triangles of the full resolution level.
+     * Meshlets are contiguous index ranges so visible ones can be drawn with a single multi-draw call.
+     * The bounding sphere and the normal cone allow culling clusters outside the frustum or facing away.
+     */
+    struct Meshlet {
+      uint32_t indexOffset, indexCount, part;
+      float center[3], radius;
+      float coneAxis[3], coneCutoff;
+    };
+
+    const uint32_t MESHLET_VERTICES = 64;
+    const uint32_t MESHLET_TRIANGLES = 124;
+
+    /*!
+     * Non-owning view of geometry ready to be uploaded to the GPU.
+     * Parts are stored per level of detail, part p of level l is parts[l * partCount + p].
+     * All levels share the vertices, lodErrors holds the geometric error of each level in model units.
+     */
+    struct Geometry {
+      const Vertex *vertices = nullptr;
+      uint32_t vertexCount = 0;
+      const void *indices = nullptr;
+      uint32_t indexCount = 0;
+      uint32_t indexSize = sizeof(uint32_t);
+      const Part *parts = nullptr;
+      uint32_t partCount = 0;
+      const float *lodErrors = nullptr;
+      uint32_t lodCount = 0;
+      const Meshlet *meshlets = nullptr;
+      uint32_t meshletCount = 0;
+      glm::vec3 min{0}, max{0};
+    };
+
+    /*!
+     * Geometry owned by CPU memory, usually built from parsed OBJ shapes.
+     * Only one of the index vectors is used, 16bit indices are preferred when all parts fit.
+     */
+    struct MeshData {
+      std::vector<Vertex> vertices;
+      std::vector<uint32_t> indices;
+      std::vector<uint16_t> shortIndices;
+      std::vector<Part> parts;
+      std::vector<float> lodErrors;
+      std::vector<Meshlet> meshlets;
+      glm::vec3 min{0}, max{0};
+
+      /*!
+       * Get view of the data for uploading or saving.
+       *
+       * @return - Geometry pointing into the vectors of this object.
+       */
+      Geometry view() const;
+    };
+
+    /*!
+     * Convert OBJ shapes to interleaved geometry and compute bounds.
+     * Triangles of each part are reordered for the post-transform vertex cache and to reduce overdraw,
+     * vertices are reordered for sequential fetch and 16bit indices are used when possible.
+     * A chain of simplified levels of detail is generated for every part (see mesh_simplify.h)
+     * and the full resolution level is split into meshlets.
+     *
+     * @param shapes - Shapes loaded by tinyobj.
+     * @return - Geometry with one part per non-empty shape.
+     */
+    MeshData build(const std::vector<tinyobj::shape_t> &shapes);
+
+    /*!
+     * Compress vertices to the quantized format.
+     * The original position is decoded as position * scale + offset.
+     *
+     * @param geometry - Geometry to compress.
+     * @param scale - Output scale of the decoded position.
+     * @param offset - Output offset of the decoded position.
+     * @return - Quantized vertices in the same order as the geometry.
+     */
+    std::vector<QuantizedVertex> quantize(const Geometry &geometry, glm::vec3 &scale, glm::vec3 &offset);
+
+    /*!
+     * Get the path of the cache that belongs to an OBJ file.
+     *
+     * @param obj - File path to the OBJ file.
+     * @return - Cache path next to the OBJ file.
+     */
+    std::string cachePath(const std::string &obj);
+
+    /*!
+     * Save geometry as binary mesh cache.
+     *
+     * @param geometry - Geometry to save.
+     * @param source - Stamp of the source OBJ file, compared when the cache is loaded.
+     * @param path - Name of the cache file.
+     */
+    void saveCache(const Geometry &geometry, const pack::Stamp &source, const std::string &path);
+
+    /*!
+     * Map binary mesh cache into memory, from an asset pack or a loose file.
+     * The returned geometry points directly into the mapping.
+     *
+     * @param path - Name of the cache file.
+     * @param source - Stamp of the source OBJ file, nullptr accepts any cache. A cache from the same pack as
+     *                 its source is accepted, otherwise the stamp must match the one the cache was saved with.
+     * @param geometry - Output geometry, valid while the returned mapping lives.
+     * @return - Mapping of the cache or nullptr when the cache is missing, invalid or stale.
+     */
+    std::unique_ptr<pack::File> loadCache(const std::string &path, const pack::Stamp *source, Geometry &geometry);
+
+    /*!
+     * Geometry read into CPU memory and ready to be uploaded.
+     * Moving the object keeps the geometry view valid, it points either into the cache mapping or into data.
+     */
+    struct Loaded {
+      std::unique_ptr<pack::File> cache;
+      MeshData data;
+      std::vector<tinyobj::shape_t> shapes;
+      std::vector<tinyobj::material_t> materials;
+      Geometry geometry;
+    };
+
+    /*!
+     * Read geometry of an OBJ file without touching OpenGL, so it can run on any thread.
+     * The binary cache is mapped when it matches the OBJ file, otherwise the OBJ file is parsed
+     * and the cache is regenerated.
+     *
+     * @param obj - File path to the OBJ file.
+     * @return - Geometry ready for upload.
+     */
+    Loaded load(const std::string &obj);
+  }
+}
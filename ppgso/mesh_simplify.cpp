@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+#include "mesh_simplify.h"
+
+namespace ppgso {
+  namespace mesh {
+
+    namespace {
+      // Boundary edges are much more expensive to move than interior ones
+      const double BORDER_WEIGHT = 10.0;
+      // Reject collapses that rotate an adjacent triangle by more than ~75 degrees
+      const float FLIP_THRESHOLD = 0.25f;
+      const int MAX_PASSES = 64;
+
+      enum class VertexKind : uint8_t {
+        Manifold, // Interior vertex, can collapse anywhere
+        Border,   // Open boundary, can only collapse along the boundary
+        Seam,     // Two vertices share the position, both collapse along the seam
+        Locked    // Non-manifold or complex seam, never collapses
+      };
+
+      /*!
+       * Quadric error of a point against a set of weighted planes.
+       * Symmetric 3x3 matrix A, vector b and constant c so that error(p) = p^T A p + 2 b.p + c.
+       */
+      struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0, c = 0, weight = 0;
+
+        void addPlane(const glm::dvec3 &normal, double distance, double w) {
+          a00 += w * normal.x * normal.x;
+          a01 += w * normal.x * normal.y;
+          a02 += w * normal.x * normal.z;
+          a11 += w * normal.y * normal.y;
+          a12 += w * normal.y * normal.z;
+          a22 += w * normal.z * normal.z;
+          b0 += w * normal.x * distance;
+          b1 += w * normal.y * distance;
+          b2 += w * normal.z * distance;
+          c += w * distance * distance;
+          weight += w;
+        }
+
+        void add(const Quadric &q) {
+          a00 += q.a00; a01 += q.a01; a02 += q.a02;
+          a11 += q.a11; a12 += q.a12; a22 += q.a22;
+          b0 += q.b0; b1 += q.b1; b2 += q.b2;
+          c += q.c;
+          weight += q.weight;
+        }
+
+        // Weighted mean squared distance to the planes
+        double error(const glm::vec3 &point) const {
+          double x = point.x, y = point.y, z = point.z;
+          double result = x * x * a00 + y * y * a11 + z * z * a22 +
+                          2 * (x * y * a01 + x * z * a02 + y * z * a12) +
+                          2 * (x * b0 + y * b1 + z * b2) + c;
+          return weight > 0 ? std::max(result / weight, 0.0) : 0.0;
+        }
+      };
+
+      struct PositionHash {
+        size_t operator()(const glm::vec3 &position) const {
+          // Adding zero turns -0 into +0, they compare equal so they must hash equal
+          glm::vec3 normalized = position + 0.0f;
+          uint32_t bits[3];
+          memcpy(bits, &normalized, sizeof(bits));
+          return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+      };
+
+      struct AttributeKey {
+        uint32_t position;
+        glm::vec2 texCoord;
+
+        bool operator==(const AttributeKey &other) const {
+          return position == other.position && texCoord == other.texCoord;
+        }
+      };
+
+      struct AttributeHash {
+        size_t operator()(const AttributeKey &key) const {
+          glm::vec2 normalized = key.texCoord + 0.0f;
+          uint32_t bits[2];
+          memcpy(bits, &normalized, sizeof(bits));
+          return (key.position * 73856093u) ^ (bits[0] * 19349663u) ^ (bits[1] * 83492791u);
+        }
+      };
+
+      uint64_t edgeKey(uint32_t a, uint32_t b) {
+        return (uint64_t) a << 32 | b;
+      }
+
+      /*!
+       * Directed half-edges of a triangle list sorted for twin lookup.
+       */
+      struct HalfEdges {
+        std::vector<uint64_t> edges;
+
+        template<typename Map>
+        void build(const std::vector<uint32_t> &indices, Map map) {
+          edges.clear();
+          edges.reserve(indices.size());
+          for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int k = 0; k < 3; k++)
+              edges.push_back(edgeKey(map(indices[i + k]), map(indices[i + (k + 1) % 3])));
+          }
+          std::sort(edges.begin(), edges.end());
+        }
+
+        size_t count(uint32_t a, uint32_t b) const {
+          auto range = std::equal_range(edges.begin(), edges.end(), edgeKey(a, b));
+          return (size_t) (range.second - range.first);
+        }
+
+        bool hasTwin(uint32_t a, uint32_t b) const {
+          return count(b, a) > 0;
+        }
+      };
+
+      struct Collapse {
+        uint32_t from, to;
+        double cost;
+      };
+    }
+
+    std::vector<uint32_t> simplify(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &input,
+                                   size_t targetIndexCount, float &error, const std::vector<bool> &locked) {
+      auto vertexCount = (uint32_t) vertices.size();
+      std::vector<uint32_t> indices = input;
+      error = 0;
+
+      // Weld vertices by position and by position with texture coordinate, normals are allowed to differ (hard edges).
+      // Attribute canonical vertices sharing a position are linked into the wedge ring,
+      // vertices sharing the attribute canonical vertex are linked into the sibling ring.
+      std::vector<uint32_t> remap(vertexCount), attribute(vertexCount), wedge(vertexCount), sibling(vertexCount);
+      std::unordered_map<glm::vec3, uint32_t, PositionHash> positions;
+      std::unordered_map<AttributeKey, uint32_t, AttributeHash> attributes;
+      for (uint32_t v = 0; v < vertexCount; v++) {
+        auto &position = vertices[v].position;
+        remap[v] = positions.emplace(position, v).first->second;
+
+        auto found = attributes.emplace(AttributeKey{remap[v], vertices[v].texCoord}, v);
+        auto canonical = found.first->second;
+        attribute[v] = canonical;
+        sibling[v] = found.second ? v : sibling[canonical];
+        if (!found.second) sibling[canonical] = v;
+
+        wedge[v] = v;
+        if (found.second && remap[v] != v) {
+          wedge[v] = wedge[remap[v]];
+          wedge[remap[v]] = v;
+        }
+      }
+      auto position = [&](uint32_t v) { return remap[v]; };
+      auto seam = [&](uint32_t v) { return attribute[v]; };
+
+      // Classify vertices using half-edges on both the position and the attribute level
+      HalfEdges positionEdges, seamEdges;
+      positionEdges.build(indices, position);
+      seamEdges.build(indices, seam);
+
+      std::vector<uint8_t> openOut(vertexCount, 0), openIn(vertexCount, 0), nonManifold(vertexCount, 0);
+      std::vector<uint8_t> seamOut(vertexCount, 0), seamIn(vertexCount, 0);
+      for (size_t i = 0; i < positionEdges.edges.size(); i++) {
+        auto a = (uint32_t) (positionEdges.edges[i] >> 32), b = (uint32_t) positionEdges.edges[i];
+        if (i > 0 && positionEdges.edges[i] == positionEdges.edges[i - 1]) nonManifold[a] = nonManifold[b] = 1;
+        if (!positionEdges.hasTwin(a, b)) {
+          openOut[a]++;
+          openIn[b]++;
+        }
+      }
+      for (auto edge : seamEdges.edges) {
+        auto a = (uint32_t) (edge >> 32), b = (uint32_t) edge;
+        if (!seamEdges.hasTwin(a, b)) {
+          seamOut[a]++;
+          seamIn[b]++;
+        }
+      }
+
+      // Kinds are stored for attribute canonical vertices
+      std::vector<VertexKind> kind(vertexCount, VertexKind::Locked);
+      for (uint32_t v = 0; v < vertexCount; v++) {
+        if (attribute[v] != v) continue;
+        auto r = remap[v];
+        bool single = wedge[v] == v;
+        bool pair = !single && wedge[wedge[v]] == v;
+        if (nonManifold[r]) continue;
+        if (!locked.empty()) {
+          // Any locked vertex of the position locks the whole position
+          bool fixed = false;
+          auto w = v;
+          do {
+            auto u = w;
+            do {
+              fixed = fixed || locked[u];
+              u = sibling[u];
+            } while (u != w);
+            w = wedge[w];
+          } while (w != v);
+          if (fixed) continue;
+        }
+        if (single && openOut[r] == 0 && openIn[r] == 0)
+          kind[v] = VertexKind::Manifold;
+        else if (single && openOut[r] == 1 && openIn[r] == 1)
+          kind[v] = VertexKind::Border;
+        else if (pair && openOut[r] == 0 && openIn[r] == 0 && seamOut[v] == 1 && seamIn[v] == 1)
+          kind[v] = VertexKind::Seam;
+      }
+
+      // Quadrics of the triangle planes weighted by area, open edges get a perpendicular plane to keep them in place
+      std::vector<Quadric> quadrics(vertexCount);
+      for (size_t i = 0; i < indices.size(); i += 3) {
+        glm::dvec3 p[3] = {vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position};
+        auto normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        auto area = glm::length(normal);
+        if (area == 0) continue;
+        normal /= area;
+
+        Quadric plane;
+        plane.addPlane(normal, -glm::dot(normal, p[0]), area * 0.5);
+        for (int k = 0; k < 3; k++) quadrics[remap[indices[i + k]]].add(plane);
+
+        for (int k = 0; k < 3; k++) {
+          auto a = attribute[indices[i + k]], b = attribute[indices[i + (k + 1) % 3]];
+          if (seamEdges.hasTwin(a, b)) continue;
+          auto edge = p[(k + 1) % 3] - p[k];
+          auto length = glm::length(edge);
+          if (length == 0) continue;
+          auto edgeNormal = glm::normalize(glm::cross(edge, normal));
+          Quadric border;
+          border.addPlane(edgeNormal, -glm::dot(edgeNormal, p[k]), length * length * BORDER_WEIGHT);
+          quadrics[remap[a]].add(border);
+          quadrics[remap[b]].add(border);
+        }
+      }
+
+      auto openEdge = [](const HalfEdges &edges, uint32_t a, uint32_t b) {
+        return (edges.count(a, b) && !edges.hasTwin(a, b)) || (edges.count(b, a) && !edges.hasTwin(b, a));
+      };
+
+      // Both arguments are attribute canonical vertices
+      auto canCollapse = [&](uint32_t from, uint32_t to) {
+        if (remap[from] == remap[to]) return false;
+        switch (kind[from]) {
+          case VertexKind::Manifold:
+            return true;
+          case VertexKind::Border:
+            return openEdge(positionEdges, remap[from], remap[to]);
+          case VertexKind::Seam:
+            return kind[to] == VertexKind::Seam && openEdge(seamEdges, from, to);
+          default:
+            return false;
+        }
+      };
+
+      std::vector<uint32_t> collapse(vertexCount), adjacencyOffsets, adjacency, neighbors;
+      std::vector<uint8_t> frozen(vertexCount);
+      std::vector<Collapse> candidates;
+
+      for (int pass = 0; pass < MAX_PASSES && indices.size() > targetIndexCount; pass++) {
+        // Edge classification changes as the mesh gets coarser
+        if (pass > 0) {
+          positionEdges.build(indices, position);
+          seamEdges.build(indices, seam);
+        }
+
+        // Triangles adjacent to each position for the flip and link tests
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (auto index : indices) adjacencyOffsets[remap[index] + 1]++;
+        for (uint32_t v = 0; v < vertexCount; v++) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(indices.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) adjacency[fill[remap[indices[i]]]++] = (uint32_t) (i / 3);
+
+        // Cheapest direction of every edge
+        candidates.clear();
+        for (size_t i = 0; i < indices.size(); i += 3) {
+          for (int k = 0; k < 3; k++) {
+            auto a = attribute[indices[i + k]], b = attribute[indices[i + (k + 1) % 3]];
+            auto quadric = quadrics[remap[a]];
+            quadric.add(quadrics[remap[b]]);
+            auto costAB = canCollapse(a, b) ? quadric.error(vertices[b].position) : std::numeric_limits<double>::max();
+            auto costBA = canCollapse(b, a) ? quadric.error(vertices[a].position) : std::numeric_limits<double>::max();
+            if (costAB == std::numeric_limits<double>::max() && costBA == std::numeric_limits<double>::max()) continue;
+            if (costAB <= costBA)
+              candidates.push_back({a, b, costAB});
+            else
+              candidates.push_back({b, a, costBA});
+          }
+        }
+        if (candidates.empty()) break;
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse &a, const Collapse &b) {
+          return a.cost < b.cost;
+        });
+
+        // Interior collapses remove two triangles each
+        auto budget = std::max<size_t>((indices.size() - targetIndexCount) / 6, 1);
+        size_t applied = 0;
+        for (uint32_t v = 0; v < vertexCount; v++) collapse[v] = v;
+        std::fill(frozen.begin(), frozen.end(), 0);
+
+        auto flips = [&](uint32_t rf, uint32_t rt, const glm::vec3 &target) {
+          for (auto i = adjacencyOffsets[rf]; i < adjacencyOffsets[rf + 1]; i++) {
+            auto t = adjacency[i] * 3;
+            uint32_t r[3] = {remap[indices[t]], remap[indices[t + 1]], remap[indices[t + 2]]};
+            if (r[0] == rt || r[1] == rt || r[2] == rt) continue;
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; k++) {
+              p[k] = vertices[indices[t + k]].position;
+              q[k] = r[k] == rf ? target : p[k];
+            }
+            auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            auto after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= FLIP_THRESHOLD * glm::length(before) * glm::length(after)) return true;
+          }
+          return false;
+        };
+
+        // Link condition, the positions can only share the neighbors of the triangles on the collapsed edge
+        auto pinches = [&](uint32_t rf, uint32_t rt) {
+          neighbors.clear();
+          size_t shared = 0;
+          for (auto i = adjacencyOffsets[rf]; i < adjacencyOffsets[rf + 1]; i++) {
+            auto t = adjacency[i] * 3;
+            bool onEdge = false;
+            for (int k = 0; k < 3; k++) onEdge = onEdge || remap[indices[t + k]] == rt;
+            if (onEdge) shared++;
+            for (int k = 0; k < 3; k++) {
+              auto r = remap[indices[t + k]];
+              if (r != rf && r != rt) neighbors.push_back(r);
+            }
+          }
+          std::sort(neighbors.begin(), neighbors.end());
+          neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+          size_t common = 0;
+          for (auto i = adjacencyOffsets[rt]; i < adjacencyOffsets[rt + 1]; i++) {
+            auto t = adjacency[i] * 3;
+            for (int k = 0; k < 3; k++) {
+              auto r = remap[indices[t + k]];
+              auto found = std::lower_bound(neighbors.begin(), neighbors.end(), r);
+              if (found != neighbors.end() && *found == r) {
+                common++;
+                // Count every common neighbor only once
+                neighbors.erase(found);
+              }
+            }
+          }
+          return common > shared;
+        };
+
+        // Map every vertex of the collapsed attribute group to the target vertex with the closest normal
+        auto collapseGroup = [&](uint32_t from, uint32_t to) {
+          auto v = from;
+          do {
+            auto best = to;
+            auto similarity = -2.0f;
+            auto w = to;
+            do {
+              auto d = glm::dot(vertices[v].normal, vertices[w].normal);
+              if (d > similarity) {
+                similarity = d;
+                best = w;
+              }
+              w = sibling[w];
+            } while (w != to);
+            collapse[v] = best;
+            v = sibling[v];
+          } while (v != from);
+        };
+
+        for (auto &candidate : candidates) {
+          if (applied >= budget) break;
+          auto from = candidate.from, to = candidate.to;
+          auto rf = remap[from], rt = remap[to];
+          if (frozen[rf] || frozen[rt] || flips(rf, rt, vertices[to].position) || pinches(rf, rt)) continue;
+
+          // The other side of a seam collapses onto the matching vertex of the target
+          if (kind[from] == VertexKind::Seam) {
+            auto fromPair = wedge[from], toPair = wedge[to];
+            if (!seamEdges.count(fromPair, toPair) && !seamEdges.count(toPair, fromPair)) continue;
+            collapseGroup(fromPair, toPair);
+          }
+          collapseGroup(from, to);
+          quadrics[rt].add(quadrics[rf]);
+          error = std::max(error, (float) candidate.cost);
+          applied++;
+
+          // Freeze the neighborhood so tests of later collapses in this pass stay valid
+          for (auto i = adjacencyOffsets[rf]; i < adjacencyOffsets[rf + 1]; i++) {
+            auto t = adjacency[i] * 3;
+            for (int k = 0; k < 3; k++) frozen[remap[indices[t + k]]] = 1;
+          }
+          for (auto i = adjacencyOffsets[rt]; i < adjacencyOffsets[rt + 1]; i++) {
+            auto t = adjacency[i] * 3;
+            for (int k = 0; k < 3; k++) frozen[remap[indices[t + k]]] = 1;
+          }
+        }
+        if (applied == 0) break;
+
+        // Apply collapses and drop triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+          auto a = collapse[indices[i]], b = collapse[indices[i + 1]], c = collapse[indices[i + 2]];
+          if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a]) continue;
+          indices[write++] = a;
+          indices[write++] = b;
+          indices[write++] = c;
+        }
+        indices.resize(write);
+      }
+
+      error = std::sqrt(error);
+      return indices;
+    }
+  }
+}
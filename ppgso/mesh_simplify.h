@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "mesh_cache.h"
+
+namespace ppgso {
+  namespace mesh {
+
+    /*!
+     * Simplify triangle list by collapsing edges ordered by quadric error metrics (Garland and Heckbert 1997).
+     * Vertices are collapsed onto existing vertices so the vertex buffer is shared by all levels of detail.
+     * Vertices on open borders only slide along the border and vertices on attribute seams (UV or normal)
+     * collapse in pairs along the seam, so the result has no cracks. Non-manifold vertices are never moved.
+     *
+     * @param vertices - Vertices referenced by the indices.
+     * @param indices - Triangle list to simplify.
+     * @param targetIndexCount - Desired number of indices, the result may be larger when the mesh cannot be simplified further.
+     * @param error - Output estimate of the geometric error in model units.
+     * @param locked - Optional flags of vertices that must not move, e.g. borders shared with other parts.
+     * @return - Simplified triangle list.
+     */
+    std::vector<uint32_t> simplify(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                                   size_t targetIndexCount, float &error,
+                                   const std::vector<bool> &locked = {});
+  }
+}
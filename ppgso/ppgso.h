@@ -4,14 +4,28 @@
 #include <glm/gtc/random.hpp>
 #include <glm/gtx/compatibility.hpp>
 
+#include "asset_loader.h"
+#include "asset_pack.h"
+#include "dynamic_buffer.h"
+#include "gl_state.h"
+#include "memory_usage.h"
 #include "mesh.h"
+#include "mesh_cache.h"
+#include "profiler.h"
 #include "shader.h"
+#include "shader_library.h"
+#include "uniform_buffer.h"
 #include "image.h"
 #include "image_alpha.h"
 #include "image_bmp.h"
 #include "image_raw.h"
+#include "image_hdr.h"
+#include "image_compressed.h"
 #include "texture.h"
 #include "texture_alpha.h"
+#include "texture_array.h"
+#include "texture_residency.h"
+#include "trace.h"
 #include "window.h"
 
 namespace ppgso {
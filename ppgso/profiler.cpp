@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "profiler.h"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // Frames in the statistics window
+  const size_t WINDOW = 300;
+
+  // Frames between issuing a GPU query and reading its result
+  const size_t LATENCY = 3;
+
+  // Ring of per frame times
+  struct Samples {
+    std::vector<float> values;
+    size_t next = 0;
+
+    void add(float value) {
+      if (values.size() < WINDOW) {
+        values.push_back(value);
+      } else {
+        values[next] = value;
+        next = (next + 1) % WINDOW;
+      }
+    }
+
+    ppgso::profiler::Summary summarize() const {
+      if (values.empty()) return {0, 0, 0, 0};
+      auto sorted = values;
+      std::sort(sorted.begin(), sorted.end());
+      float sum = 0;
+      for (auto value : sorted) sum += value;
+      auto p99 = (size_t) std::ceil(0.99 * sorted.size()) - 1;
+      return {sorted.front(), sum / sorted.size(), sorted[p99], sorted.size()};
+    }
+  };
+
+  struct Section {
+    const char *name;
+    int parent, depth;
+    std::vector<int> children;
+
+    // Totals of the current frame
+    double cpu = 0;
+    unsigned calls = 0;
+
+    // Queries issued in the last frames, used[slot] of them belong to the frame of the slot
+    std::vector<GLuint> queries[LATENCY];
+    size_t used[LATENCY] = {};
+
+    Samples cpuSamples, gpuSamples;
+  };
+
+  double readSeconds(const char *name) {
+    auto value = std::getenv(name);
+    if (!value) return 0;
+
+    char *end;
+    auto seconds = std::strtod(value, &end);
+    if (*value == '\0' || *end != '\0' || seconds < 0) {
+      std::stringstream msg;
+      msg << "Environment variable " << name << " must be a number of seconds, got " << value;
+      throw std::runtime_error(msg.str());
+    }
+    return seconds;
+  }
+
+  // Sections form a tree below the whole frame, query objects are released with the OpenGL context
+  struct State {
+    State() {
+      Section frame;
+      frame.name = "frame";
+      frame.parent = -1;
+      frame.depth = 0;
+      sections.push_back(frame);
+      start = frameStart = lastReport = Clock::now();
+
+      interval = readSeconds("PPGSO_PROFILE");
+      if (auto file = std::getenv("PPGSO_PROFILE_CSV")) csv = file;
+    }
+
+    std::vector<Section> sections;
+    std::vector<int> stack{0};
+    bool enabled = true, gpuActive = false;
+    unsigned long frame = 0;
+    Clock::time_point start, frameStart, lastReport;
+    double interval = 0;
+    std::string csv;
+  };
+
+  State &state() {
+    static State instance;
+    return instance;
+  }
+
+  double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+
+  int child(State &s, int parent, const char *name) {
+    for (auto index : s.sections[parent].children) {
+      auto existing = s.sections[index].name;
+      if (existing == name || std::strcmp(existing, name) == 0) return index;
+    }
+
+    Section section;
+    section.name = name;
+    section.parent = parent;
+    section.depth = s.sections[parent].depth + 1;
+    s.sections.push_back(section);
+    auto index = (int) s.sections.size() - 1;
+    s.sections[parent].children.push_back(index);
+    return index;
+  }
+
+  std::string path(const State &s, int index) {
+    auto &section = s.sections[index];
+    if (section.parent <= 0) return section.parent < 0 ? "" : section.name;
+    return path(s, section.parent) + "/" + section.name;
+  }
+
+  // Sum the GPU times of a frame, the frame is skipped when any result is not ready yet
+  void collect(Section &section, size_t slot) {
+    auto &queries = section.queries[slot];
+    double total = 0;
+    bool ready = true;
+    for (size_t i = 0; i < section.used[slot] && ready; i++) {
+      GLint available = 0;
+      glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+        total += nanoseconds / 1e6;
+      }
+      ready = available != 0;
+    }
+    if (ready) section.gpuSamples.add((float) total);
+    section.used[slot] = 0;
+  }
+
+  void printSummary(std::ostream &out, const ppgso::profiler::Summary &summary) {
+    if (summary.frames == 0) {
+      out << std::setw(9) << "-" << std::setw(9) << "-" << std::setw(9) << "-";
+      return;
+    }
+    out << std::setw(9) << summary.min << std::setw(9) << summary.avg << std::setw(9) << summary.p99;
+  }
+
+  void printSection(const State &s, int index, std::ostream &out) {
+    auto &section = s.sections[index];
+    if (section.cpuSamples.values.empty()) return;
+
+    auto name = std::string((size_t) section.depth * 2, ' ') + section.name;
+    out << std::left << std::setw(32) << name << std::right;
+    printSummary(out, section.cpuSamples.summarize());
+    printSummary(out, section.gpuSamples.summarize());
+    out << std::endl;
+
+    for (auto child : section.children)
+      printSection(s, child, out);
+  }
+
+  void writeCsv(const State &s) {
+    std::ofstream out{s.csv, std::ios::app};
+    if (!out) throw std::runtime_error("Failed to open profiler CSV file " + s.csv);
+
+    if (out.tellp() == 0)
+      out << "time,section,frames,cpu_min,cpu_avg,cpu_p99,gpu_min,gpu_avg,gpu_p99" << std::endl;
+
+    auto time = std::chrono::duration<double>(Clock::now() - s.start).count();
+    for (size_t i = 0; i < s.sections.size(); i++) {
+      auto cpu = s.sections[i].cpuSamples.summarize();
+      auto gpu = s.sections[i].gpuSamples.summarize();
+      if (cpu.frames == 0) continue;
+      out << time << "," << (i == 0 ? "frame" : path(s, (int) i)) << "," << cpu.frames << ","
+          << cpu.min << "," << cpu.avg << "," << cpu.p99 << ",";
+      if (gpu.frames > 0)
+        out << gpu.min << "," << gpu.avg << "," << gpu.p99 << std::endl;
+      else
+        out << ",," << std::endl;
+    }
+  }
+}
+
+ppgso::profiler::Scope::Scope(const char *name, bool gpu) : section{-1} {
+  auto &s = state();
+  if (!s.enabled) return;
+
+  section = child(s, s.stack.back(), name);
+  s.stack.push_back(section);
+
+  // GL_TIME_ELAPSED queries can not be nested, the outermost GPU scope is measured
+  if (gpu && !s.gpuActive) {
+    auto &current = s.sections[section];
+    auto slot = s.frame % LATENCY;
+    auto &queries = current.queries[slot];
+    if (current.used[slot] == queries.size()) {
+      GLuint created;
+      glGenQueries(1, &created);
+      queries.push_back(created);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[current.used[slot]++]);
+    s.gpuActive = query = true;
+  }
+
+  start = Clock::now();
+}
+
+ppgso::profiler::Scope::~Scope() {
+  if (section < 0) return;
+  auto elapsed = Clock::now() - start;
+
+  auto &s = state();
+  auto &current = s.sections[section];
+  current.cpu += milliseconds(elapsed);
+  current.calls++;
+  if (query) {
+    glEndQuery(GL_TIME_ELAPSED);
+    s.gpuActive = false;
+  }
+  s.stack.pop_back();
+}
+
+void ppgso::profiler::setEnabled(bool enabled) {
+  state().enabled = enabled;
+}
+
+void ppgso::profiler::setReport(double seconds, const std::string &csv) {
+  auto &s = state();
+  s.interval = seconds;
+  s.csv = csv;
+}
+
+void ppgso::profiler::endFrame() {
+  auto &s = state();
+  auto now = Clock::now();
+
+  // The first frame includes the setup of the program
+  auto &frame = s.sections.front();
+  if (s.enabled && s.frame > 0) {
+    frame.cpu = milliseconds(now - s.frameStart);
+    frame.calls = 1;
+  }
+  s.frameStart = now;
+
+  // Queries of the slot the next frame reuses were issued LATENCY - 1 frames ago
+  auto slot = (s.frame + 1) % LATENCY;
+  for (auto &section : s.sections) {
+    if (section.calls > 0) section.cpuSamples.add((float) section.cpu);
+    section.cpu = 0;
+    section.calls = 0;
+    if (section.used[slot] > 0) collect(section, slot);
+  }
+  s.frame++;
+
+  if (s.interval > 0 && std::chrono::duration<double>(now - s.lastReport).count() >= s.interval) {
+    report(std::cout);
+    if (!s.csv.empty()) writeCsv(s);
+    s.lastReport = now;
+  }
+}
+
+ppgso::profiler::Summary ppgso::profiler::getSummary(const std::string &path, bool gpu) {
+  auto &s = state();
+  int index = 0;
+  std::stringstream names{path};
+  std::string name;
+  while (std::getline(names, name, '/')) {
+    auto &children = s.sections[index].children;
+    auto found = std::find_if(children.begin(), children.end(), [&](int child) { return name == s.sections[child].name; });
+    if (found == children.end()) return {0, 0, 0, 0};
+    index = *found;
+  }
+  auto &section = s.sections[index];
+  return gpu ? section.gpuSamples.summarize() : section.cpuSamples.summarize();
+}
+
+void ppgso::profiler::report(std::ostream &out) {
+  auto &s = state();
+  auto flags = out.flags();
+  auto precision = out.precision();
+  out << std::fixed << std::setprecision(2);
+  out << std::left << std::setw(32) << "Section (ms)" << std::right
+      << std::setw(9) << "CPU min" << std::setw(9) << "avg" << std::setw(9) << "p99"
+      << std::setw(9) << "GPU min" << std::setw(9) << "avg" << std::setw(9) << "p99" << std::endl;
+  printSection(s, 0, out);
+  out.flags(flags);
+  out.precision(precision);
+}
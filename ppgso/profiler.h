@@ -0,0 +1,90 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace ppgso {
+
+  /*!
+   * Frame profiler with nested CPU scopes and GPU timer queries.
+   * Scopes with the same name under the same parent form a section, their times are summed per frame.
+   * GPU times are measured by GL_TIME_ELAPSED queries that are read a few frames later only when available,
+   * so profiling never stalls the pipeline. Statistics cover a rolling window of frames.
+   *
+   * A report is printed periodically when the PPGSO_PROFILE environment variable holds the interval in seconds,
+   * PPGSO_PROFILE_CSV names a file the reports are appended to.
+   * All functions must be called on the render thread.
+   */
+  namespace profiler {
+
+    /*!
+     * Minimum, average and 99th percentile of a section over the window in milliseconds.
+     */
+    struct Summary {
+      float min, avg, p99;
+      size_t frames;
+    };
+
+    /*!
+     * Measures the time from construction to destruction.
+     */
+    class Scope {
+    public:
+      /*!
+       * Open scope nested in the currently open scope.
+       *
+       * @param name - Name of the section, must outlive the profiler, usually a string literal.
+       * @param gpu - Also measure GPU time of the commands issued in the scope. GPU scopes do not nest,
+       *              inside another GPU scope only CPU time is measured.
+       */
+      explicit Scope(const char *name, bool gpu = false);
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+      ~Scope();
+
+    private:
+      int section;
+      bool query = false;
+      std::chrono::steady_clock::time_point start;
+    };
+
+    /*!
+     * Enable or disable profiling, disabled scopes cost a single branch.
+     *
+     * @param enabled - True to profile (default).
+     */
+    void setEnabled(bool enabled);
+
+    /*!
+     * Set interval of the periodic report.
+     *
+     * @param seconds - Seconds between reports, 0 disables the report.
+     * @param csv - File to append the reports to, empty for console only.
+     */
+    void setReport(double seconds, const std::string &csv = "");
+
+    /*!
+     * Finish the frame, collect GPU times that became available and print the periodic report when due.
+     * Called by Window::pollEvents after swapping buffers.
+     */
+    void endFrame();
+
+    /*!
+     * Get statistics of a section.
+     *
+     * @param path - Section names from the top level separated by '/', for example "render/post-process".
+     * @param gpu - True for GPU times.
+     * @return - Statistics, frames is 0 when the section was not measured.
+     */
+    Summary getSummary(const std::string &path, bool gpu = false);
+
+    /*!
+     * Print the statistics of all sections as an indented tree.
+     *
+     * @param out - Stream to print to.
+     */
+    void report(std::ostream &out);
+  }
+}
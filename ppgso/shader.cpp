@@ -1,5 +1,16 @@
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -8,82 +19,348 @@
 #include "texture.h"
 #include "texture_alpha.h"
 #include "shader.h"
+#include "gl_state.h"
 
+// Directory with program binaries from previous runs, empty when disabled
+static std::string cacheDirectory = "shader_cache";
 
-ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
-  // Create shaders
-  auto vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-  auto fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+static ppgso::Shader::Statistics statistics;
+
+// Version of the program binary cache file format
+static const uint32_t BINARY_VERSION = 1;
+
+// Header of a program binary cache file, followed by the binary itself
+struct BinaryHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t driverHash;
+  uint64_t sourceHash;
+  uint32_t format;
+  uint32_t length;
+};
+
+// Linked program shared by all Shader objects created from the same sources
+struct ppgso::Shader::Program {
+  GLuint id = 0;
+  // Shaders compiled from source, kept until the link status is checked
+  GLuint vertexShader = 0, fragmentShader = 0;
+  uint64_t hash = 0;
+  bool ready = false;
+  std::unordered_map<std::string, UniformInfo> uniforms;
+
+  ~Program() {
+    if (vertexShader) glDeleteShader(vertexShader);
+    if (fragmentShader) glDeleteShader(fragmentShader);
+    gl::deleteProgram(id);
+  }
+};
+
+// FNV-1a hash of a string, chained through "hash"
+static uint64_t hashString(const std::string &text, uint64_t hash = 14695981039346656037ull) {
+  for (auto c : text) {
+    hash ^= (unsigned char) c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// Binaries are only valid for the driver that produced them
+static uint64_t driverHash() {
+  static uint64_t hash = [] {
+    auto text = [](GLenum name) {
+      auto value = glGetString(name);
+      return value ? std::string{(const char *) value} : std::string{};
+    };
+    return hashString(text(GL_VERSION), hashString(text(GL_RENDERER), hashString(text(GL_VENDOR))));
+  }();
+  return hash;
+}
+
+static bool binariesSupported() {
+  static bool supported = [] {
+    if (!GLEW_ARB_get_program_binary) return false;
+    auto formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+  }();
+  return supported;
+}
+
+// With parallel compilation the driver compiles in the background and only checking the status waits
+static bool parallelCompile() {
+  static bool supported = [] {
+    if (GLEW_ARB_parallel_shader_compile) {
+      glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+      return true;
+    }
+    // The KHR variant compiles with a driver chosen number of threads by default
+    auto count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (auto i = 0; i < count; i++) {
+      auto name = (const char *) glGetStringi(GL_EXTENSIONS, (GLuint) i);
+      if (name && std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0) return true;
+    }
+    return false;
+  }();
+  return supported;
+}
+
+static std::string binaryPath(uint64_t sourceHash) {
+  std::stringstream path;
+  path << cacheDirectory << "/" << std::hex;
+  path.width(16);
+  path.fill('0');
+  path << sourceHash << ".bin";
+  return path.str();
+}
+
+static bool loadBinary(GLuint program, uint64_t sourceHash) {
+  if (cacheDirectory.empty() || !binariesSupported()) return false;
+
+  std::ifstream file{binaryPath(sourceHash), std::ios::binary};
+  if (!file) return false;
+
+  BinaryHeader header;
+  if (!file.read((char *) &header, sizeof(header))) return false;
+  if (std::memcmp(header.magic, "PPGS", 4) != 0 || header.version != BINARY_VERSION ||
+      header.driverHash != driverHash() || header.sourceHash != sourceHash)
+    return false;
+
+  std::vector<char> binary(header.length);
+  if (!file.read(binary.data(), (std::streamsize) binary.size())) return false;
+
+  // The driver may still reject the binary, for example after an update that kept the version string
+  glProgramBinary(program, header.format, binary.data(), (GLsizei) binary.size());
   auto result = GL_FALSE;
-  auto info_length = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &result);
+  return result == GL_TRUE;
+}
 
-  // Compile vertex shader
-  auto vertex_shader_code_ptr = vertex_shader_code.c_str();
-  glShaderSource(vertex_shader_id, 1, &vertex_shader_code_ptr, nullptr);
-  glCompileShader(vertex_shader_id);
+static void saveBinary(GLuint program, uint64_t sourceHash) {
+  if (cacheDirectory.empty() || !binariesSupported()) return;
 
-  // Check vertex shader log
-  glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderiv(vertex_shader_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string vertex_shader_log((unsigned int) info_length, ' ');
-    glGetShaderInfoLog(vertex_shader_id, info_length, nullptr,
-                       &vertex_shader_log[0]);
-    std::stringstream msg;
-    msg << "Error Compiling Vertex Shader ..." << std::endl;
-    msg << vertex_shader_log;
-    throw std::runtime_error(msg.str());
+  auto length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+
+  std::vector<char> binary((size_t) length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  BinaryHeader header{{'P', 'P', 'G', 'S'}, BINARY_VERSION, driverHash(), sourceHash, format, (uint32_t) length};
+
+#ifdef _WIN32
+  _mkdir(cacheDirectory.c_str());
+#else
+  mkdir(cacheDirectory.c_str(), 0755);
+#endif
+
+  // Write to a temporary file first so an interrupted run does not leave a truncated binary behind
+  auto path = binaryPath(sourceHash);
+  auto temporary = path + ".tmp";
+  {
+    std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+    file.write((const char *) &header, sizeof(header));
+    file.write(binary.data(), length);
+    if (!file) {
+      std::cerr << "Could not write shader cache " << temporary << std::endl;
+      return;
+    }
   }
+  std::remove(path.c_str());
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    std::cerr << "Could not write shader cache " << path << std::endl;
+}
 
-  // Compile fragment shader
-  auto fragment_shader_code_ptr = fragment_shader_code.c_str();
-  glShaderSource(fragment_shader_id, 1, &fragment_shader_code_ptr, nullptr);
-  glCompileShader(fragment_shader_id);
+ppgso::Shader::Shader(const std::string &vertex_shader_code, const std::string &fragment_shader_code) {
+  auto start = std::chrono::steady_clock::now();
+  shared = acquire(vertex_shader_code, fragment_shader_code);
+  program = shared->id;
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  statistics.milliseconds += elapsed.count();
 
-  // Check fragment shader log
-  glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &result);
-  if (result == GL_FALSE) {
-    glGetShaderiv(fragment_shader_id, GL_INFO_LOG_LENGTH, &info_length);
-    std::string fragment_shader_log((unsigned long) info_length, ' ');
-    glGetShaderInfoLog(fragment_shader_id, info_length, nullptr,
-                       &fragment_shader_log[0]);
-    std::stringstream msg;
-    msg << "Error Compiling Fragment Shader ..." << std::endl;
-    msg << fragment_shader_log << std::endl;
-    throw std::runtime_error(msg.str());
+  // Without parallel compilation nothing is gained by waiting, check and bind the program right away
+  if (!parallelCompile()) use();
+}
+
+std::shared_ptr<ppgso::Shader::Program> ppgso::Shader::acquire(const std::string &vertex_shader_code,
+                                                              const std::string &fragment_shader_code) {
+  // Reuse program linked from the same sources if it is still alive
+  static std::unordered_map<uint64_t, std::weak_ptr<Program>> programs;
+  auto hash = hashString(fragment_shader_code, hashString(vertex_shader_code + '\0'));
+  auto &existing = programs[hash];
+  if (auto program = existing.lock()) {
+    statistics.reused++;
+    return program;
   }
 
-  // Create and link the program
-  auto program_id = glCreateProgram();
-  glAttachShader(program_id, vertex_shader_id);
-  glAttachShader(program_id, fragment_shader_id);
-  glBindFragDataLocation(program_id, 0, "FragmentColor");
-  glLinkProgram(program_id);
+  auto result = std::make_shared<Program>();
+  result->hash = hash;
+  result->id = glCreateProgram();
+  existing = result;
+
+  if (loadBinary(result->id, hash)) {
+    statistics.loaded++;
+    return result;
+  }
+
+  // Compile both shaders and link, the status is checked once the program is needed
+  result->vertexShader = glCreateShader(GL_VERTEX_SHADER);
+  auto vertex_shader_code_ptr = vertex_shader_code.c_str();
+  glShaderSource(result->vertexShader, 1, &vertex_shader_code_ptr, nullptr);
+  glCompileShader(result->vertexShader);
+
+  result->fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+  auto fragment_shader_code_ptr = fragment_shader_code.c_str();
+  glShaderSource(result->fragmentShader, 1, &fragment_shader_code_ptr, nullptr);
+  glCompileShader(result->fragmentShader);
+
+  glAttachShader(result->id, result->vertexShader);
+  glAttachShader(result->id, result->fragmentShader);
+  glBindFragDataLocation(result->id, 0, "FragmentColor");
+  if (binariesSupported()) glProgramParameteri(result->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(result->id);
+
+  statistics.compiled++;
+  return result;
+}
+
+void ppgso::Shader::finish() const {
+  auto start = std::chrono::steady_clock::now();
+  auto result = GL_FALSE;
+  auto info_length = 0;
+
+  if (shared->vertexShader) {
+    // Check vertex shader log
+    glGetShaderiv(shared->vertexShader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderiv(shared->vertexShader, GL_INFO_LOG_LENGTH, &info_length);
+      std::string vertex_shader_log((unsigned int) info_length, ' ');
+      glGetShaderInfoLog(shared->vertexShader, info_length, nullptr,
+                         &vertex_shader_log[0]);
+      std::stringstream msg;
+      msg << "Error Compiling Vertex Shader ..." << std::endl;
+      msg << vertex_shader_log;
+      throw std::runtime_error(msg.str());
+    }
+
+    // Check fragment shader log
+    glGetShaderiv(shared->fragmentShader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderiv(shared->fragmentShader, GL_INFO_LOG_LENGTH, &info_length);
+      std::string fragment_shader_log((unsigned long) info_length, ' ');
+      glGetShaderInfoLog(shared->fragmentShader, info_length, nullptr,
+                         &fragment_shader_log[0]);
+      std::stringstream msg;
+      msg << "Error Compiling Fragment Shader ..." << std::endl;
+      msg << fragment_shader_log << std::endl;
+      throw std::runtime_error(msg.str());
+    }
+  }
 
   // Check program log
-  glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+  glGetProgramiv(program, GL_LINK_STATUS, &result);
   if (result == GL_FALSE) {
-    glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_length);
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_length);
     std::string program_log((unsigned long) info_length, ' ');
-    glGetProgramInfoLog(program_id, info_length, nullptr, &program_log[0]);
+    glGetProgramInfoLog(program, info_length, nullptr, &program_log[0]);
     std::stringstream msg;
     msg << "Error Linking Shader Program ..." << std::endl;
     msg << program_log;
     throw std::runtime_error(msg.str());
   }
-  glDeleteShader(vertex_shader_id);
-  glDeleteShader(fragment_shader_id);
 
-  program = program_id;
-  use();
-}
+  if (shared->vertexShader) {
+    glDetachShader(program, shared->vertexShader);
+    glDetachShader(program, shared->fragmentShader);
+    glDeleteShader(shared->vertexShader);
+    glDeleteShader(shared->fragmentShader);
+    shared->vertexShader = shared->fragmentShader = 0;
+    saveBinary(program, shared->hash);
+  }
+
+  // Cache locations and types of all active uniforms
+  auto &uniforms = shared->uniforms;
+  auto uniform_count = 0, max_name_length = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniform_count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+  std::string name_buffer((unsigned long) max_name_length + 1, ' ');
+  auto add = [&uniforms](const std::string &name, GLint location, GLenum type) -> UniformInfo & {
+    auto &info = uniforms[name];
+    info.location = location;
+    info.type = type;
+    return info;
+  };
+  for (auto i = 0; i < uniform_count; i++) {
+    GLint size = 0, name_length = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program, (GLuint) i, (GLsizei) name_buffer.size(), &name_length, &size, &type, &name_buffer[0]);
+    std::string name = name_buffer.substr(0, (unsigned long) name_length);
+    auto location = glGetUniformLocation(program, name.c_str());
+    if (location < 0) continue; // Members of uniform blocks
+    auto &first = add(name, location, type);
+
+    // Arrays of basic types are reported as "name[0]", make "name" and the other elements available too
+    if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+      auto base = name.substr(0, name.size() - 3);
+      add(base, location, type).cache = &first;
+      for (auto element = 1; element < size; element++) {
+        auto element_name = base + "[" + std::to_string(element) + "]";
+        add(element_name, glGetUniformLocation(program, element_name.c_str()), type);
+      }
+    }
+  }
 
-ppgso::Shader::~Shader() {
-  glDeleteProgram( program );
+  shared->ready = true;
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  statistics.milliseconds += elapsed.count();
 }
 
+// The program is deleted with the last shader that shares it
+ppgso::Shader::~Shader() = default;
+
 void ppgso::Shader::use() const {
-  glUseProgram(program);
+  if (!shared->ready) finish();
+  gl::useProgram(program);
+}
+
+const ppgso::Shader::UniformInfo &ppgso::Shader::findUniform(const std::string &name) const {
+  if (!shared->ready) finish();
+  auto &uniforms = shared->uniforms;
+  auto found = uniforms.find(name);
+  if (found != uniforms.end()) return found->second;
+
+  // Not reported by the driver, remember the answer so the string is queried only once
+  UniformInfo info;
+  info.location = glGetUniformLocation(program, name.c_str());
+  for (auto &known : uniforms)
+    if (info.location >= 0 && known.second.location == info.location && !known.second.cache)
+      info.cache = &known.second;
+  return uniforms.emplace(name, info).first->second;
+}
+
+void ppgso::Shader::setCacheDirectory(const std::string &directory) {
+  cacheDirectory = directory;
+}
+
+const ppgso::Shader::Statistics &ppgso::Shader::getStatistics() {
+  return statistics;
+}
+
+void ppgso::Shader::checkType(const std::string &name, const UniformInfo &info, GLenum type) {
+  if (info.location < 0 || info.type == 0 || info.type == type) return;
+
+  // Booleans can be set as integers or floats (as glUniform allows) and samplers of any kind through textures
+  if ((type == GL_INT || type == GL_FLOAT) && info.type == GL_BOOL) return;
+  bool sampler = info.type == GL_SAMPLER_2D || info.type == GL_SAMPLER_2D_SHADOW || info.type == GL_SAMPLER_CUBE ||
+                 info.type == GL_SAMPLER_2D_ARRAY || info.type == GL_SAMPLER_3D;
+  if (type == GL_SAMPLER_2D && sampler) return;
+  if (type == GL_INT && sampler) return;
+
+  std::stringstream msg;
+  msg << "Uniform " << name << " has type 0x" << std::hex << info.type
+      << " which does not match the requested type 0x" << type;
+  throw std::runtime_error(msg.str());
 }
 
 GLuint ppgso::Shader::getAttribLocation(const std::string &name) const {
@@ -93,59 +370,125 @@ GLuint ppgso::Shader::getAttribLocation(const std::string &name) const {
 
 GLuint ppgso::Shader::getUniformLocation(const std::string &name) const {
   use();
-  return (GLuint) glGetUniformLocation(program, name.c_str());
+  return (GLuint) findUniform(name).location;
 }
 
 void ppgso::Shader::setUniform(const std::string &name, const Texture &texture, const int id) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform1i(uniform, id);
-  texture.bind(id);
+  setUniform(getUniform<Texture>(name), texture, id);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, const TextureAlpha &texture, const int id) const {
-    use();
-    auto uniform = getUniformLocation(name.c_str());
-    glUniform1i(uniform, id);
-    texture.bind(id);
+  setUniform(getUniform<TextureAlpha>(name), texture, id);
+}
+
+void ppgso::Shader::setUniform(const std::string &name, const TextureArray &texture, const int id) const {
+  setUniform(getUniform<TextureArray>(name), texture, id);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::mat4 matrix) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniformMatrix4fv(uniform, 1, GL_FALSE, value_ptr(matrix));
+  setUniform(getUniform<glm::mat4>(name), matrix);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::mat3 matrix) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniformMatrix3fv(uniform, 1, GL_FALSE, value_ptr(matrix));
+  setUniform(getUniform<glm::mat3>(name), matrix);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, float value) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform1f(uniform, value);
+  setUniform(getUniform<float>(name), value);
+}
+
+void ppgso::Shader::setUniform(const std::string &name, int value) const {
+  setUniform(getUniform<int>(name), value);
+}
+
+void ppgso::Shader::setUniformBlock(const std::string &name, GLuint binding) const {
+  if (!shared->ready) finish();
+  auto index = glGetUniformBlockIndex(program, name.c_str());
+  if (index == GL_INVALID_INDEX) return;
+  glUniformBlockBinding(program, index, binding);
 }
 
 GLuint ppgso::Shader::getProgram() const {
+  if (!shared->ready) finish();
   return program;
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::vec2 vector) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform2fv(uniform, 1, value_ptr(vector));
+  setUniform(getUniform<glm::vec2>(name), vector);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::vec3 vector) const {
-  use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform3fv(uniform, 1, value_ptr(vector));
+  setUniform(getUniform<glm::vec3>(name), vector);
 }
 
 void ppgso::Shader::setUniform(const std::string &name, glm::vec4 vector) const {
+  setUniform(getUniform<glm::vec4>(name), vector);
+}
+
+bool ppgso::Shader::changed(const UniformInfo *info, const void *value, size_t size) {
+  if (!info || info->location < 0) return false;
+  if (info->cache) info = info->cache;
+  if (info->known && std::memcmp(info->value, value, size) == 0) {
+    gl::count(false);
+    return false;
+  }
+  std::memcpy(info->value, value, size);
+  info->known = true;
+  gl::count(true);
+  return true;
+}
+
+void ppgso::Shader::setUniform(Uniform<float> uniform, float value) const {
   use();
-  auto uniform = getUniformLocation(name.c_str());
-  glUniform4fv(uniform, 1, value_ptr(vector));
+  if (changed(uniform.info, &value, sizeof(value))) glUniform1f(uniform.info->location, value);
+}
+
+void ppgso::Shader::setUniform(Uniform<int> uniform, int value) const {
+  use();
+  if (changed(uniform.info, &value, sizeof(value))) glUniform1i(uniform.info->location, value);
+}
+
+void ppgso::Shader::setUniform(Uniform<glm::vec2> uniform, const glm::vec2 &value) const {
+  use();
+  if (changed(uniform.info, &value, sizeof(value))) glUniform2fv(uniform.info->location, 1, value_ptr(value));
+}
+
+void ppgso::Shader::setUniform(Uniform<glm::vec3> uniform, const glm::vec3 &value) const {
+  use();
+  if (changed(uniform.info, &value, sizeof(value))) glUniform3fv(uniform.info->location, 1, value_ptr(value));
+}
+
+void ppgso::Shader::setUniform(Uniform<glm::vec4> uniform, const glm::vec4 &value) const {
+  use();
+  if (changed(uniform.info, &value, sizeof(value))) glUniform4fv(uniform.info->location, 1, value_ptr(value));
+}
+
+void ppgso::Shader::setUniform(Uniform<glm::mat3> uniform, const glm::mat3 &value) const {
+  use();
+  if (changed(uniform.info, &value, sizeof(value)))
+    glUniformMatrix3fv(uniform.info->location, 1, GL_FALSE, value_ptr(value));
+}
+
+void ppgso::Shader::setUniform(Uniform<glm::mat4> uniform, const glm::mat4 &value) const {
+  use();
+  if (changed(uniform.info, &value, sizeof(value)))
+    glUniformMatrix4fv(uniform.info->location, 1, GL_FALSE, value_ptr(value));
+}
+
+void ppgso::Shader::setUniform(Uniform<Texture> uniform, const Texture &texture, const int id) const {
+  use();
+  if (changed(uniform.info, &id, sizeof(id))) glUniform1i(uniform.info->location, id);
+  texture.bind(id);
+}
+
+void ppgso::Shader::setUniform(Uniform<TextureAlpha> uniform, const TextureAlpha &texture, const int id) const {
+  use();
+  if (changed(uniform.info, &id, sizeof(id))) glUniform1i(uniform.info->location, id);
+  texture.bind(id);
+}
+
+void ppgso::Shader::setUniform(Uniform<TextureArray> uniform, const TextureArray &texture, const int id) const {
+  use();
+  if (changed(uniform.info, &id, sizeof(id))) glUniform1i(uniform.info->location, id);
+  texture.bind(id);
 }
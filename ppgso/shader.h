@@ -1,20 +1,61 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <unordered_map>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 #include "texture.h"
 #include "texture_alpha.h"
+#include "texture_array.h"
 
 namespace ppgso {
 
     class Shader {
+        struct UniformInfo;
+
     public:
 
+        /*!
+         * Typed handle of a uniform variable, obtained once using Shader::getUniform and then used to
+         * set the value without looking the name up. Handles of inactive uniforms are valid but setting them does nothing.
+         *
+         * @tparam T - C++ type of the value: float, int, glm vectors and matrices, Texture or TextureAlpha for samplers.
+         */
+        template<typename T>
+        class Uniform {
+        public:
+            Uniform() = default;
+
+            /*!
+             * Check whether the uniform is used by the program.
+             *
+             * @return - True when the uniform was not optimized away by the linker.
+             */
+            bool isActive() const { return info && info->location >= 0; }
+
+        private:
+            friend class Shader;
+            explicit Uniform(const UniformInfo *info) : info{info} {}
+            const UniformInfo *info = nullptr;
+        };
+
+        /*!
+         * Time spent setting up shader programs and where the programs came from.
+         */
+        struct Statistics {
+            // Programs compiled from source, loaded from the binary cache and shared with an existing Shader
+            int compiled = 0, loaded = 0, reused = 0;
+            // Time spent in constructors and waiting for compilation to finish
+            double milliseconds = 0;
+        };
+
         /*!
          * Compile and manage an GLSL program and its inputs.
+         * Shaders created from the same sources share one program. Linked programs are stored in the
+         * binary cache directory and loaded from it on the next run instead of being compiled.
+         * When the driver compiles in parallel, the status is checked (and errors are thrown) when the program is first used.
          *
          * @param vertex_shader_code - String containing the source of the vertex shader.
          * @param fragment_shader_code - String containing the source of the fragment shader.
@@ -23,8 +64,12 @@ namespace ppgso {
 
         ~Shader();
 
+        Shader(const Shader&) = delete;
+        Shader &operator=(const Shader&) = delete;
+
         /*!
          * Set up the program for use in OpenGL state.
+         * Does nothing when the program is already in use, see ppgso::gl.
          */
         void use() const;
 
@@ -44,6 +89,29 @@ namespace ppgso {
          */
         GLuint getUniformLocation(const std::string &name) const;
 
+        /*!
+         * Get typed handle of the uniform specified by "name".
+         * Throws when the uniform is active and its GLSL type does not match T.
+         *
+         * @param name - Name of the shader program uniform input variable.
+         * @return - Handle to use with setUniform.
+         */
+        template<typename T>
+        Uniform<T> getUniform(const std::string &name) const {
+          auto &info = findUniform(name);
+          checkType(name, info, UniformType<T>::type);
+          return Uniform<T>{&info};
+        }
+
+        /*!
+         * Connect uniform block specified by "name" to a uniform buffer binding point, see UniformBuffer.
+         * Does nothing when the program does not use the block.
+         *
+         * @param name - Name of the uniform block.
+         * @param binding - Uniform buffer binding point index.
+         */
+        void setUniformBlock(const std::string &name, GLuint binding) const;
+
         /*!
          * Get OpenGL program identifier number.
          *
@@ -59,6 +127,14 @@ namespace ppgso {
          */
         void setUniform(const std::string &name, float value) const;
 
+        /*!
+         * Set an integer value as an input for the shader program variable "name", also used for bool uniforms
+         *
+         * @param name - Name of the shader program uniform input variable.
+         * @param value - Value to set input to.
+         */
+        void setUniform(const std::string &name, int value) const;
+
         /*!
          * Set a vector as an input for the shader program variable "name"
          *
@@ -103,6 +179,15 @@ namespace ppgso {
          */
         void setUniform(const std::string &name, const TextureAlpha &texture, const int id = 0) const;
 
+        /*!
+         * Set texture array as an input for the shader program variable "name", which must be a sampler2DArray.
+         *
+         * @param name - Name of the shader program uniform input variable.
+         * @param texture - Texture array to set input to.
+         * @param id - Texture ID to use when multi-texturing (0 is default).
+         */
+        void setUniform(const std::string &name, const TextureArray &texture, const int id = 0) const;
+
         /*!
          * Set matrix as an input for the shader program variable "name"
          *
@@ -119,9 +204,94 @@ namespace ppgso {
          */
         void setUniform(const std::string &name, glm::mat3 matrix) const;
 
+        /*!
+         * Set values through typed handles from getUniform.
+         *
+         * @param uniform - Handle of the shader program uniform input variable.
+         * @param value - Value to set input to.
+         */
+        void setUniform(Uniform<float> uniform, float value) const;
+        void setUniform(Uniform<int> uniform, int value) const;
+        void setUniform(Uniform<glm::vec2> uniform, const glm::vec2 &value) const;
+        void setUniform(Uniform<glm::vec3> uniform, const glm::vec3 &value) const;
+        void setUniform(Uniform<glm::vec4> uniform, const glm::vec4 &value) const;
+        void setUniform(Uniform<glm::mat3> uniform, const glm::mat3 &value) const;
+        void setUniform(Uniform<glm::mat4> uniform, const glm::mat4 &value) const;
+
+        /*!
+         * Set texture through a typed handle from getUniform.
+         *
+         * @param uniform - Handle of the sampler uniform.
+         * @param texture - Texture to set input to.
+         * @param id - Texture ID to use when multi-texturing (0 is default).
+         */
+        void setUniform(Uniform<Texture> uniform, const Texture &texture, const int id = 0) const;
+        void setUniform(Uniform<TextureAlpha> uniform, const TextureAlpha &texture, const int id = 0) const;
+        void setUniform(Uniform<TextureArray> uniform, const TextureArray &texture, const int id = 0) const;
+
+        /*!
+         * Set directory for program binaries kept between runs, the default is "shader_cache".
+         *
+         * @param directory - Directory relative to the working directory, empty disables the cache.
+         */
+        static void setCacheDirectory(const std::string &directory);
+
+        /*!
+         * Get statistics of all shaders created so far.
+         *
+         * @return - Counts of programs by origin and the total setup time.
+         */
+        static const Statistics &getStatistics();
+
     private:
+        // Location and GLSL type of a uniform, type is 0 for names unknown to the program.
+        // The last value set through Shader is kept so setting the same value again is skipped.
+        struct UniformInfo {
+          GLint location = -1;
+          GLenum type = 0;
+          mutable bool known = false;
+          mutable unsigned char value[sizeof(glm::mat4)] = {};
+          // Entry holding the value when several names refer to the same location, such as "array" and "array[0]"
+          const UniformInfo *cache = nullptr;
+        };
+
+        // Remember value of a uniform, returns false when the uniform is inactive or already has the value
+        static bool changed(const UniformInfo *info, const void *value, size_t size);
+
+        // Expected GLSL type for each C++ type that has a typed handle, samplers accept any sampler type
+        template<typename T> struct UniformType;
+
+        /*!
+         * Look up uniform in the cache, names not reported by the driver (such as individual
+         * array elements) are queried once and cached too.
+         */
+        const UniformInfo &findUniform(const std::string &name) const;
+
+        static void checkType(const std::string &name, const UniformInfo &info, GLenum type);
+
+        struct Program;
+
+        // Find a live program with the same sources, load it from the binary cache or start compiling it
+        static std::shared_ptr<Program> acquire(const std::string &vertex_shader_code,
+                                                const std::string &fragment_shader_code);
+
+        // Wait for compilation, check for errors and gather uniforms
+        void finish() const;
+
+        std::shared_ptr<Program> shared;
         GLuint program;
     };
 
+    template<> struct Shader::UniformType<float> { static constexpr GLenum type = GL_FLOAT; };
+    template<> struct Shader::UniformType<int> { static constexpr GLenum type = GL_INT; };
+    template<> struct Shader::UniformType<glm::vec2> { static constexpr GLenum type = GL_FLOAT_VEC2; };
+    template<> struct Shader::UniformType<glm::vec3> { static constexpr GLenum type = GL_FLOAT_VEC3; };
+    template<> struct Shader::UniformType<glm::vec4> { static constexpr GLenum type = GL_FLOAT_VEC4; };
+    template<> struct Shader::UniformType<glm::mat3> { static constexpr GLenum type = GL_FLOAT_MAT3; };
+    template<> struct Shader::UniformType<glm::mat4> { static constexpr GLenum type = GL_FLOAT_MAT4; };
+    template<> struct Shader::UniformType<Texture> { static constexpr GLenum type = GL_SAMPLER_2D; };
+    template<> struct Shader::UniformType<TextureAlpha> { static constexpr GLenum type = GL_SAMPLER_2D; };
+    template<> struct Shader::UniformType<TextureArray> { static constexpr GLenum type = GL_SAMPLER_2D_ARRAY; };
+
 }
 
@@ -0,0 +1,91 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "shader_library.h"
+
+void ppgso::ShaderLibrary::add(const std::string &name, const std::string &code) {
+  sources[name] = &code;
+}
+
+std::string ppgso::ShaderLibrary::preprocess(const std::string &code, const Defines &defines) const {
+  std::string output;
+  output.reserve(code.size() * 2);
+
+  // #version has to stay the first directive, defines follow it
+  auto body = 0ul;
+  auto line = 1;
+  if (code.compare(0, 8, "#version") == 0) {
+    body = code.find('\n');
+    body = body == std::string::npos ? code.size() : body + 1;
+    output.append(code, 0, body);
+    line = 2;
+  }
+
+  for (auto &define : defines)
+    output += "#define " + define.first + " " + define.second + "\n";
+  output += "#line " + std::to_string(line) + " 0\n";
+
+  std::map<std::string, int> included;
+  expand(code.substr(body), 0, line, included, output);
+  return output;
+}
+
+void ppgso::ShaderLibrary::expand(const std::string &code, int sourceNumber, int firstLine,
+                                  std::map<std::string, int> &included, std::string &output) const {
+  std::istringstream input{code};
+  std::string line;
+  auto lineNumber = 0;
+  while (std::getline(input, line)) {
+    lineNumber++;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    // Pass everything but #include directives through
+    auto start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+      output += line;
+      output += '\n';
+      continue;
+    }
+
+    auto open = line.find('"', start + 8);
+    auto close = open == std::string::npos ? open : line.find('"', open + 1);
+    if (close == std::string::npos) {
+      std::stringstream msg;
+      msg << "Malformed shader include: " << line;
+      throw std::runtime_error(msg.str());
+    }
+    auto name = line.substr(open + 1, close - open - 1);
+
+    auto found = sources.find(name);
+    if (found == sources.end()) {
+      std::stringstream msg;
+      msg << "Unknown shader include: " << name;
+      throw std::runtime_error(msg.str());
+    }
+
+    // Include guard, also breaks cycles
+    if (included.count(name) == 0) {
+      auto number = (int) included.size() + 1;
+      included[name] = number;
+      output += "#line 1 " + std::to_string(number) + "\n";
+      expand(*found->second, number, 1, included, output);
+    }
+    output += "#line " + std::to_string(firstLine + lineNumber) + " " + std::to_string(sourceNumber) + "\n";
+  }
+}
+
+std::shared_ptr<ppgso::Shader> ppgso::ShaderLibrary::get(const std::string &vertex_shader_code,
+                                                         const std::string &fragment_shader_code,
+                                                         const Defines &defines) {
+  // Sources are identified by address, the generated shader strings are global
+  std::stringstream key;
+  key << (const void *) &vertex_shader_code << ' ' << (const void *) &fragment_shader_code;
+  for (auto &define : defines)
+    key << ' ' << define.first << '=' << define.second;
+
+  auto &variant = variants[key.str()];
+  if (!variant)
+    variant = std::make_shared<Shader>(preprocess(vertex_shader_code, defines),
+                                       preprocess(fragment_shader_code, defines));
+  return variant;
+}
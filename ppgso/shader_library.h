@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "shader.h"
+
+namespace ppgso {
+
+  /*!
+   * Preprocess GLSL sources and keep compiled variants of them.
+   * Sources may contain #include "name" lines that refer to sources added to the library, and variants
+   * are specialized by #define lines injected after the #version directive. Each distinct combination
+   * of sources and defines is compiled only once.
+   */
+  class ShaderLibrary {
+  public:
+    /*!
+     * Names and values of #define directives, sorted by name so equal sets produce equal keys.
+     */
+    using Defines = std::map<std::string, std::string>;
+
+    /*!
+     * Make source available to #include directives.
+     *
+     * @param name - Name used in the #include directive, for example "lights.glsl".
+     * @param code - GLSL source, must outlive the library.
+     */
+    void add(const std::string &name, const std::string &code);
+
+    /*!
+     * Expand #include directives and insert defines after the #version line.
+     * Every source is included at most once, #line directives keep compiler messages pointing at the right lines.
+     *
+     * @param code - GLSL source to process.
+     * @param defines - Defines to inject.
+     * @return - Source ready to compile.
+     */
+    std::string preprocess(const std::string &code, const Defines &defines = {}) const;
+
+    /*!
+     * Get shader variant, compiling it when the combination is requested for the first time.
+     *
+     * @param vertex_shader_code - Source of the vertex shader, must outlive the library.
+     * @param fragment_shader_code - Source of the fragment shader, must outlive the library.
+     * @param defines - Defines to inject into both shaders.
+     * @return - Shader shared by all users of the variant.
+     */
+    std::shared_ptr<Shader> get(const std::string &vertex_shader_code, const std::string &fragment_shader_code,
+                                const Defines &defines = {});
+
+  private:
+    // Append code with includes expanded, firstLine is the line number of its first line in the original source
+    void expand(const std::string &code, int sourceNumber, int firstLine, std::map<std::string, int> &included,
+                std::string &output) const;
+
+    std::unordered_map<std::string, const std::string *> sources;
+    std::unordered_map<std::string, std::shared_ptr<Shader>> variants;
+  };
+}
@@ -1,53 +1,317 @@
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
 
 #include "texture.h"
+#include "gl_state.h"
+#include "texture_residency.h"
+
+bool ppgso::Texture::keepImages = true;
+
+namespace {
+  // Mismatched levels would otherwise only show up as OpenGL errors during upload
+  void validateMipmaps(const ppgso::Image &image, const std::vector<ppgso::Image> &mipmaps) {
+    auto largest = std::max(image.width, image.height);
+    size_t maxLevels = 1;
+    while (largest >>= 1) maxLevels++;
+    if (1 + mipmaps.size() > maxLevels) {
+      std::stringstream msg;
+      msg << "Texture of " << image.width << "x" << image.height << " can have at most " << maxLevels
+          << " levels, got " << 1 + mipmaps.size();
+      throw std::runtime_error(msg.str());
+    }
+
+    auto width = image.width, height = image.height;
+    for (size_t i = 0; i < mipmaps.size(); i++) {
+      width = std::max(1, width / 2);
+      height = std::max(1, height / 2);
+      if (mipmaps[i].width != width || mipmaps[i].height != height) {
+        std::stringstream msg;
+        msg << "Mipmap level " << i + 1 << " must be " << width << "x" << height << ", got "
+            << mipmaps[i].width << "x" << mipmaps[i].height;
+        throw std::runtime_error(msg.str());
+      }
+    }
+  }
+}
 
 ppgso::Texture::Texture(int width, int height) : image{width, height} {
-  initGL();
+  initGL(GL_RGB8, width, height);
   update();
 }
 
 ppgso::Texture::Texture(Image&& image) : image{std::move(image)} {
-  initGL();
+  initGL(GL_RGB8, this->image.width, this->image.height);
   update();
+  if (!keepImages) releaseImage();
+}
+
+ppgso::Texture::Texture(Image&& image, std::vector<Image>&& mipmaps) : image{std::move(image)}, mipmaps{std::move(mipmaps)} {
+  validateMipmaps(this->image, this->mipmaps);
+  levels = 1 + (int) this->mipmaps.size();
+  initGL(GL_RGB8, this->image.width, this->image.height);
+
+  // Upload all precomputed levels
+  upload(this->image, 0, 0, 0, this->image.width, this->image.height);
+  for (size_t i = 0; i < this->mipmaps.size(); i++)
+    upload(this->mipmaps[i], (int) i + 1, 0, 0, this->mipmaps[i].width, this->mipmaps[i].height);
+  if (!keepImages) releaseImage();
+}
+
+ppgso::Texture::Texture(CompressedImage&& image) : image{0, 0}, compressed{true}, released{true} {
+  replace(image);
+}
+
+void ppgso::Texture::replace(const CompressedImage &image) {
+  if (!compressed) throw std::runtime_error("Only compressed textures can be replaced");
+
+  // Texture storage is immutable, start over with a new texture object
+  if (texture) gl::deleteTexture(texture);
+  levels = (int) image.levels.size();
+  gpuSize = 0;
+
+  if (!GLEW_EXT_texture_compression_s3tc) {
+    initGL(GL_RGBA8, image.width, image.height);
+    for (size_t i = 0; i < image.levels.size(); i++) {
+      auto &level = image.levels[i];
+      glTexSubImage2D(GL_TEXTURE_2D, (GLint) i, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, image.decode(i).data());
+    }
+    return;
+  }
+
+  initGL(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, image.width, image.height);
+  gpuSize = image.getSize();
+  for (size_t i = 0; i < image.levels.size(); i++) {
+    auto &level = image.levels[i];
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint) i, 0, 0, level.width, level.height,
+                              GL_COMPRESSED_RGB_S3TC_DXT1_EXT, (GLsizei) level.size, level.data);
+  }
 }
 
 ppgso::Texture::~Texture() {
-  glDeleteTextures(1, &texture);
+  residency::forget(this);
+  if (stream) {
+    for (auto fence : stream->fences)
+      if (fence) glDeleteSync(fence);
+    for (auto buffer : stream->buffers)
+      gl::deleteBuffer(buffer);
+  }
+  gl::deleteTexture(texture);
 }
 
-void ppgso::Texture::initGL() {
+void ppgso::Texture::initGL(GLenum format, int width, int height) {
+  this->width = width;
+  this->height = height;
+
+  // Drivers pad RGB8 texels to four bytes, compressed sizes are set by the caller
+  for (int w = width, h = height, i = 0; i < levels; i++, w = std::max(1, w / 2), h = std::max(1, h / 2))
+    gpuSize += (size_t) w * h * 4;
+
   // Create new texture object
   glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
+  bind();
 
   // Reserve texture storage
-  glTexStorage2D(GL_TEXTURE_2D, 3, GL_RGB8, image.width, image.height);
+  glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
 
   // Set up mipmapping
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-  // Update texture with data from image framebuffer
-  update();
 }
 
 void ppgso::Texture::update() {
+  if (compressed) throw std::runtime_error("Compressed textures can not be updated");
+  if (released) throw std::runtime_error("Texture image was released, call fetchImage before updating");
+  update(0, 0, image.width, image.height);
+}
+
+void ppgso::Texture::update(int x, int y, int width, int height) {
+  if (compressed) throw std::runtime_error("Compressed textures can not be updated");
+  if (released) throw std::runtime_error("Texture image was released, call fetchImage before updating");
+
+  // Clip the region to the image
+  width = std::min(x + width, image.width) - std::max(x, 0);
+  height = std::min(y + height, image.height) - std::max(y, 0);
+  x = std::max(x, 0);
+  y = std::max(y, 0);
+  if (width <= 0 || height <= 0) return;
+
   bind();
-  // Upload texture to GPU
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGB, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+  if (stream) beginStream();
+  upload(image, 0, x, y, width, height);
+
+  // Every texel changed, the driver regenerates the whole chain faster than the CPU
+  if (width == image.width && height == image.height) {
+    mipmaps.clear();
+    if (stream) endStream();
+    bind();
+    glGenerateMipmap(GL_TEXTURE_2D);
+    return;
+  }
+
+  // First partial update switches the texture to CPU generated mipmaps
+  if (mipmaps.empty()) mipmaps = image.generateMipmaps(levels - 1);
 
-  // Re-generate mipmaps
-  glGenerateMipmap(GL_TEXTURE_2D);
+  // Propagate the region through the mipmap chain
+  Image *previous = &image;
+  for (size_t i = 0; i < mipmaps.size(); i++) {
+    auto &level = mipmaps[i];
+    previous->downsample(level, x, y, width, height);
+
+    int x1 = std::min((x + width + 1) / 2, level.width);
+    int y1 = std::min((y + height + 1) / 2, level.height);
+    x /= 2;
+    y /= 2;
+    width = x1 - x;
+    height = y1 - y;
+
+    upload(level, (int) i + 1, x, y, width, height);
+    previous = &level;
+  }
+  if (stream) endStream();
+}
+
+void ppgso::Texture::setStreaming(int buffers) {
+  if (compressed) throw std::runtime_error("Compressed textures can not be updated");
+  if (stream || buffers < 1) return;
+
+  // Room for every level updated at once, each region starts at a 4 byte boundary
+  stream = std::make_unique<Stream>();
+  for (int w = width, h = height, i = 0; i < levels; i++, w = std::max(1, w / 2), h = std::max(1, h / 2))
+    stream->size += (size_t) w * h * sizeof(Image::Pixel) + 4;
+
+  stream->buffers.resize((size_t) buffers);
+  stream->fences.resize((size_t) buffers, nullptr);
+  glGenBuffers(buffers, stream->buffers.data());
+  for (auto buffer : stream->buffers) {
+    gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr) stream->size, nullptr, GL_STREAM_DRAW);
+  }
+  gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void ppgso::Texture::beginStream() {
+  auto buffer = stream->buffers[stream->next];
+  auto &fence = stream->fences[stream->next];
+
+  // The buffer was used by the update a full ring ago, usually the GPU is long done with it
+  if (fence) {
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+
+  gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  stream->mapped = (uint8_t *) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr) stream->size,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  stream->offset = 0;
+  stream->regions.clear();
+
+  // Fall back to direct uploads when the driver refuses to map the buffer
+  if (!stream->mapped) std::cerr << "Could not map pixel unpack buffer, uploading directly" << std::endl;
+}
+
+void ppgso::Texture::endStream() {
+  if (!stream->mapped) return;
+
+  auto buffer = stream->buffers[stream->next];
+  gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  stream->mapped = nullptr;
+
+  // Regions are tightly packed rows, the pointer argument is an offset into the bound buffer
+  bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (auto &region : stream->regions)
+    glTexSubImage2D(GL_TEXTURE_2D, region.index, region.x, region.y, region.width, region.height, GL_RGB,
+                    GL_UNSIGNED_BYTE, (const void *) region.offset);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  gl::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  stream->fences[stream->next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  stream->next = (stream->next + 1) % stream->buffers.size();
+}
+
+void ppgso::Texture::upload(Image &level, int index, int x, int y, int width, int height) {
+  if (stream && stream->mapped) {
+    // Copy the region into the mapped buffer, it is transferred by endStream
+    auto row = (size_t) width * sizeof(Image::Pixel);
+    stream->offset = (stream->offset + 3) & ~(size_t) 3;
+    stream->regions.push_back({index, x, y, width, height, stream->offset});
+    for (int j = 0; j < height; j++)
+      memcpy(stream->mapped + stream->offset + j * row, &level.getPixel(x, y + j), row);
+    stream->offset += row * height;
+    return;
+  }
+
+  bind();
+  // Rows of a sub-region are not contiguous, let OpenGL skip over the rest of the row
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, level.width);
+  glTexSubImage2D(GL_TEXTURE_2D, index, x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE, &level.getPixel(x, y));
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 void ppgso::Texture::bind(int id) const {
-  glActiveTexture((GLenum) (GL_TEXTURE0 + id));
-  glBindTexture(GL_TEXTURE_2D, texture);
+  lastUse = residency::getFrame();
+  gl::bindTexture(GL_TEXTURE_2D, (GLuint) id, texture);
+}
+
+unsigned long ppgso::Texture::getLastUse() const {
+  return lastUse;
 }
 
 GLuint ppgso::Texture::getTexture() {
   return texture;
 }
+
+void ppgso::Texture::setKeepImages(bool keep) {
+  keepImages = keep;
+}
+
+bool ppgso::Texture::getKeepImages() {
+  return keepImages;
+}
+
+void ppgso::Texture::releaseImage() {
+  image = Image{0, 0};
+  mipmaps = std::vector<Image>{};
+  released = true;
+}
+
+ppgso::Image &ppgso::Texture::fetchImage() {
+  if (!released) return image;
+
+  // Compressed textures are decoded by the driver, they still can not be updated
+  image = Image{width, height};
+  bind();
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  released = false;
+  return image;
+}
+
+int ppgso::Texture::getWidth() const {
+  return width;
+}
+
+int ppgso::Texture::getHeight() const {
+  return height;
+}
+
+ppgso::MemoryUsage ppgso::Texture::getMemoryUsage() const {
+  auto cpu = image.getFramebuffer().capacity() * sizeof(Image::Pixel);
+  for (auto &level : mipmaps)
+    cpu += level.getFramebuffer().capacity() * sizeof(Image::Pixel);
+
+  auto gpu = gpuSize;
+  if (stream) gpu += stream->size * stream->buffers.size();
+  return {cpu, gpu};
+}
@@ -7,6 +7,8 @@
 #include <GL/glew.h>
 
 #include "image.h"
+#include "image_compressed.h"
+#include "memory_usage.h"
 
 namespace ppgso {
 
@@ -23,18 +25,96 @@ namespace ppgso {
 
     /*!
      * Load from image.
+     * The image is released after the upload when keeping images is disabled (see setKeepImages).
      *
      * @param image - Image to use
      */
     Texture(Image&& image);
 
+    /*!
+     * Load from image with precomputed mipmaps, for example baked offline using Image::generateMipmaps.
+     * The levels are uploaded as they are instead of being generated by the driver.
+     *
+     * @param image - Image to use as the base level
+     * @param mipmaps - Mipmap levels 1..n, each half the size of the previous one rounded down and at least 1,
+     *                  throws when a level does not match or there are more levels than the image has
+     */
+    Texture(Image&& image, std::vector<Image>&& mipmaps);
+
+    /*!
+     * Load from block compressed image, all levels are uploaded as they are (see image::loadCompressedBMP).
+     * Falls back to decoding on the CPU when the GPU does not support S3TC.
+     * The texture keeps no CPU copy, image is empty until fetched and the texture can not be updated.
+     *
+     * @param image - Compressed image with all mipmap levels
+     */
+    Texture(CompressedImage&& image);
+
     ~Texture();
 
     /*!
-     * Update the OpenGL texture in memory.
+     * Choose whether textures loaded from images keep the image on the CPU after the upload.
+     * Empty textures created by size always keep their image as they are meant to be drawn into.
+     *
+     * @param keep - False to release images of textures created from now on (true by default).
+     */
+    static void setKeepImages(bool keep);
+
+    /*!
+     * Check whether textures loaded from images keep the image on the CPU.
+     *
+     * @return - True unless disabled by setKeepImages.
+     */
+    static bool getKeepImages();
+
+    /*!
+     * Release the CPU copy of the image and its mipmaps, the OpenGL texture stays as it is.
+     * Use fetchImage to get the image back.
+     */
+    void releaseImage();
+
+    /*!
+     * Get the image for CPU access, a released image is read back from the base level of the OpenGL texture.
+     *
+     * @return - Reference to image.
+     */
+    Image &fetchImage();
+
+    /*!
+     * Update the OpenGL texture in memory, mipmaps are regenerated by the driver.
      */
     void update();
 
+    /*!
+     * Update a region of the OpenGL texture after the image was partially modified.
+     * Only texels of the mipmap levels that depend on the region are recomputed on the CPU and uploaded,
+     * when the region covers the whole image the driver regenerates the mipmaps instead.
+     *
+     * @param x - Horizontal start of the changed region.
+     * @param y - Vertical start of the changed region.
+     * @param width - Width of the changed region.
+     * @param height - Height of the changed region.
+     */
+    void update(int x, int y, int width, int height);
+
+    /*!
+     * Stream updates through a ring of mapped pixel unpack buffers.
+     * Changed texels are copied into the next buffer of the ring and the transfer to the texture runs
+     * asynchronously, a buffer is reused once the GPU finished reading it, so updating every frame does not stall.
+     *
+     * @param buffers - Number of buffers in the ring, 2-3 keep the CPU a frame or two ahead of the GPU.
+     */
+    void setStreaming(int buffers = 3);
+
+    /*!
+     * Replace the storage of a compressed texture with the levels of another compressed image of any size.
+     * Used by the residency manager to swap between the full resolution and a small mip tail,
+     * the OpenGL texture identifier number changes.
+     *
+     * @param image - Compressed image with all mipmap levels
+     */
+    void replace(const CompressedImage &image);
+
     /*!
      * Get OpenGL texture identifier number.
      *
@@ -43,16 +123,73 @@ namespace ppgso {
     GLuint getTexture();
 
     /*!
-     * Bind the OpenGL texture for use.
+     * Bind the OpenGL texture for use, the texture counts as used in the current frame (see residency).
      *
      * @param id - OpenGL Texture id to bind to (0 default)
      */
     void bind(int id = 0) const;
 
+    /*!
+     * Get residency frame in which the texture was last bound.
+     *
+     * @return - Frame number.
+     */
+    unsigned long getLastUse() const;
+
+    /*!
+     * Get width of the base level, also when the image was released.
+     *
+     * @return - Width in pixels.
+     */
+    int getWidth() const;
+
+    /*!
+     * Get height of the base level, also when the image was released.
+     *
+     * @return - Height in pixels.
+     */
+    int getHeight() const;
+
+    /*!
+     * Get memory held by the image, mipmaps, texture storage and streaming buffers.
+     *
+     * @return - CPU and GPU bytes.
+     */
+    MemoryUsage getMemoryUsage() const;
+
+    // CPU copy of the base level, empty while released
     Image image;
+
+    // CPU copies of mipmap levels 1..n, empty while the driver generates the mipmaps
+    std::vector<Image> mipmaps;
   private:
-    void initGL();
-    GLuint texture;
+    // Ring of pixel unpack buffers, regions of one update are copied into the mapped buffer and then transferred
+    struct Stream {
+      struct Region {
+        int index, x, y, width, height;
+        size_t offset;
+      };
+
+      std::vector<GLuint> buffers;
+      std::vector<GLsync> fences;
+      size_t next = 0, size = 0, offset = 0;
+      uint8_t *mapped = nullptr;
+      std::vector<Region> regions;
+    };
+
+    void initGL(GLenum format, int width, int height);
+    void upload(Image &level, int index, int x, int y, int width, int height);
+    void beginStream();
+    void endStream();
+    GLuint texture = 0;
+    mutable unsigned long lastUse = 0;
+    std::unique_ptr<Stream> stream;
+    int width, height;
+    int levels = 3;
+    size_t gpuSize = 0;
+    bool compressed = false;
+    bool released = false;
+    static bool keepImages;
   };
 }
 
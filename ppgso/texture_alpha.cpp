@@ -1,39 +1,81 @@
 #include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include "texture.h"
 #include "texture_alpha.h"
+#include "gl_state.h"
+#include "texture_residency.h"
 
 ppgso::TextureAlpha::TextureAlpha(int width, int height) : image{width, height} {
-    initGL();
+    initGL(GL_RGBA8, 3, width, height);
     update();
 }
 
 ppgso::TextureAlpha::TextureAlpha(ImageAlpha&& image) : image{std::move(image)} {
-    initGL();
+    initGL(GL_RGBA8, 3, this->image.width, this->image.height);
     update();
+    if (!Texture::getKeepImages()) releaseImage();
+}
+
+ppgso::TextureAlpha::TextureAlpha(CompressedImage&& image) : image{0, 0}, compressed{true}, released{true} {
+    replace(image);
+}
+
+void ppgso::TextureAlpha::replace(const CompressedImage &image) {
+    if (!compressed) throw std::runtime_error("Only compressed textures can be replaced");
+
+    // Texture storage is immutable, start over with a new texture object
+    if (texture) gl::deleteTexture(texture);
+    auto levels = (int) image.levels.size();
+    gpuSize = 0;
+
+    if (!GLEW_EXT_texture_compression_s3tc) {
+        initGL(GL_RGBA8, levels, image.width, image.height);
+        for (size_t i = 0; i < image.levels.size(); i++) {
+            auto &level = image.levels[i];
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint) i, 0, 0, level.width, level.height, GL_RGBA, GL_UNSIGNED_BYTE, image.decode(i).data());
+        }
+        return;
+    }
+
+    initGL(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, levels, image.width, image.height);
+    gpuSize = image.getSize();
+    for (size_t i = 0; i < image.levels.size(); i++) {
+        auto &level = image.levels[i];
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint) i, 0, 0, level.width, level.height,
+                                  GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, (GLsizei) level.size, level.data);
+    }
 }
 
 ppgso::TextureAlpha::~TextureAlpha() {
-    glDeleteTextures(1, &texture);
+    residency::forget(this);
+    gl::deleteTexture(texture);
 }
 
-void ppgso::TextureAlpha::initGL() {
+void ppgso::TextureAlpha::initGL(GLenum format, int levels, int width, int height) {
+    this->width = width;
+    this->height = height;
+    for (int w = width, h = height, i = 0; i < levels; i++, w = std::max(1, w / 2), h = std::max(1, h / 2))
+        gpuSize += (size_t) w * h * 4;
+
     // Create new texture object
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    bind();
 
     // Reserve texture storage
-    glTexStorage2D(GL_TEXTURE_2D, 3, GL_RGBA8, image.width, image.height);
+    glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
 
     // Set up mipmapping
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-    // Update texture with data from image framebuffer
-    update();
 }
 
 void ppgso::TextureAlpha::update() {
+    if (compressed) throw std::runtime_error("Compressed textures can not be updated");
+    if (released) throw std::runtime_error("Texture image was released, call fetchImage before updating");
+
     bind();
     // Upload texture to GPU
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
@@ -43,10 +85,41 @@ void ppgso::TextureAlpha::update() {
 }
 
 void ppgso::TextureAlpha::bind(int id) const {
-    glActiveTexture((GLenum) (GL_TEXTURE0 + id));
-    glBindTexture(GL_TEXTURE_2D, texture);
+    lastUse = residency::getFrame();
+    gl::bindTexture(GL_TEXTURE_2D, (GLuint) id, texture);
+}
+
+unsigned long ppgso::TextureAlpha::getLastUse() const {
+    return lastUse;
 }
 
 GLuint ppgso::TextureAlpha::getTexture() {
     return texture;
 }
+
+void ppgso::TextureAlpha::releaseImage() {
+    image = ImageAlpha{0, 0};
+    released = true;
+}
+
+ppgso::ImageAlpha &ppgso::TextureAlpha::fetchImage() {
+    if (!released) return image;
+
+    image = ImageAlpha{width, height};
+    bind();
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.getFramebuffer().data());
+    released = false;
+    return image;
+}
+
+int ppgso::TextureAlpha::getWidth() const {
+    return width;
+}
+
+int ppgso::TextureAlpha::getHeight() const {
+    return height;
+}
+
+ppgso::MemoryUsage ppgso::TextureAlpha::getMemoryUsage() const {
+    return {image.getFramebuffer().capacity() * sizeof(ImageAlpha::Pixel), gpuSize};
+}
@@ -7,6 +7,8 @@
 #include <GL/glew.h>
 
 #include "image_alpha.h"
+#include "image_compressed.h"
+#include "memory_usage.h"
 
 namespace ppgso {
 
@@ -22,10 +24,19 @@ namespace ppgso {
 
         /*!
          * Load from image.
+         * The image is released after the upload when keeping images is disabled (see Texture::setKeepImages).
          * @param image - Image to use
          */
         TextureAlpha(ImageAlpha&& image);
 
+        /*!
+         * Load from block compressed image, all levels are uploaded as they are (see image::loadCompressedPNG).
+         * Falls back to decoding on the CPU when the GPU does not support S3TC.
+         * The texture keeps no CPU copy, image is empty until fetched and the texture can not be updated.
+         * @param image - Compressed image with all mipmap levels
+         */
+        TextureAlpha(CompressedImage&& image);
+
         ~TextureAlpha();
 
         /*!
@@ -33,6 +44,13 @@ namespace ppgso {
          */
         void update();
 
+        /*!
+         * Replace the storage of a compressed texture with the levels of another compressed image of any size.
+         * The OpenGL texture identifier number changes (see Texture::replace).
+         * @param image - Compressed image with all mipmap levels
+         */
+        void replace(const CompressedImage &image);
+
         /*!
          * Get OpenGL texture identifier number.
          * @return - OpenGL texture identifier number.
@@ -40,15 +58,56 @@ namespace ppgso {
         GLuint getTexture();
 
         /*!
-         * Bind the OpenGL texture for use.
+         * Bind the OpenGL texture for use, the texture counts as used in the current frame (see residency).
          * @param id - OpenGL Texture id to bind to (0 default)
          */
         void bind(int id = 0) const;
 
+        /*!
+         * Get residency frame in which the texture was last bound.
+         * @return - Frame number.
+         */
+        unsigned long getLastUse() const;
+
+        /*!
+         * Release the CPU copy of the image, the OpenGL texture stays as it is.
+         */
+        void releaseImage();
+
+        /*!
+         * Get the image for CPU access, a released image is read back from the base level of the OpenGL texture.
+         * @return - Reference to image.
+         */
+        ImageAlpha &fetchImage();
+
+        /*!
+         * Get width of the base level, also when the image was released.
+         * @return - Width in pixels.
+         */
+        int getWidth() const;
+
+        /*!
+         * Get height of the base level, also when the image was released.
+         * @return - Height in pixels.
+         */
+        int getHeight() const;
+
+        /*!
+         * Get memory held by the image and the texture storage.
+         * @return - CPU and GPU bytes.
+         */
+        MemoryUsage getMemoryUsage() const;
+
+        // CPU copy of the base level, empty while released
         ImageAlpha image;
     private:
-        void initGL();
-        GLuint texture;
+        void initGL(GLenum format, int levels, int width, int height);
+        GLuint texture = 0;
+        mutable unsigned long lastUse = 0;
+        int width, height;
+        size_t gpuSize = 0;
+        bool compressed = false;
+        bool released = false;
     };
 }
 
@@ -0,0 +1,79 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "texture_array.h"
+#include "gl_state.h"
+
+ppgso::TextureArray::TextureArray(std::vector<CompressedImage>&& images) {
+  if (images.empty())
+    throw std::runtime_error("Texture array needs at least one layer");
+
+  auto &first = images.front();
+  for (auto &image : images) {
+    if (image.width != first.width || image.height != first.height || image.format != first.format ||
+        image.levels.size() != first.levels.size()) {
+      std::stringstream msg;
+      msg << "Texture array layers differ in size or format, expected " << first.width << "x" << first.height
+          << " with " << first.levels.size() << " levels but got " << image.width << "x" << image.height
+          << " with " << image.levels.size() << " levels";
+      throw std::runtime_error(msg.str());
+    }
+  }
+
+  width = first.width;
+  height = first.height;
+  layers = (int) images.size();
+  auto levels = (GLsizei) first.levels.size();
+  bool compressed = GLEW_EXT_texture_compression_s3tc;
+  GLenum format = !compressed ? GL_RGBA8 :
+                  first.format == CompressedImage::Format::BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+                                                              : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+  // Create new texture object
+  glGenTextures(1, &texture);
+  bind();
+
+  // Reserve storage for all layers
+  glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, format, width, height, layers);
+
+  for (int layer = 0; layer < layers; layer++) {
+    auto &image = images[layer];
+    for (GLint i = 0; i < levels; i++) {
+      auto &level = image.levels[i];
+      gpuSize += compressed ? level.size : (size_t) level.width * level.height * 4;
+      if (compressed) {
+        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1,
+                                  format, (GLsizei) level.size, level.data);
+      } else {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, image.decode((size_t) i).data());
+      }
+    }
+  }
+
+  // Set up mipmapping
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+ppgso::TextureArray::~TextureArray() {
+  gl::deleteTexture(texture);
+}
+
+int ppgso::TextureArray::getLayers() const {
+  return layers;
+}
+
+void ppgso::TextureArray::bind(int id) const {
+  gl::bindTexture(GL_TEXTURE_2D_ARRAY, (GLuint) id, texture);
+}
+
+GLuint ppgso::TextureArray::getTexture() {
+  return texture;
+}
+
+ppgso::MemoryUsage ppgso::TextureArray::getMemoryUsage() const {
+  return {0, gpuSize};
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "image_compressed.h"
+#include "memory_usage.h"
+
+namespace ppgso {
+
+  /*!
+   * Same sized textures packed into the layers of a GL_TEXTURE_2D_ARRAY.
+   * Objects that differ only in texture bind the array once and select their layer by a uniform,
+   * so drawing them needs no texture switches.
+   */
+  class TextureArray {
+  public:
+
+    /*!
+     * Load from block compressed images, all levels are uploaded as they are (see image::loadCompressedBMP).
+     * Falls back to decoding on the CPU when the GPU does not support S3TC.
+     *
+     * @param images - Images of the same size, format and number of levels, layer i is images[i]
+     */
+    TextureArray(std::vector<CompressedImage>&& images);
+
+    ~TextureArray();
+
+    /*!
+     * Get number of layers.
+     *
+     * @return - Number of layers.
+     */
+    int getLayers() const;
+
+    /*!
+     * Get OpenGL texture identifier number.
+     *
+     * @return - OpenGL texture identifier number.
+     */
+    GLuint getTexture();
+
+    /*!
+     * Bind the OpenGL texture for use.
+     *
+     * @param id - OpenGL Texture id to bind to (0 default)
+     */
+    void bind(int id = 0) const;
+
+    /*!
+     * Get memory held by the texture storage, the layers keep no CPU copy.
+     *
+     * @return - CPU and GPU bytes.
+     */
+    MemoryUsage getMemoryUsage() const;
+
+    int width, height;
+  private:
+    GLuint texture;
+    int layers;
+    size_t gpuSize = 0;
+  };
+}
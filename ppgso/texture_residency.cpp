@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "texture_residency.h"
+#include "asset_loader.h"
+
+namespace {
+  struct Entry {
+    std::string source;
+    ppgso::CompressedImage (*reload)(const std::string &);
+    ppgso::CompressedImage tail;
+    std::function<unsigned long()> lastUse;
+    std::function<void(const ppgso::CompressedImage &)> replace;
+    std::function<size_t()> gpuSize;
+    bool evicted = false;
+    ppgso::Asset<ppgso::CompressedImage> restore;
+  };
+
+  struct State {
+    std::map<const void *, Entry> entries;
+    size_t budget = std::numeric_limits<size_t>::max();
+    int tailSize = 64;
+    unsigned long frame = 1;
+    unsigned long evictions = 0, restores = 0;
+  };
+
+  State &state() {
+    static State instance;
+    return instance;
+  }
+
+  template<typename T>
+  void track(T &texture, const std::string &source, ppgso::CompressedImage (*reload)(const std::string &),
+             ppgso::CompressedImage &&tail) {
+    Entry entry;
+    entry.source = source;
+    entry.reload = reload;
+    entry.tail = std::move(tail);
+    // Textures count as used when tracked so they are not evicted before they are first drawn
+    auto frame = state().frame;
+    entry.lastUse = [&texture, frame] { return std::max(texture.getLastUse(), frame); };
+    entry.replace = [&texture](const ppgso::CompressedImage &image) { texture.replace(image); };
+    entry.gpuSize = [&texture] { return texture.getMemoryUsage().gpu; };
+    state().entries[&texture] = std::move(entry);
+  }
+
+  void requestRestore(Entry &entry) {
+    auto source = entry.source;
+    auto reload = entry.reload;
+    entry.restore = ppgso::assets::load<ppgso::CompressedImage>(
+            "texture_restore:" + source,
+            [source, reload]() -> ppgso::CompressedImage {
+              // The container was validated when the texture was first loaded
+              if (auto cached = ppgso::image::loadCompressed(ppgso::image::compressedPath(source), nullptr))
+                return std::move(*cached);
+              return reload(source);
+            },
+            [](ppgso::CompressedImage &&image) { return std::make_unique<ppgso::CompressedImage>(std::move(image)); });
+  }
+}
+
+void ppgso::residency::setBudget(size_t bytes) {
+  state().budget = bytes;
+}
+
+void ppgso::residency::setTailSize(int size) {
+  state().tailSize = size;
+}
+
+int ppgso::residency::getTailSize() {
+  return state().tailSize;
+}
+
+void ppgso::residency::track(Texture &texture, const std::string &bmp, CompressedImage &&tail) {
+  ::track(texture, bmp, &image::loadCompressedBMP, std::move(tail));
+}
+
+void ppgso::residency::track(TextureAlpha &texture, const std::string &png, CompressedImage &&tail) {
+  ::track(texture, png, &image::loadCompressedPNG, std::move(tail));
+}
+
+void ppgso::residency::forget(const void *texture) {
+  state().entries.erase(texture);
+}
+
+unsigned long ppgso::residency::getFrame() {
+  return state().frame;
+}
+
+void ppgso::residency::update() {
+  auto &s = state();
+  auto previous = s.frame++;
+
+  size_t resident = 0;
+  std::vector<Entry *> candidates;
+  for (auto &item : s.entries) {
+    auto &entry = item.second;
+
+    // Swap in textures the workers finished reading
+    if (entry.restore.ready()) {
+      entry.replace(*entry.restore);
+      entry.restore = {};
+      entry.evicted = false;
+      s.restores++;
+    }
+
+    auto lastUse = entry.lastUse();
+    if (entry.evicted && !entry.restore && lastUse == previous)
+      requestRestore(entry);
+
+    resident += entry.gpuSize();
+    if (!entry.evicted && lastUse < previous)
+      candidates.push_back(&entry);
+  }
+  if (resident <= s.budget) return;
+
+  // Evict least recently used textures first
+  std::sort(candidates.begin(), candidates.end(), [](Entry *a, Entry *b) { return a->lastUse() < b->lastUse(); });
+  for (auto entry : candidates) {
+    if (resident <= s.budget) break;
+    resident -= entry->gpuSize();
+    entry->replace(entry->tail);
+    entry->evicted = true;
+    resident += entry->gpuSize();
+    s.evictions++;
+  }
+}
+
+ppgso::residency::Statistics ppgso::residency::getStatistics() {
+  auto &s = state();
+  Statistics statistics{s.entries.size(), 0, 0, 0, s.budget, s.evictions, s.restores};
+  for (auto &item : s.entries) {
+    auto &entry = item.second;
+    if (entry.evicted) statistics.evicted++;
+    if (entry.restore) statistics.restoring++;
+    statistics.resident += entry.gpuSize();
+  }
+  return statistics;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+#include "image_compressed.h"
+
+namespace ppgso {
+
+  class Texture;
+  class TextureAlpha;
+
+  /*!
+   * Residency of compressed textures within a GPU memory budget.
+   * Tracked textures remember the frame in which they were last bound. While the tracked textures
+   * exceed the budget, the least recently used ones are evicted down to a small mip tail kept on the CPU.
+   * When an evicted texture is bound again its container is read by the asset workers and the texture is
+   * swapped back to full resolution once decoded, the tail is drawn in the meantime.
+   * Textures bound in the previous frame are never evicted, so the budget is exceeded when they do not fit.
+   * All functions must be called on the render thread.
+   */
+  namespace residency {
+
+    /*!
+     * State of the tracked textures.
+     */
+    struct Statistics {
+      size_t tracked, evicted, restoring;
+      size_t resident, budget;
+      unsigned long evictions, restores;
+    };
+
+    /*!
+     * Set GPU memory budget for the tracked textures.
+     *
+     * @param bytes - Budget in bytes, unlimited by default.
+     */
+    void setBudget(size_t bytes);
+
+    /*!
+     * Set size of the mip tail evicted textures keep, applies to textures tracked from now on.
+     *
+     * @param size - Maximal width and height of the largest tail level in pixels, 64 by default.
+     */
+    void setTailSize(int size);
+
+    /*!
+     * Get size of the mip tail evicted textures keep.
+     *
+     * @return - Maximal width and height in pixels.
+     */
+    int getTailSize();
+
+    /*!
+     * Track texture loaded from a BMP file (see assets::loadTexture).
+     *
+     * @param texture - Compressed texture at full resolution.
+     * @param bmp - File path to the BMP file, its container is read again to restore the texture.
+     * @param tail - Mip tail of the texture (see image::mipTail).
+     */
+    void track(Texture &texture, const std::string &bmp, CompressedImage &&tail);
+
+    /*!
+     * Track texture loaded from a PNG file (see assets::loadTextureAlpha).
+     *
+     * @param texture - Compressed texture at full resolution.
+     * @param png - File path to the PNG file, its container is read again to restore the texture.
+     * @param tail - Mip tail of the texture (see image::mipTail).
+     */
+    void track(TextureAlpha &texture, const std::string &png, CompressedImage &&tail);
+
+    /*!
+     * Stop tracking texture, called when the texture is destroyed.
+     *
+     * @param texture - Texture or TextureAlpha, untracked textures are ignored.
+     */
+    void forget(const void *texture);
+
+    /*!
+     * Advance to the next frame, swap in restored textures, request restores for evicted textures
+     * bound in the previous frame and evict textures until the budget is met. Call once per frame before rendering.
+     */
+    void update();
+
+    /*!
+     * Get current frame number, textures store it when they are bound.
+     *
+     * @return - Frame number.
+     */
+    unsigned long getFrame();
+
+    /*!
+     * Get state of the tracked textures.
+     *
+     * @return - Counters and GPU bytes of the tracked textures.
+     */
+    Statistics getStatistics();
+  }
+}
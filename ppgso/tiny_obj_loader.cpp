@@ -40,8 +40,16 @@
 #include <map>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "tiny_obj_loader.h"
+#include "asset_pack.h"
 
 namespace tinyobj {
 
@@ -650,7 +658,14 @@ std::string MaterialFileReader::operator()(const std::string &matId,
     filepath = matId;
   }
 
-  std::ifstream matIStream(filepath.c_str());
+  // Materials may be stored in an asset pack next to the obj file
+  std::istringstream matIStream;
+  try {
+    auto file = ppgso::pack::open(filepath);
+    matIStream.str(std::string(file.data(), file.size()));
+  } catch (std::runtime_error &) {
+    matIStream.setstate(std::ios::failbit);
+  }
   std::string err = LoadMtl(matMap, materials, matIStream);
   if (!matIStream) {
     std::stringstream ss;
@@ -909,4 +924,457 @@ std::string LoadObj(std::vector<shape_t> &shapes,
 
   return err.str();
 }
+
+//
+// ppgso: parallel loader
+//
+// The file is memory mapped and split into line-aligned chunks. Each chunk is
+// parsed independently (vertex data, faces and the rare g/o/usemtl/mtllib
+// statements), then shapes are assembled in file order so the result matches
+// LoadObj. Vertices are de-duplicated per shape using an open-addressing hash
+// table instead of std::map.
+//
+
+namespace {
+
+// Chunks smaller than this are not worth a separate task
+const size_t OBJ_MIN_CHUNK_SIZE = 256 * 1024;
+
+struct obj_statement {
+  size_t face;      // Number of faces in the chunk preceding the statement
+  char type;        // 'g', 'o', 'u' (usemtl) or 'm' (mtllib)
+  std::string name;
+};
+
+struct obj_chunk {
+  const char *begin, *end;
+  std::vector<float> v, vn, vt;
+  std::vector<vertex_index> faceVertices;
+  std::vector<unsigned int> faceSizes;
+  // Positions in faceVertices (index * 3 + component) holding relative indices
+  std::vector<size_t> relative;
+  std::vector<obj_statement> statements;
+};
+
+class vertex_cache {
+public:
+  explicit vertex_cache(size_t expected) {
+    size_t capacity = 1024;
+    while (capacity < expected * 2)
+      capacity <<= 1;
+    keys.resize(capacity);
+    values.resize(capacity);
+    stamps.resize(capacity, 0);
+  }
+
+  // Slots are invalidated by bumping the generation so clearing is O(1)
+  void clear() {
+    count = 0;
+    if (++generation == 0) {
+      std::fill(stamps.begin(), stamps.end(), 0);
+      generation = 1;
+    }
+  }
+
+  // Returns slot for the key, the slot is empty if the key is not cached yet
+  size_t find(const vertex_index &key) const {
+    size_t mask = keys.size() - 1;
+    size_t slot = hash(key) & mask;
+    while (!empty(slot) &&
+           !(keys[slot].v_idx == key.v_idx && keys[slot].vt_idx == key.vt_idx &&
+             keys[slot].vn_idx == key.vn_idx))
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  bool empty(size_t slot) const { return stamps[slot] != generation; }
+  unsigned int value(size_t slot) const { return values[slot]; }
+
+  void insert(size_t slot, const vertex_index &key, unsigned int value) {
+    keys[slot] = key;
+    values[slot] = value;
+    stamps[slot] = generation;
+    // Keep load factor under 1/2 so probe sequences stay short
+    if (++count * 2 > keys.size())
+      grow();
+  }
+
+private:
+  static size_t hash(const vertex_index &key) {
+    uint32_t h = (uint32_t)key.v_idx * 0x9E3779B1u;
+    h ^= (uint32_t)key.vt_idx * 0x85EBCA77u;
+    h ^= (uint32_t)key.vn_idx * 0xC2B2AE3Du;
+    return h ^ (h >> 15);
+  }
+
+  void grow() {
+    std::vector<vertex_index> oldKeys(keys.size() * 2);
+    std::vector<unsigned int> oldValues(values.size() * 2);
+    std::vector<unsigned int> oldStamps(stamps.size() * 2, 0);
+    oldKeys.swap(keys);
+    oldValues.swap(values);
+    oldStamps.swap(stamps);
+    for (size_t i = 0; i < oldKeys.size(); i++) {
+      if (oldStamps[i] != generation)
+        continue;
+      size_t slot = find(oldKeys[i]);
+      keys[slot] = oldKeys[i];
+      values[slot] = oldValues[i];
+      stamps[slot] = generation;
+    }
+  }
+
+  std::vector<vertex_index> keys;
+  std::vector<unsigned int> values;
+  std::vector<unsigned int> stamps;
+  unsigned int generation = 1;
+  size_t count = 0;
+};
+
+const double POWERS_OF_TEN[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline const char *skipSpace(const char *p, const char *end) {
+  while (p < end && isSpace(*p))
+    p++;
+  return p;
+}
+
+inline const char *skipToken(const char *p, const char *end) {
+  while (p < end && !isSpace(*p))
+    p++;
+  return p;
+}
+
+inline bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+
+// Bounded float parser, accumulates digits in an integer mantissa and scales
+// once by a power of ten. Like parseFloat it always consumes the whole token.
+float parseFloatBounded(const char *&p, const char *end) {
+  p = skipSpace(p, end);
+  const char *tokenEnd = skipToken(p, end);
+  const char *c = p;
+  p = tokenEnd;
+
+  bool negative = false;
+  if (c < tokenEnd && (*c == '+' || *c == '-'))
+    negative = *c++ == '-';
+
+  uint64_t mantissa = 0;
+  int exponent = 0, digits = 0;
+  for (; c < tokenEnd && isDigit(*c); c++, digits++) {
+    if (mantissa < 100000000000000000ull)
+      mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+    else
+      exponent++;
+  }
+  if (c < tokenEnd && *c == '.') {
+    for (c++; c < tokenEnd && isDigit(*c); c++, digits++) {
+      if (mantissa < 100000000000000000ull) {
+        mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+        exponent--;
+      }
+    }
+  }
+  if (digits == 0)
+    return 0.0f;
+
+  if (c < tokenEnd && (*c == 'e' || *c == 'E')) {
+    c++;
+    bool negativeExponent = false;
+    if (c < tokenEnd && (*c == '+' || *c == '-'))
+      negativeExponent = *c++ == '-';
+    int value = 0;
+    for (; c < tokenEnd && isDigit(*c); c++)
+      value = std::min(value * 10 + (*c - '0'), 1000);
+    exponent += negativeExponent ? -value : value;
+  }
+
+  double result = (double)mantissa;
+  if (exponent < 0)
+    result = exponent >= -22 ? result / POWERS_OF_TEN[-exponent]
+                             : result * pow(10.0, exponent);
+  else if (exponent > 0)
+    result = exponent <= 22 ? result * POWERS_OF_TEN[exponent]
+                            : result * pow(10.0, exponent);
+  return (float)(negative ? -result : result);
+}
+
+// Bounded atoi, stops at the next '/' or space like parseTriple
+int parseIndexBounded(const char *&p, const char *end) {
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-'))
+    negative = *p++ == '-';
+  int value = 0;
+  const char *start = p;
+  for (; p < end && isDigit(*p); p++)
+    value = value * 10 + (*p - '0');
+  bool valid = p != start;
+  while (p < end && *p != '/' && !isSpace(*p))
+    p++;
+  return valid ? (negative ? -value : value) : 0;
+}
+
+std::string parseName(const char *p, const char *end) {
+  p = skipSpace(p, end);
+  return std::string(p, skipToken(p, end));
+}
+
+// Resolve OBJ index to zero based, relative indices are resolved against the
+// chunk local count and recorded for a later fix-up with the chunk offset
+inline int resolveIndex(obj_chunk &chunk, int raw, int localCount,
+                        size_t position) {
+  if (raw < 0) {
+    chunk.relative.push_back(position);
+    return localCount + raw;
+  }
+  return fixIndex(raw, localCount);
+}
+
+void parseChunk(obj_chunk &chunk) {
+  const char *line = chunk.begin;
+  while (line < chunk.end) {
+    const char *lineEnd = (const char *)memchr(line, '\n', chunk.end - line);
+    if (!lineEnd)
+      lineEnd = chunk.end;
+    const char *next = lineEnd + 1;
+    if (lineEnd > line && lineEnd[-1] == '\r')
+      lineEnd--;
+
+    const char *token = skipSpace(line, lineEnd);
+    line = next;
+    size_t length = lineEnd - token;
+    if (length < 2)
+      continue;
+
+    if (token[0] == 'v' && isSpace(token[1])) {
+      token += 2;
+      chunk.v.push_back(parseFloatBounded(token, lineEnd));
+      chunk.v.push_back(parseFloatBounded(token, lineEnd));
+      chunk.v.push_back(parseFloatBounded(token, lineEnd));
+    } else if (length > 2 && token[0] == 'v' && token[1] == 'n' &&
+               isSpace(token[2])) {
+      token += 3;
+      chunk.vn.push_back(parseFloatBounded(token, lineEnd));
+      chunk.vn.push_back(parseFloatBounded(token, lineEnd));
+      chunk.vn.push_back(parseFloatBounded(token, lineEnd));
+    } else if (length > 2 && token[0] == 'v' && token[1] == 't' &&
+               isSpace(token[2])) {
+      token += 3;
+      chunk.vt.push_back(parseFloatBounded(token, lineEnd));
+      chunk.vt.push_back(parseFloatBounded(token, lineEnd));
+    } else if (token[0] == 'f' && isSpace(token[1])) {
+      token = skipSpace(token + 2, lineEnd);
+      int vsize = (int)(chunk.v.size() / 3);
+      int vnsize = (int)(chunk.vn.size() / 3);
+      int vtsize = (int)(chunk.vt.size() / 2);
+      unsigned int size = 0;
+      while (token < lineEnd) {
+        size_t position = chunk.faceVertices.size() * 3;
+        vertex_index vi(-1);
+        vi.v_idx = resolveIndex(chunk, parseIndexBounded(token, lineEnd),
+                                vsize, position);
+        if (token < lineEnd && *token == '/') {
+          token++;
+          if (token < lineEnd && *token == '/') {
+            // i//k
+            token++;
+            vi.vn_idx = resolveIndex(chunk, parseIndexBounded(token, lineEnd),
+                                     vnsize, position + 2);
+          } else {
+            // i/j/k or i/j
+            vi.vt_idx = resolveIndex(chunk, parseIndexBounded(token, lineEnd),
+                                     vtsize, position + 1);
+            if (token < lineEnd && *token == '/') {
+              token++;
+              vi.vn_idx = resolveIndex(
+                  chunk, parseIndexBounded(token, lineEnd), vnsize,
+                  position + 2);
+            }
+          }
+        }
+        chunk.faceVertices.push_back(vi);
+        size++;
+        token = skipSpace(token, lineEnd);
+      }
+      chunk.faceSizes.push_back(size);
+    } else if (token[0] == 'g' && isSpace(token[1])) {
+      chunk.statements.push_back(
+          {chunk.faceSizes.size(), 'g', parseName(token + 2, lineEnd)});
+    } else if (token[0] == 'o' && isSpace(token[1])) {
+      chunk.statements.push_back(
+          {chunk.faceSizes.size(), 'o', parseName(token + 2, lineEnd)});
+    } else if (length > 6 && 0 == strncmp(token, "usemtl", 6) &&
+               isSpace(token[6])) {
+      chunk.statements.push_back(
+          {chunk.faceSizes.size(), 'u', parseName(token + 7, lineEnd)});
+    } else if (length > 6 && 0 == strncmp(token, "mtllib", 6) &&
+               isSpace(token[6])) {
+      chunk.statements.push_back(
+          {chunk.faceSizes.size(), 'm', parseName(token + 7, lineEnd)});
+    }
+  }
+}
+
+} // namespace
+
+std::string LoadObjParallel(std::vector<shape_t> &shapes,
+                            std::vector<material_t> &materials, // [output]
+                            const char *filename, const char *mtl_basepath) {
+  shapes.clear();
+  std::stringstream err;
+
+  std::unique_ptr<ppgso::pack::File> file;
+  try {
+    file.reset(new ppgso::pack::File(ppgso::pack::open(filename)));
+  } catch (std::runtime_error &) {
+    err << "Cannot open file [" << filename << "]" << std::endl;
+    return err.str();
+  }
+  const char *data = file->data();
+  const char *dataEnd = data + file->size();
+
+  // Split the file into line-aligned chunks
+  size_t threads = 1;
+#ifdef _OPENMP
+  threads = (size_t)omp_get_max_threads();
+#endif
+  size_t count = std::max<size_t>(
+      1, std::min(file->size() / OBJ_MIN_CHUNK_SIZE, threads * 4));
+  std::vector<obj_chunk> chunks(count);
+  const char *begin = data;
+  for (size_t i = 0; i < count; i++) {
+    const char *end = i + 1 == count ? dataEnd : data + file->size() * (i + 1) / count;
+    if (end < begin)
+      end = begin;
+    const char *newline = (const char *)memchr(end, '\n', dataEnd - end);
+    end = newline ? newline + 1 : dataEnd;
+    chunks[i].begin = begin;
+    chunks[i].end = end;
+    begin = end;
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < (int)count; i++)
+    parseChunk(chunks[i]);
+
+  // Concatenate vertex data, offsets of each chunk are needed to resolve relative indices
+  std::vector<float> v, vn, vt;
+  std::vector<int> vBase(count), vnBase(count), vtBase(count);
+  size_t faceVertexCount = 0;
+  for (size_t i = 0; i < count; i++) {
+    vBase[i] = (int)(v.size() / 3);
+    vnBase[i] = (int)(vn.size() / 3);
+    vtBase[i] = (int)(vt.size() / 2);
+    v.insert(v.end(), chunks[i].v.begin(), chunks[i].v.end());
+    vn.insert(vn.end(), chunks[i].vn.begin(), chunks[i].vn.end());
+    vt.insert(vt.end(), chunks[i].vt.begin(), chunks[i].vt.end());
+    faceVertexCount += chunks[i].faceVertices.size();
+  }
+
+  #pragma omp parallel for
+  for (int i = 0; i < (int)count; i++) {
+    auto &chunk = chunks[i];
+    for (auto position : chunk.relative) {
+      auto &vi = chunk.faceVertices[position / 3];
+      switch (position % 3) {
+      case 0: vi.v_idx += vBase[i]; break;
+      case 1: vi.vt_idx += vtBase[i]; break;
+      default: vi.vn_idx += vnBase[i]; break;
+      }
+    }
+  }
+
+  // Assemble shapes in file order
+  std::string basePath = mtl_basepath ? mtl_basepath : "";
+  MaterialFileReader matFileReader(basePath);
+  std::map<std::string, int> material_map;
+  vertex_cache cache(std::min(faceVertexCount, v.size() / 3 + vt.size() / 2 + vn.size() / 3));
+  int vsize = (int)(v.size() / 3), vnsize = (int)(vn.size() / 3), vtsize = (int)(vt.size() / 2);
+  int material = -1;
+  std::string name;
+  shape_t shape;
+  bool hasFaces = false;
+
+  auto flush = [&]() {
+    if (hasFaces) {
+      shape.name = name;
+      shapes.push_back(std::move(shape));
+    }
+    shape = shape_t();
+    cache.clear();
+    hasFaces = false;
+  };
+
+  auto addVertex = [&](const vertex_index &vi, unsigned int &index) {
+    if (vi.v_idx < 0 || vi.v_idx >= vsize || vi.vn_idx >= vnsize || vi.vt_idx >= vtsize)
+      return false;
+    size_t slot = cache.find(vi);
+    if (!cache.empty(slot)) {
+      index = cache.value(slot);
+      return true;
+    }
+    auto &mesh = shape.mesh;
+    mesh.positions.insert(mesh.positions.end(), &v[3 * vi.v_idx], &v[3 * vi.v_idx] + 3);
+    if (vi.vn_idx >= 0)
+      mesh.normals.insert(mesh.normals.end(), &vn[3 * vi.vn_idx], &vn[3 * vi.vn_idx] + 3);
+    if (vi.vt_idx >= 0)
+      mesh.texcoords.insert(mesh.texcoords.end(), &vt[2 * vi.vt_idx], &vt[2 * vi.vt_idx] + 2);
+    index = (unsigned int)(mesh.positions.size() / 3 - 1);
+    cache.insert(slot, vi, index);
+    return true;
+  };
+
+  for (auto &chunk : chunks) {
+    size_t statement = 0, vertex = 0;
+    for (size_t face = 0; face <= chunk.faceSizes.size(); face++) {
+      for (; statement < chunk.statements.size() && chunk.statements[statement].face == face; statement++) {
+        auto &s = chunk.statements[statement];
+        if (s.type == 'm') {
+          std::string err_mtl = matFileReader(s.name, materials, material_map);
+          if (!err_mtl.empty())
+            return err_mtl;
+          continue;
+        }
+        flush();
+        if (s.type == 'u') {
+          auto it = material_map.find(s.name);
+          material = it != material_map.end() ? it->second : -1;
+        } else {
+          name = s.name;
+        }
+      }
+      if (face == chunk.faceSizes.size())
+        break;
+
+      // Polygon -> face fan conversion
+      unsigned int size = chunk.faceSizes[face];
+      const vertex_index *vertices = &chunk.faceVertices[vertex];
+      vertex += size;
+      hasFaces = true;
+      if (size < 3)
+        continue;
+      unsigned int v0, v1, v2;
+      if (!addVertex(vertices[0], v0) || !addVertex(vertices[1], v2)) {
+        err << "Invalid vertex index in file [" << filename << "]" << std::endl;
+        return err.str();
+      }
+      for (unsigned int k = 2; k < size; k++) {
+        v1 = v2;
+        if (!addVertex(vertices[k], v2)) {
+          err << "Invalid vertex index in file [" << filename << "]" << std::endl;
+          return err.str();
+        }
+        shape.mesh.indices.push_back(v0);
+        shape.mesh.indices.push_back(v1);
+        shape.mesh.indices.push_back(v2);
+        shape.mesh.material_ids.push_back(material);
+      }
+    }
+  }
+  flush();
+
+  return err.str();
+}
 }
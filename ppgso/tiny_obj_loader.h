@@ -81,6 +81,15 @@ std::string LoadObj(std::vector<shape_t> &shapes,       // [output]
                     std::vector<material_t> &materials, // [output]
                     const char *filename, const char *mtl_basepath = nullptr);
 
+/// Loads .obj from a memory mapped file or an asset pack (see asset_pack.h).
+/// Line-aligned chunks of the file are parsed in parallel and vertices are
+/// de-duplicated using a hash table. Produces the same output as LoadObj.
+/// Returns empty string when loading .obj success.
+std::string LoadObjParallel(std::vector<shape_t> &shapes,       // [output]
+                            std::vector<material_t> &materials, // [output]
+                            const char *filename,
+                            const char *mtl_basepath = nullptr);
+
 /// Loads object from a std::istream, uses GetMtlIStreamFn to retrieve
 /// std::istream for materials.
 /// Returns empty string when loading .obj success.
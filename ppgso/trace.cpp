@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "trace.h"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // Events each thread can record in one capture, later events are dropped
+  const size_t CAPACITY = 1 << 15;
+
+  struct Event {
+    const char *name;
+    char detail[ppgso::trace::Scope::DETAIL_SIZE];
+    long long start, duration;
+  };
+
+  /*!
+   * Events of a single thread. Only the owning thread writes, it publishes an event by increasing count.
+   * The render thread reads the published events of the finished session when writing the file,
+   * a new session only starts after that, so the owner never overwrites events being read.
+   */
+  struct Buffer {
+    int id;
+    std::string name;
+    std::vector<Event> events;
+    std::atomic<unsigned> session{0};
+    std::atomic<size_t> count{0};
+    size_t dropped = 0;
+  };
+
+  // Buffers live until the program ends, threads may still finish scopes during static destruction
+  struct State {
+    State() {
+      epoch = Clock::now();
+      if (auto frames = std::getenv("PPGSO_TRACE")) {
+        char *end;
+        auto value = std::strtol(frames, &end, 10);
+        if (*frames == '\0' || *end != '\0' || value <= 0) {
+          std::stringstream msg;
+          msg << "Environment variable PPGSO_TRACE must be a positive number of frames, got " << frames;
+          throw std::runtime_error(msg.str());
+        }
+        auto file = std::getenv("PPGSO_TRACE_FILE");
+        begin((unsigned) value, file ? file : "trace.json");
+      }
+    }
+
+    void begin(unsigned count, const std::string &path) {
+      frames = count;
+      file = path;
+      frameStart = captureStart = nanoseconds(Clock::now());
+      session.fetch_add(1, std::memory_order_relaxed);
+      capturing.store(true, std::memory_order_release);
+    }
+
+    long long nanoseconds(Clock::time_point time) const {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count();
+    }
+
+    Clock::time_point epoch;
+    std::atomic<bool> capturing{false};
+    std::atomic<unsigned> session{0};
+    std::atomic<long long> captureStart{0};
+    long long frameStart = 0;
+    unsigned frames = 0, frame = 0;
+    std::string file;
+
+    // Only taken when a thread records its first event
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+  };
+
+  State &state() {
+    static auto instance = new State;
+    return *instance;
+  }
+
+  Buffer &buffer() {
+    thread_local Buffer *local = nullptr;
+    if (!local) {
+      auto &s = state();
+      std::lock_guard<std::mutex> lock{s.mutex};
+      s.buffers.emplace_back(new Buffer);
+      local = s.buffers.back().get();
+      local->id = (int) s.buffers.size();
+      local->name = "thread " + std::to_string(local->id);
+    }
+    return *local;
+  }
+
+  void record(const char *name, const char (&detail)[ppgso::trace::Scope::DETAIL_SIZE], Clock::time_point start, Clock::time_point end) {
+    auto &s = state();
+    if (!s.capturing.load(std::memory_order_acquire)) return;
+
+    // Scopes opened before the capture started are incomplete
+    auto begin = s.nanoseconds(start);
+    if (begin < s.captureStart.load(std::memory_order_relaxed)) return;
+
+    auto &b = buffer();
+    auto session = s.session.load(std::memory_order_relaxed);
+    if (b.session.load(std::memory_order_relaxed) != session) {
+      b.count.store(0, std::memory_order_relaxed);
+      b.dropped = 0;
+      b.session.store(session, std::memory_order_release);
+    }
+
+    auto index = b.count.load(std::memory_order_relaxed);
+    if (index == CAPACITY) {
+      b.dropped++;
+      return;
+    }
+    if (b.events.size() < CAPACITY) b.events.resize(CAPACITY);
+
+    auto &event = b.events[index];
+    event.name = name;
+    std::memcpy(event.detail, detail, sizeof(event.detail));
+    event.start = begin;
+    event.duration = s.nanoseconds(end) - begin;
+    b.count.store(index + 1, std::memory_order_release);
+  }
+
+  void writeString(std::ostream &out, const char *text) {
+    out << '"';
+    for (auto c = text; *c; c++) {
+      if (*c == '"' || *c == '\\') {
+        out << '\\' << *c;
+      } else if ((unsigned char) *c < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+        out << escaped;
+      } else {
+        out << *c;
+      }
+    }
+    out << '"';
+  }
+
+  void writeTime(std::ostream &out, long long nanoseconds) {
+    // Trace timestamps are microseconds
+    char text[32];
+    std::snprintf(text, sizeof(text), "%lld.%03lld", nanoseconds / 1000, nanoseconds % 1000);
+    out << text;
+  }
+
+  void write(State &s) {
+    std::ofstream out{s.file};
+    if (!out) throw std::runtime_error("Failed to open trace file " + s.file);
+
+    std::vector<std::pair<Buffer *, std::string>> buffers;
+    {
+      std::lock_guard<std::mutex> lock{s.mutex};
+      for (auto &b : s.buffers) buffers.emplace_back(b.get(), b->name);
+    }
+
+    auto session = s.session.load(std::memory_order_relaxed);
+    size_t events = 0, dropped = 0;
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (auto &item : buffers) {
+      auto b = item.first;
+      out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->id
+          << ",\"args\":{\"name\":";
+      writeString(out, item.second.c_str());
+      out << "}}";
+      first = false;
+
+      if (b->session.load(std::memory_order_acquire) != session) continue;
+      auto count = b->count.load(std::memory_order_acquire);
+      for (size_t i = 0; i < count; i++) {
+        auto &event = b->events[i];
+        out << ",\n{\"name\":";
+        writeString(out, event.name);
+        out << ",\"cat\":\"ppgso\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->id << ",\"ts\":";
+        writeTime(out, event.start - s.captureStart.load(std::memory_order_relaxed));
+        out << ",\"dur\":";
+        writeTime(out, event.duration);
+        if (event.detail[0]) {
+          out << ",\"args\":{\"detail\":";
+          writeString(out, event.detail);
+          out << "}";
+        }
+        out << "}";
+      }
+      events += count;
+      dropped += b->dropped;
+    }
+    out << "\n]}" << std::endl;
+
+    std::cout << "Trace of " << s.frame << " frames written to " << s.file << " (" << events << " events";
+    if (dropped > 0) std::cout << ", " << dropped << " dropped";
+    std::cout << ")" << std::endl;
+  }
+}
+
+ppgso::trace::Scope::Scope(const char *name, const char *detail) : name{name} {
+  active = state().capturing.load(std::memory_order_relaxed);
+  if (!active) return;
+
+  detail = detail ? detail : "";
+  std::strncpy(this->detail, detail, DETAIL_SIZE - 1);
+  this->detail[DETAIL_SIZE - 1] = '\0';
+  start = Clock::now();
+}
+
+ppgso::trace::Scope::Scope(const char *name, const std::string &detail) : Scope{name, detail.c_str()} {}
+
+ppgso::trace::Scope::~Scope() {
+  if (active) record(name, detail, start, Clock::now());
+}
+
+void ppgso::trace::capture(unsigned frames, const std::string &file) {
+  stop();
+  if (frames > 0) state().begin(frames, file);
+}
+
+bool ppgso::trace::isCapturing() {
+  return state().capturing.load(std::memory_order_relaxed);
+}
+
+void ppgso::trace::stop() {
+  auto &s = state();
+  if (!s.capturing.load(std::memory_order_relaxed)) return;
+  s.capturing.store(false, std::memory_order_release);
+  write(s);
+  s.frame = 0;
+}
+
+void ppgso::trace::endFrame() {
+  auto &s = state();
+  if (!s.capturing.load(std::memory_order_relaxed)) return;
+
+  auto now = Clock::now();
+  char number[ppgso::trace::Scope::DETAIL_SIZE];
+  std::snprintf(number, sizeof(number), "%u", s.frame);
+  record("frame", number, s.epoch + std::chrono::nanoseconds(s.frameStart), now);
+  s.frameStart = s.nanoseconds(now);
+
+  if (++s.frame >= s.frames) stop();
+}
+
+void ppgso::trace::setThreadName(const std::string &name) {
+  auto &b = buffer();
+  std::lock_guard<std::mutex> lock{state().mutex};
+  b.name = name;
+}
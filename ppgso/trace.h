@@ -0,0 +1,94 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+namespace ppgso {
+
+  /*!
+   * Timeline tracing in the Chrome trace-event JSON format, the files open in Perfetto or chrome://tracing.
+   * Every thread records its scopes into its own buffer without locking, the buffers are written to a file
+   * once the requested number of frames is captured. Outside of a capture a scope costs a single branch.
+   *
+   * A capture starts with the program when the PPGSO_TRACE environment variable holds the number of frames,
+   * PPGSO_TRACE_FILE names the output file (trace.json by default).
+   * Scopes may be recorded on any thread, the remaining functions must be called on the render thread.
+   */
+  namespace trace {
+
+    /*!
+     * Records the time from construction to destruction as a complete event, use PPGSO_TRACE_SCOPE.
+     */
+    class Scope {
+    public:
+      /*!
+       * Open scope on the calling thread.
+       *
+       * @param name - Name of the event, must outlive the capture, usually a string literal.
+       * @param detail - Optional text shown in the arguments of the event, for example a file path.
+       */
+      explicit Scope(const char *name, const char *detail = nullptr);
+      Scope(const char *name, const std::string &detail);
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+      ~Scope();
+
+      // Longer details are truncated
+      static const size_t DETAIL_SIZE = 40;
+
+    private:
+      const char *name;
+      char detail[DETAIL_SIZE];
+      bool active;
+      std::chrono::steady_clock::time_point start;
+    };
+
+    /*!
+     * Start capturing, a capture in progress is written first.
+     *
+     * @param frames - Number of frames to capture.
+     * @param file - Path to the JSON file written when the capture ends.
+     */
+    void capture(unsigned frames, const std::string &file = "trace.json");
+
+    /*!
+     * Check whether a capture is in progress.
+     *
+     * @return - True while capturing.
+     */
+    bool isCapturing();
+
+    /*!
+     * End the capture early and write the file, does nothing when not capturing.
+     * Called by the Window destructor so runs shorter than the capture are not lost.
+     */
+    void stop();
+
+    /*!
+     * Finish the frame, record it as an event and write the file after the last captured frame.
+     * Called by Window::pollEvents.
+     */
+    void endFrame();
+
+    /*!
+     * Name the calling thread in the trace.
+     *
+     * @param name - Name shown for the thread, for example "render".
+     */
+    void setThreadName(const std::string &name);
+  }
+}
+
+#define PPGSO_TRACE_CONCAT_(a, b) a##b
+#define PPGSO_TRACE_CONCAT(a, b) PPGSO_TRACE_CONCAT_(a, b)
+
+/*!
+ * Trace the rest of the enclosing block, takes the arguments of trace::Scope.
+ * Defining PPGSO_NO_TRACE removes the instrumentation from the build.
+ */
+#ifndef PPGSO_NO_TRACE
+#define PPGSO_TRACE_SCOPE(...) ppgso::trace::Scope PPGSO_TRACE_CONCAT(ppgsoTraceScope, __LINE__){__VA_ARGS__}
+#else
+#define PPGSO_TRACE_SCOPE(...) do {} while (false)
+#endif
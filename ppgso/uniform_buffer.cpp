@@ -0,0 +1,35 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "uniform_buffer.h"
+#include "gl_state.h"
+
+ppgso::UniformBuffer::UniformBuffer(size_t size, GLuint binding) : binding{binding}, size{size} {
+  glGenBuffers(1, &buffer);
+  gl::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr) size, nullptr, GL_DYNAMIC_DRAW);
+  bind();
+}
+
+ppgso::UniformBuffer::~UniformBuffer() {
+  gl::deleteBuffer(buffer);
+}
+
+void ppgso::UniformBuffer::update(const void *data, size_t length) {
+  if (length > size) {
+    std::stringstream msg;
+    msg << "Uniform buffer update of " << length << " bytes exceeds its size of " << size << " bytes";
+    throw std::runtime_error(msg.str());
+  }
+  gl::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+  glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr) size, nullptr, GL_DYNAMIC_DRAW);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr) length, data);
+}
+
+void ppgso::UniformBuffer::bind() const {
+  gl::bindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+GLuint ppgso::UniformBuffer::getBinding() const {
+  return binding;
+}
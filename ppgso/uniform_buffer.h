@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+
+#include <GL/glew.h>
+
+namespace ppgso {
+
+  /*!
+   * Uniform buffer object bound to an indexed binding point. Programs read it through a uniform block
+   * bound to the same point using Shader::setUniformBlock, so data shared by many programs is uploaded once.
+   * The layout of the uploaded data has to follow the std140 rules of the block.
+   */
+  class UniformBuffer {
+  public:
+    /*!
+     * Create buffer and bind it to a binding point.
+     *
+     * @param size - Size of the buffer in bytes.
+     * @param binding - Uniform buffer binding point index.
+     */
+    UniformBuffer(size_t size, GLuint binding);
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    ~UniformBuffer();
+
+    /*!
+     * Replace contents of the buffer, the previous storage is orphaned so the upload
+     * does not wait for draw calls that still read it.
+     *
+     * @param data - Data to upload.
+     * @param size - Number of bytes to upload, at most the size of the buffer.
+     */
+    void update(const void *data, size_t size);
+
+    /*!
+     * Bind the buffer to its binding point again, needed only when the binding was changed elsewhere.
+     */
+    void bind() const;
+
+    /*!
+     * Get binding point index.
+     *
+     * @return - Uniform buffer binding point index.
+     */
+    GLuint getBinding() const;
+
+  private:
+    GLuint buffer = 0;
+    GLuint binding;
+    size_t size;
+  };
+}
@@ -1,50 +1,148 @@
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#ifdef PPGSO_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 #include "window.h"
+#include "image_bmp.h"
+#include "profiler.h"
+#include "trace.h"
+
+namespace {
+  // Time step of a headless frame, negative time means getTime uses the GLFW timer
+  const double HEADLESS_FRAME_TIME = 1.0 / 60.0;
+  double headlessTime = -1.0;
+
+  unsigned long readNumber(const char *name) {
+    auto value = std::getenv(name);
+    if (!value) return 0;
+
+    char *end;
+    auto number = std::strtoul(value, &end, 10);
+    if (*value == '\0' || *end != '\0') {
+      std::stringstream msg;
+      msg << "Environment variable " << name << " must be a number, got " << value;
+      throw std::runtime_error(msg.str());
+    }
+    return number;
+  }
+
+#ifdef PPGSO_EGL
+  // Displays of an EGL platform to try in order
+  std::vector<EGLDisplay> platformDisplays(const std::string &platform) {
+    if (platform == "default") return {eglGetDisplay(EGL_DEFAULT_DISPLAY)};
+
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay) return {};
+    if (platform == "surfaceless")
+      return {getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)};
+
+    // Hardware devices first, Mesa lists its software device last
+    auto queryDevices = (PFNEGLQUERYDEVICESEXTPROC) eglGetProcAddress("eglQueryDevicesEXT");
+    EGLDeviceEXT devices[16];
+    EGLint count = 0;
+    if (!queryDevices || !queryDevices(16, devices, &count)) return {};
+
+    std::vector<EGLDisplay> displays;
+    for (EGLint i = 0; i < count; i++)
+      displays.push_back(getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr));
+    return displays;
+  }
+#endif
+}
+
+#ifdef PPGSO_EGL
+struct ppgso::Window::Headless {
+  EGLDisplay display = EGL_NO_DISPLAY;
+  EGLContext context = EGL_NO_CONTEXT;
+  EGLSurface surface = EGL_NO_SURFACE;
+};
+#else
+struct ppgso::Window::Headless {};
+#endif
 
 bool ppgso::Window::pollEvents() {
   onIdle();
-  glfwSwapBuffers(window);
+  endFrame();
+  if (headless) {
+    profiler::endFrame();
+    trace::endFrame();
+    return !closing;
+  }
+
+  {
+    // Waits for vsync or for the GPU when it is behind
+    profiler::Scope scope{"swap"};
+    PPGSO_TRACE_SCOPE("swap");
+    glfwSwapBuffers(window);
+  }
   glfwPollEvents();
+  profiler::endFrame();
+  trace::endFrame();
   return !glfwWindowShouldClose(window);
 }
 
+void ppgso::Window::endFrame() {
+  frame++;
+
+  // The back buffer still holds the frame, save it before it is swapped
+  bool last = frames > 0 && frame >= frames;
+  if (!dumpPrefix.empty() && ((dumpInterval > 0 && frame % dumpInterval == 0) || (dumpInterval == 0 && last)))
+    saveImage(dumpPrefix + std::to_string(frame) + ".bmp");
+
+  if (headless) headlessTime += HEADLESS_FRAME_TIME;
+  if (last) close();
+}
+
 ppgso::Window::Window(std::string title, int width, int height) : title{title}, width{width}, height{height} {
-  // Set up glfw
-  glfwInstance::Init();
+  trace::setThreadName("render");
+  frames = readNumber("PPGSO_FRAMES");
+  dumpInterval = readNumber("PPGSO_DUMP_INTERVAL");
+  if (auto prefix = std::getenv("PPGSO_DUMP")) dumpPrefix = prefix;
 
-  glfwSetErrorCallback(glfw_error_callback);
+  if (auto platform = std::getenv("PPGSO_HEADLESS")) {
+    initHeadless(platform);
+  } else {
+    // Set up glfw
+    glfwInstance::Init();
 
-  glfwWindowHint(GLFW_SAMPLES, 4);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwSetErrorCallback(glfw_error_callback);
+
+    glfwWindowHint(GLFW_SAMPLES, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifndef NDEBUG
-  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 #endif
 
-  window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
-  if (!window)
-    throw std::runtime_error("Failed to initialize GLFW Window!");
+    window = glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr);
+    if (!window)
+      throw std::runtime_error("Failed to initialize GLFW Window!");
 
-  glfwSetKeyCallback(window, glfw_key_callback);
-  glfwSetCursorPosCallback(window, glfw_cursor_pos_callback);
-  glfwSetMouseButtonCallback(window, glfw_mouse_button_callback);
-  glfwSetWindowRefreshCallback(window, glfw_window_refresh_callback);
+    glfwSetKeyCallback(window, glfw_key_callback);
+    glfwSetCursorPosCallback(window, glfw_cursor_pos_callback);
+    glfwSetMouseButtonCallback(window, glfw_mouse_button_callback);
+    glfwSetWindowRefreshCallback(window, glfw_window_refresh_callback);
 
-  glfwMakeContextCurrent(window);
+    glfwMakeContextCurrent(window);
+  }
 
   // Initialize glew
   glewInstance::Init();
 
-  windows.insert({window, this});
+  if (window) windows.insert({window, this});
 
 #ifndef NDEBUG
   // Basic OpenGL information to print
@@ -55,9 +153,93 @@ ppgso::Window::Window(std::string title, int width, int height) : title{title},
 #endif
 }
 
+void ppgso::Window::initHeadless(const std::string &platform) {
+#ifdef PPGSO_EGL
+  headless = std::make_unique<Headless>();
+
+  std::vector<std::string> platforms = {platform};
+  if (platform != "surfaceless" && platform != "device" && platform != "default")
+    platforms = {"surfaceless", "device", "default"};
+
+  // Take the first display that initializes and offers a pbuffer config for desktop OpenGL
+  EGLint configAttributes[] = {
+          EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+          EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+          EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+          EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+          EGL_NONE
+  };
+  EGLConfig config = nullptr;
+  for (auto &name : platforms) {
+    for (auto display : platformDisplays(name)) {
+      if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) continue;
+
+      EGLint count = 0;
+      if (eglBindAPI(EGL_OPENGL_API) && eglChooseConfig(display, configAttributes, &config, 1, &count) && count > 0) {
+        headless->display = display;
+        break;
+      }
+      eglTerminate(display);
+    }
+    if (headless->display != EGL_NO_DISPLAY) break;
+  }
+  if (headless->display == EGL_NO_DISPLAY) {
+    std::stringstream msg;
+    msg << "Failed to initialize EGL display with OpenGL support for headless platform " << platform;
+    throw std::runtime_error(msg.str());
+  }
+
+  EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+  headless->surface = eglCreatePbufferSurface(headless->display, config, surfaceAttributes);
+
+  EGLint flags = EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR;
+#ifndef NDEBUG
+  flags |= EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR;
+#endif
+  EGLint contextAttributes[] = {
+          EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+          EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+          EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+          EGL_CONTEXT_FLAGS_KHR, flags,
+          EGL_NONE
+  };
+  headless->context = eglCreateContext(headless->display, config, EGL_NO_CONTEXT, contextAttributes);
+
+  if (headless->surface == EGL_NO_SURFACE || headless->context == EGL_NO_CONTEXT ||
+      !eglMakeCurrent(headless->display, headless->surface, headless->surface, headless->context)) {
+    std::stringstream msg;
+    msg << "Failed to create headless OpenGL 3.3 context, EGL error 0x" << std::hex << eglGetError();
+    throw std::runtime_error(msg.str());
+  }
+
+  headlessTime = 0;
+#else
+  throw std::runtime_error("Headless mode requires ppgso to be built with EGL");
+#endif
+}
+
 ppgso::Window::~Window() {
-  windows.erase(window);
-  glfwDestroyWindow(window);
+  // Write a capture that did not reach its last frame
+  try {
+    trace::stop();
+  } catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+  }
+
+  if (window) {
+    windows.erase(window);
+    glfwDestroyWindow(window);
+  }
+
+#ifdef PPGSO_EGL
+  if (headless && headless->display != EGL_NO_DISPLAY) {
+    eglMakeCurrent(headless->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (headless->context != EGL_NO_CONTEXT) eglDestroyContext(headless->display, headless->context);
+    if (headless->surface != EGL_NO_SURFACE) eglDestroySurface(headless->display, headless->surface);
+    eglTerminate(headless->display);
+    headlessTime = -1.0;
+  }
+#endif
 }
 
 void ppgso::Window::glfw_key_callback(GLFWwindow *window, int key, int scanCode, int action, int mods) {
@@ -76,17 +258,21 @@ void ppgso::Window::glfw_error_callback(int error, const char *description) {
 }
 
 void ppgso::Window::resetViewport() {
-  int fbWidth, fbHeight;
-  glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+  int fbWidth = width, fbHeight = height;
+  if (window) glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
   glViewport(0, 0, fbWidth, fbHeight);
 }
 
 void ppgso::Window::showCursor() {
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+  if (window) glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 }
 
 void ppgso::Window::hideCursor() {
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+  if (window) glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+}
+
+void ppgso::Window::disableCursor() {
+  if (window) glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 }
 
 void ppgso::Window::glfw_cursor_pos_callback(GLFWwindow *window, double cursorX, double cursorY) {
@@ -98,7 +284,8 @@ void ppgso::Window::glfw_mouse_button_callback(GLFWwindow *window, int button, i
 }
 
 void ppgso::Window::close() {
-  glfwSetWindowShouldClose(window, GLFW_TRUE);
+  if (window) glfwSetWindowShouldClose(window, GLFW_TRUE);
+  closing = true;
 }
 
 void ppgso::Window::glfw_window_refresh_callback(GLFWwindow *window) {
@@ -106,9 +293,43 @@ void ppgso::Window::glfw_window_refresh_callback(GLFWwindow *window) {
 }
 
 void ppgso::Window::resize(int width, int height) {
+  if (!window) throw std::runtime_error("Headless windows can not be resized");
   glfwSetWindowSize(window, width, height);
 }
 
+bool ppgso::Window::isHeadless() const {
+  return headless != nullptr;
+}
+
+void ppgso::Window::saveImage(const std::string &bmp) {
+  int fbWidth = width, fbHeight = height;
+  if (window) glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+
+  // Read the default framebuffer even when the program left its own one bound
+  GLint readFramebuffer;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  Image image{fbWidth, fbHeight};
+  auto &framebuffer = image.getFramebuffer();
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, fbWidth, fbHeight, GL_RGB, GL_UNSIGNED_BYTE, framebuffer.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint) readFramebuffer);
+
+  // OpenGL rows start at the bottom
+  for (int y = 0; y < fbHeight / 2; y++)
+    std::swap_ranges(framebuffer.begin() + y * fbWidth, framebuffer.begin() + (y + 1) * fbWidth,
+                     framebuffer.begin() + (fbHeight - 1 - y) * fbWidth);
+
+  image::saveBMP(image, bmp);
+}
+
+double ppgso::Window::getTime() {
+  if (headlessTime >= 0) return headlessTime;
+  return glfwGetTime();
+}
+
 ppgso::Window::glewInstance& ppgso::Window::glewInstance::Init() {
   static glewInstance instance;
   return instance;
@@ -116,6 +337,8 @@ ppgso::Window::glewInstance& ppgso::Window::glewInstance::Init() {
 
 ppgso::Window::glewInstance::glewInstance() {
   glewExperimental = GL_TRUE;
+
+  // Without a GLX display glewInit reports an error after loading the OpenGL functions, the version check decides
   glewInit();
 
   if (!glewIsSupported("GL_VERSION_3_3"))
@@ -140,6 +363,7 @@ ppgso::Window::glfwInstance& ppgso::Window::glfwInstance::Init() {
 }
 
 void ppgso::Window::fpsLimit(bool limit) {
+  if (!window) return;
   if(limit) glfwSwapInterval(1);
   glfwSwapInterval(0);
 }
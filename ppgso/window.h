@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <map>
+#include <memory>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -8,6 +9,21 @@
 namespace ppgso {
   /*!
    * Simple GLFW wrapper used for managing a single window and its events.
+   *
+   * Programs can also run headless, without a display, when the PPGSO_HEADLESS environment variable is set.
+   * The OpenGL 3.3 core context is then created by EGL with an offscreen pbuffer as the default framebuffer,
+   * which works with Mesa's llvmpipe software renderer (LIBGL_ALWAYS_SOFTWARE=1). The value selects the EGL platform:
+   * surfaceless (Mesa), device (EGL_EXT_platform_device) or default, any other value tries them in this order.
+   * Headless windows receive no input events and getTime advances by a fixed step every frame,
+   * so runs are reproducible.
+   *
+   * These environment variables apply to both modes:
+   * PPGSO_FRAMES - Close the window after this number of frames.
+   * PPGSO_DUMP - Save frames to BMP files named PPGSO_DUMP followed by the frame number.
+   * PPGSO_DUMP_INTERVAL - Save every n-th frame, by default only the last frame of PPGSO_FRAMES is saved.
+   *
+   * Frames end in pollEvents, which also finishes the frame of the profiler and of the trace
+   * (see profiler::endFrame and trace::endFrame).
    */
   class Window {
   private:
@@ -37,14 +53,26 @@ namespace ppgso {
     static void glfw_mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
     static void glfw_window_refresh_callback(GLFWwindow *window);
 
+    // EGL display, context and pbuffer of a headless window
+    struct Headless;
+
+    void initHeadless(const std::string &platform);
+    void endFrame();
+
+    std::unique_ptr<Headless> headless;
+    unsigned long frame = 0, frames = 0, dumpInterval = 0;
+    std::string dumpPrefix;
+    bool closing = false;
+
   protected:
-    GLFWwindow *window;
+    // GLFW window, nullptr when headless
+    GLFWwindow *window = nullptr;
   public:
     const std::string title;
     int width, height;
 
     /*!
-     * Open new Window and initialize OpenGL 3.3 context
+     * Open new Window and initialize OpenGL 3.3 context, headless when PPGSO_HEADLESS is set
      * @param title Window title to show in the title bar
      * @param width Horizontal size of the window
      * @param height Vertical size of the window
@@ -109,6 +137,11 @@ namespace ppgso {
      */
     void showCursor();
 
+    /*!
+     * Hide mouse cursor and keep it in the window, cursor positions are then unlimited
+     */
+    void disableCursor();
+
     /*!
      * Close the window
      */
@@ -125,6 +158,24 @@ namespace ppgso {
      * @param limit - When true GLFW window refresh rate will use vsync
      */
     void fpsLimit(bool limit);
+
+    /*!
+     * Check whether the window renders offscreen without a display
+     * @return True when created with PPGSO_HEADLESS
+     */
+    bool isHeadless() const;
+
+    /*!
+     * Save the current content of the default framebuffer, call at the end of onIdle to get the finished frame
+     * @param bmp Name of the BMP file to save to
+     */
+    void saveImage(const std::string &bmp);
+
+    /*!
+     * Get time in seconds to animate by, use instead of glfwGetTime so headless runs work
+     * @return Seconds since GLFW initialization, or frames rendered times a fixed step when headless
+     */
+    static double getTime();
   };
 }
 
@@ -8,6 +8,10 @@ uniform mat4 ProjectionMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ModelMatrix;
 
+// Dequantization of compressed meshes, identity for float meshes (see ppgso::Mesh)
+uniform vec3 PositionScale = vec3(1.0);
+uniform vec3 PositionOffset = vec3(0.0);
+
 // Passed to fragment shader
 out vec3 vertexColor;
 
@@ -16,5 +20,5 @@ void main() {
   vertexColor = Color;
 
   // Calculate the final position on screen
-  gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(Position, 1.0);
+  gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(Position * PositionScale + PositionOffset, 1.0);
 }
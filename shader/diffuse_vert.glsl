@@ -9,6 +9,22 @@ uniform mat4 ProjectionMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ModelMatrix;
 
+// Dequantization of compressed meshes, identity for float meshes (see ppgso::Mesh)
+uniform vec3 PositionScale = vec3(1.0);
+uniform vec3 PositionOffset = vec3(0.0);
+uniform bool OctahedralNormals = false;
+
+// Decode octahedral normal stored as integers in <-127, 127>
+vec3 decodeNormal(vec3 n) {
+  if (!OctahedralNormals) return n;
+  vec2 f = n.xy / 127.0;
+  vec3 v = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+  float t = max(-v.z, 0.0);
+  v.x += v.x >= 0.0 ? -t : t;
+  v.y += v.y >= 0.0 ? -t : t;
+  return normalize(v);
+}
+
 // This will be passed to the fragment shader
 out vec2 texCoord;
 
@@ -20,8 +36,8 @@ void main() {
   texCoord = TexCoord;
 
   // Normal in world coordinates
-  normal = normalize(ModelMatrix * vec4(Normal, 0.0f));
+  normal = normalize(ModelMatrix * vec4(decodeNormal(Normal), 0.0f));
 
   // Calculate the final position on screen
-  gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(Position, 1.0);
+  gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(Position * PositionScale + PositionOffset, 1.0);
 }
@@ -1,38 +1,28 @@
 #version 330 core
 
+// Variants are specialized by ppgso::ShaderLibrary defines:
+//   NUM_LIGHTS - number of point lights, gives the light loop a constant trip count
+//   SPECULAR_MAP - material has a specular texture, otherwise highlights use the diffuse color
+//   TEXTURE_ARRAY - diffuse texture is a layer of a texture array selected by Layer (see ppgso::TextureArray)
+#include "lights.glsl"
+
 struct Material {
+#ifdef TEXTURE_ARRAY
+	sampler2DArray diffuse;
+#else
 	sampler2D diffuse;
+#endif
+#ifdef SPECULAR_MAP
 	sampler2D specular;
+#endif
 	float shininess;
 };
 
-struct DirLight {
-	vec3 direction;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-uniform DirLight dirLight;
-
-struct PointLight {
-	vec3 position;
-	vec3 color;
-
-	float constant;
-	float linear;
-	float quadratic;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-#define MAX_LIGHTS 30
-uniform PointLight pointLights[MAX_LIGHTS];
-uniform float numLights;
-
 uniform Material material;
 uniform vec3 viewPos;
+#ifdef TEXTURE_ARRAY
+uniform int Layer;
+#endif
 
 out vec4 FragmentColor;
 
@@ -40,25 +30,41 @@ in vec3 normal;
 in vec3 FragPos;
 in vec2 texCoord;
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor);
 
 void main() {
 	//properties
 	vec3 norm = normalize(normal);
 	vec3 viewDir = normalize(viewPos - FragPos);
 
+	//material is sampled once for all lights
+#ifdef TEXTURE_ARRAY
+	vec3 diffuseColor = vec3(texture(material.diffuse, vec3(texCoord, Layer)));
+#else
+	vec3 diffuseColor = vec3(texture(material.diffuse, texCoord));
+#endif
+#ifdef SPECULAR_MAP
+	vec3 specularColor = vec3(texture(material.specular, texCoord));
+#else
+	vec3 specularColor = diffuseColor;
+#endif
+
 	//phase 1: Directional lighting
-	vec3 result = CalcDirLight(dirLight, norm, viewDir);
+	vec3 result = CalcDirLight(dirLight, norm, viewDir, diffuseColor, specularColor);
 
 	//phase 2: Point lights
+#ifdef NUM_LIGHTS
+	for(int i = 0; i < NUM_LIGHTS; i++)
+#else
 	for(int i = 0; i < numLights; i++)
-	result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+#endif
+	result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, diffuseColor, specularColor);
 
 	FragmentColor = vec4(result, 1.0);
 }
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor) {
 	vec3 lightDir = normalize(-light.direction);
 
 	//diffuse shading
@@ -69,14 +75,14 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
 	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
 
 	//combine results
-	vec3 ambient = light.ambient  * vec3(texture(material.diffuse, texCoord));
-	vec3 diffuse = light.diffuse  * diff * vec3(texture(material.diffuse, texCoord));
-	vec3 specular = light.specular * spec * vec3(texture(material.specular, texCoord));
+	vec3 ambient = light.ambient  * diffuseColor;
+	vec3 diffuse = light.diffuse  * diff * diffuseColor;
+	vec3 specular = light.specular * spec * specularColor;
 
 	return (ambient + diffuse + specular);
 }
 
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor) {
 	vec3 lightDir = normalize(light.position - fragPos);
 
 	//diffuse shading
@@ -92,9 +98,9 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
 	light.quadratic * (distance * distance));
 
 	//combine results
-	vec3 ambient = light.ambient * light.color * vec3(texture(material.diffuse, texCoord));
-	vec3 diffuse = light.diffuse * light.color * diff * vec3(texture(material.diffuse, texCoord));
-	vec3 specular = light.specular * light.color * spec * vec3(texture(material.specular, texCoord));
+	vec3 ambient = light.ambient * light.color * diffuseColor;
+	vec3 diffuse = light.diffuse * light.color * diff * diffuseColor;
+	vec3 specular = light.specular * light.color * spec * specularColor;
 
 	ambient *= attenuation;
 	diffuse *= attenuation;
@@ -7,17 +7,35 @@ uniform mat4 ModelMatrix;
 uniform mat4 ViewMatrix;
 uniform mat4 ProjectionMatrix;
 
+// Dequantization of compressed meshes, identity for float meshes (see ppgso::Mesh)
+uniform vec3 PositionScale = vec3(1.0);
+uniform vec3 PositionOffset = vec3(0.0);
+uniform bool OctahedralNormals = false;
+
+// Decode octahedral normal stored as integers in <-127, 127>
+vec3 decodeNormal(vec3 n) {
+	if (!OctahedralNormals) return n;
+	vec2 f = n.xy / 127.0;
+	vec3 v = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = max(-v.z, 0.0);
+	v.x += v.x >= 0.0 ? -t : t;
+	v.y += v.y >= 0.0 ? -t : t;
+	return normalize(v);
+}
+
 out vec3 normal;
 out vec3 FragPos;
 out vec2 texCoord;
 
 void main()
 {
-	gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(Position, 1.0);
+	vec3 position = Position * PositionScale + PositionOffset;
+
+	gl_Position = ProjectionMatrix * ViewMatrix * ModelMatrix * vec4(position, 1.0);
 
-	FragPos = (ModelMatrix * vec4(Position, 1)).xyz;
+	FragPos = (ModelMatrix * vec4(position, 1)).xyz;
 
-	normal = Normal * mat3(transpose(inverse(ModelMatrix)));
+	normal = decodeNormal(Normal) * mat3(transpose(inverse(ModelMatrix)));
 
 	texCoord = TexCoord;
 }
@@ -0,0 +1,29 @@
+// Light sources of the scene, shared by lit shaders through #include "lights.glsl"
+
+struct DirLight {
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+// Scalars fill the padding after each vec3 so the std140 layout matches Scene::LightBlock
+struct PointLight {
+	vec3 position;
+	float constant;
+	vec3 color;
+	float linear;
+	vec3 ambient;
+	float quadratic;
+	vec3 diffuse;
+	vec3 specular;
+};
+#define MAX_LIGHTS 30
+
+// Lights of the scene, uploaded once per frame by Scene::render
+layout (std140) uniform Lights {
+	DirLight dirLight;
+	int numLights;
+	PointLight pointLights[MAX_LIGHTS];
+};
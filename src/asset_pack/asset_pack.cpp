@@ -0,0 +1,116 @@
+// Tool asset_pack
+// - Packs files of the data directory into a single indexed file that ppgso maps at runtime (see ppgso/asset_pack.h)
+// - Mesh caches are generated for every .obj file and stored next to it, so meshes upload straight from the pack
+// - Block compressed textures (.ctex) are generated for every .bmp and .png file the same way, the image itself
+//   is only stored when listed with -k because the loaders use the texture when its source is missing
+// - With -z entries are zlib compressed unless they are already compressed (.png) or mapped directly (.mesh, .ctex)
+// - Usage: asset_pack [-z] [-k image ...] output.pack data_dir file [file ...], files are relative to data_dir
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <ppgso/asset_pack.h>
+#include <ppgso/mesh_cache.h>
+#include <ppgso/image_bmp.h>
+#include <ppgso/image_png.h>
+#include <ppgso/image_compressed.h>
+
+static bool endsWith(const std::string &text, const std::string &suffix) {
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Generated files are written next to the pack first, then added to it
+static size_t addGenerated(ppgso::pack::Writer &writer, const std::string &asset, const std::string &temporary) {
+  size_t size;
+  {
+    ppgso::MappedFile generated{temporary};
+    writer.add(asset, generated.data(), generated.size(), false);
+    size = generated.size();
+  }
+  std::remove(temporary.c_str());
+  return size;
+}
+
+int main(int argc, char **argv) {
+  int first = 1;
+  bool compress = false;
+  // Images also loaded uncompressed, for example by loadBMP
+  std::vector<std::string> keep;
+  for (; first < argc; first++) {
+    std::string option = argv[first];
+    if (option == "-z") {
+      compress = true;
+    } else if (option == "-k" && first + 1 < argc) {
+      keep.emplace_back(argv[++first]);
+    } else {
+      break;
+    }
+  }
+
+  if (argc - first < 3) {
+    std::cerr << "Usage: " << argv[0] << " [-z] [-k image ...] output.pack data_dir file [file ...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string pack_file = argv[first];
+  std::string data_dir = argv[first + 1];
+  if (!data_dir.empty() && data_dir.back() != '/') data_dir += '/';
+
+  try {
+    ppgso::pack::Writer writer{pack_file};
+    size_t count = 0, size = 0;
+
+    for (int i = first + 2; i < argc; i++) {
+      std::string asset = argv[i];
+      // Caches and temporaries left in the data directory are regenerated
+      if (endsWith(asset, ".mesh") || endsWith(asset, ".ctex") || endsWith(asset, ".tmp")) continue;
+
+      // Sources are mapped directly, an existing pack in the working directory must not shadow them
+      ppgso::MappedFile source{data_dir + asset};
+      auto isImage = endsWith(asset, ".bmp") || endsWith(asset, ".png");
+      if (!isImage || std::find(keep.begin(), keep.end(), asset) != keep.end()) {
+        writer.add(asset, source.data(), source.size(), compress && !endsWith(asset, ".png"));
+        count++;
+        size += source.size();
+      }
+
+      // Caches are trusted next to their source in the pack, the stamp only matters once they are apart
+      ppgso::pack::Stamp stamp = {source.size(), 0, 0};
+      ppgso::MappedFile::stat(data_dir + asset, stamp.size, stamp.modified);
+
+      if (endsWith(asset, ".obj")) {
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        auto err = tinyobj::LoadObjParallel(shapes, materials, (data_dir + asset).c_str());
+        if (!err.empty()) throw std::runtime_error(err);
+
+        auto data = ppgso::mesh::build(shapes);
+        auto temporary = pack_file + ".mesh";
+        ppgso::mesh::saveCache(data.view(), stamp, temporary);
+        size += addGenerated(writer, ppgso::mesh::cachePath(asset), temporary);
+        count++;
+      }
+
+      if (isImage) {
+        auto image = endsWith(asset, ".bmp") ? ppgso::image::compressBC1(ppgso::image::loadBMP(data_dir + asset))
+                                             : ppgso::image::compressBC3(ppgso::image::loadPNG(data_dir + asset));
+        auto temporary = pack_file + ".ctex";
+        ppgso::image::saveCompressed(image, stamp, temporary);
+        size += addGenerated(writer, ppgso::image::compressedPath(asset), temporary);
+        count++;
+      }
+    }
+
+    auto packed = writer.finish();
+    std::cout << "Packed " << count << " assets (" << size / 1024 << " kB) into " << pack_file << " ("
+              << packed / 1024 << " kB)" << std::endl;
+  } catch (std::exception &e) {
+    std::cerr << "Failed to create " << pack_file << ": " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -50,11 +50,11 @@ public:
     // Generate a vertex array object
     // This keeps track of our data buffers
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    ppgso::gl::bindVertexArray(vao);
 
     // Generate a vertex buffer object, this will feed data to the vertex shader
     glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, vertex_buffer.size() * sizeof(glm::vec3), vertex_buffer.data(), GL_STATIC_DRAW);
 
     // Setup vertex array lookup, this tells the shader how to pick data for the "Position" input
@@ -64,7 +64,7 @@ public:
 
     // Same thing for colors
     glGenBuffers(1, &cbo);
-    glBindBuffer(GL_ARRAY_BUFFER, cbo);
+    ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, cbo);
     glBufferData(GL_ARRAY_BUFFER, color_buffer.size() * sizeof(glm::vec3), color_buffer.data(), GL_STATIC_DRAW);
 
     auto color_attrib = program.getAttribLocation("Color");
@@ -82,9 +82,9 @@ public:
    */
   ~GradientWindow() override {
     // Clean up all OpenGL objects
-    glDeleteBuffers(1, &cbo);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    ppgso::gl::deleteBuffer(cbo);
+    ppgso::gl::deleteBuffer(vbo);
+    ppgso::gl::deleteVertexArray(vao);
   }
 
   /*!
@@ -34,7 +34,7 @@ private:
   void loadImage(const std::string &image_file, int width, int height) {
     // Create new OpenGL texture object identifier
     glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    ppgso::gl::bindTexture(GL_TEXTURE_2D, 0, texture_id);
 
     // Set mipmapping
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -67,10 +67,9 @@ public:
     auto texture_attrib = program.getUniformLocation("Texture");
 
     glUniform1i(texture_attrib, 0);
-    glActiveTexture(GL_TEXTURE0 + 0);
 
-    // Bind the texture for use
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    // Bind the texture for use in texture unit 0
+    ppgso::gl::bindTexture(GL_TEXTURE_2D, 0, texture_id);
 
     // Set Matrices to identity so there are no projections/transformations applied in the vertex shader
     program.setUniform("ModelMatrix", glm::mat4{1.0f});
@@ -82,7 +81,7 @@ public:
    * Free OpenGL resources
    */
   ~TextureWindow() override {
-    glDeleteTextures(1, &texture_id);
+    ppgso::gl::deleteTexture(texture_id);
   }
 
   /*!
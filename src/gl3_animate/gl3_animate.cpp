@@ -38,12 +38,15 @@ private:
     double cx = sin(time);
     double cy = cos(time * 0.9);
 
+    // CPU access to the texture image, read back from the GPU if it was released
+    auto& image = texture.fetchImage();
+
     #pragma omp parallel for
-    for (int y = 0; y < texture.image.height; y++) {
-      for (int x = 0; x < texture.image.width; x++) {
-        auto& pixel = texture.image.getPixel(x, y);
-        double fx = (float) x / (float) (texture.image.width) - .5;
-        double fy = (float) y / (float) (texture.image.height) - .5;
+    for (int y = 0; y < image.height; y++) {
+      for (int x = 0; x < image.width; x++) {
+        auto& pixel = image.getPixel(x, y);
+        double fx = (float) x / (float) (image.width) - .5;
+        double fy = (float) y / (float) (image.height) - .5;
         double dist = sqrt(pow(fx - cx, 2.0) + pow(fy - cy, 2.0));
 
         pixel.r = (uint8_t) (sin(dist * 45.0) * 127 + 128);
@@ -51,7 +54,8 @@ private:
         pixel.b = (uint8_t) (sin(dist * 46.0) * 127 + 128);
       }
     }
-    // Update the OpenGL texture content
+    // Update the OpenGL texture content, the whole image changed so the driver regenerates the mipmaps
+    // The upload goes through the streaming buffers so the frame does not wait for the transfer
     texture.update();
   }
 
@@ -60,6 +64,9 @@ public:
    * Construct a new Window and initialize shader uniform variables
    */
   AnimateWindow() : ppgso::Window{"gl3_animate", SIZE, SIZE} {
+    // The texture changes every frame, stream it through a ring of pixel buffers
+    texture.setStreaming();
+
     // Pass the texture to the program as uniform input called "Texture"
     program.setUniform("Texture", texture);
 
@@ -74,7 +81,7 @@ public:
    */
   void onIdle() override {
     // Generate texture content
-    auto time = glfwGetTime();
+    auto time = getTime();
     updateTexture(texture, time);
 
     // Set gray background
@@ -150,7 +150,7 @@ public:
     // Clear depth and color buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    auto time = glfwGetTime();
+    auto time = getTime();
 
     // Generate and set the transformation matrix
     program.setUniform("ModelMatrix", getModelTransformationMatrix((float)time));
@@ -70,13 +70,13 @@ public:
   ProjectionWindow() : Window{"gl5_projection", SIZE, SIZE} {
     // Set up OpenGL options
     // Enable Z-buffer
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+    ppgso::gl::depthFunc(GL_LEQUAL);
 
     // Enable polygon culling
-    //glEnable(GL_CULL_FACE);
+    //ppgso::gl::setEnabled(GL_CULL_FACE, true);
     //glFrontFace(GL_CW);
-    //glCullFace(GL_BACK);
+    //ppgso::gl::cullFace(GL_BACK);
 
     // Set texture as program uniform input
     program.setUniform("Texture", texture);
@@ -107,7 +107,7 @@ public:
    */
   void onIdle() override {
     // Update time and create a rotation matrix
-    auto time = glfwGetTime();
+    auto time = getTime();
     auto rotateMat = rotate(glm::mat4{1.0f}, (float)time, {0, 1, 0});
 
     // Set up projection and view matrix
@@ -40,13 +40,13 @@ public:
     hideCursor();
 
     // Enable Z-buffer
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+    ppgso::gl::depthFunc(GL_LEQUAL);
 
     // Enable polygon culling
-    glEnable(GL_CULL_FACE);
+    ppgso::gl::setEnabled(GL_CULL_FACE, true);
     glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
+    ppgso::gl::cullFace(GL_BACK);
   }
 
   /*!
@@ -78,7 +78,7 @@ public:
    */
   void onIdle() override {
     // Animate using time when activated
-    if (animationEnabled) time = (float) glfwGetTime();
+    if (animationEnabled) time = (float) getTime();
 
     // Set gray background
     glClearColor(.5f, .5f, .5f, 0);
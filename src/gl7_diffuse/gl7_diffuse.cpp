@@ -39,13 +39,13 @@ public:
     program.setUniform("Texture", texture);
 
     // Enable Z-buffer
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+    ppgso::gl::depthFunc(GL_LEQUAL);
 
     // Enable polygon culling
-    glEnable(GL_CULL_FACE);
+    ppgso::gl::setEnabled(GL_CULL_FACE, true);
     glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
+    ppgso::gl::cullFace(GL_BACK);
   }
 
   /*!
@@ -74,7 +74,7 @@ public:
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Get time
-    auto time = glfwGetTime();
+    auto time = getTime();
 
     // Create object matrix that rotates in time
     auto sphereMat = rotate(glm::mat4{1.0f}, (float)time, {0.5f, 1.0f, 0.0f});
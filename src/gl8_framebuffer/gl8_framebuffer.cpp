@@ -41,8 +41,8 @@ public:
   FramebufferWindow() : Window{"gl8_framebuffer", SIZE, SIZE} {
     // Set up OpenGL options
     // Enable Z-buffer
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+    ppgso::gl::depthFunc(GL_LEQUAL);
 
     // Disable mipmapping on the quadTexture
     quadTexture.bind();
@@ -59,7 +59,7 @@ public:
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 
     // Associate the quadTexture with it
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, quadTexture.image.width, quadTexture.image.height);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, quadTexture.getWidth(), quadTexture.getHeight());
     glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, quadTexture.getTexture(), 0);
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
@@ -79,7 +79,7 @@ public:
    * Window update implementation that will be called automatically from pollEvents
    */
   void onIdle() override {
-    auto time = (float) glfwGetTime();
+    auto time = (float) getTime();
 
     // --------
     // Pass 1 - Render a scene with sphere to a texture in graphics memory
@@ -37,19 +37,19 @@ void Explosion::render(Scene &scene) {
   shader->setUniform("Texture", *texture);
 
   // Disable depth testing
-  glDisable(GL_DEPTH_TEST);
+  ppgso::gl::setEnabled(GL_DEPTH_TEST, false);
 
   // Enable blending
-  glEnable(GL_BLEND);
+  ppgso::gl::setEnabled(GL_BLEND, true);
   // Additive blending
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+  ppgso::gl::blendFunc(GL_SRC_ALPHA, GL_ONE);
 
   mesh->render();
 
   // Disable blending
-  glDisable(GL_BLEND);
+  ppgso::gl::setEnabled(GL_BLEND, false);
   // Enable depth test
-  glEnable(GL_DEPTH_TEST);
+  ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
 }
 
 bool Explosion::update(Scene &scene, float dt) {
@@ -60,17 +60,17 @@ public:
    */
   SceneWindow() : Window{"gl9_scene", SIZE, SIZE} {
     //hideCursor();
-    glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
+    if (window) glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
 
     // Initialize OpenGL state
     // Enable Z-buffer
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+    ppgso::gl::depthFunc(GL_LEQUAL);
 
     // Enable polygon culling
-    glEnable(GL_CULL_FACE);
+    ppgso::gl::setEnabled(GL_CULL_FACE, true);
     glFrontFace(GL_CCW);
-    glCullFace(GL_BACK);
+    ppgso::gl::cullFace(GL_BACK);
 
     initScene();
   }
@@ -145,12 +145,12 @@ public:
    */
   void onIdle() override {
     // Track time
-    static auto time = (float) glfwGetTime();
+    static auto time = (float) getTime();
 
     // Compute time delta
-    float dt = animate ? (float) glfwGetTime() - time : 0;
+    float dt = animate ? (float) getTime() - time : 0;
 
-    time = (float) glfwGetTime();
+    time = (float) getTime();
 
     // Set gray background
     glClearColor(.5f, .5f, .5f, 0);
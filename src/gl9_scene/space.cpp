@@ -21,7 +21,7 @@ bool Space::update(Scene &scene, float dt) {
 
 void Space::render(Scene &scene) {
   // Disable writing to the depth buffer so we render a "background"
-  glDepthMask(GL_FALSE);
+  ppgso::gl::depthMask(false);
 
   // NOTE: this object does not use camera, just renders the entire quad as is
   shader->use();
@@ -36,7 +36,7 @@ void Space::render(Scene &scene) {
   shader->setUniform("Texture", *texture);
   mesh->render();
 
-  glDepthMask(GL_TRUE);
+  ppgso::gl::depthMask(true);
 }
 
 // shared resources
@@ -0,0 +1,45 @@
+// Tool mesh_convert
+// - Converts Wavefront .obj files to binary mesh caches stored next to them
+// - Mesh loads the caches automatically, this tool just generates them ahead of time
+// - Usage: mesh_convert file.obj [file.obj ...]
+
+#include <iostream>
+#include <string>
+
+#include <ppgso/mesh_cache.h>
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " file.obj [file.obj ...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int result = EXIT_SUCCESS;
+  for (int i = 1; i < argc; i++) {
+    std::string obj_file = argv[i];
+    try {
+      ppgso::pack::Stamp source = {0, 0, 0};
+      if (!ppgso::MappedFile::stat(obj_file, source.size, source.modified))
+        throw std::runtime_error("Could not find " + obj_file);
+
+      std::vector<tinyobj::shape_t> shapes;
+      std::vector<tinyobj::material_t> materials;
+      auto err = tinyobj::LoadObjParallel(shapes, materials, obj_file.c_str());
+      if (!err.empty()) throw std::runtime_error(err);
+
+      auto data = ppgso::mesh::build(shapes);
+      auto geometry = data.view();
+      auto cache_file = ppgso::mesh::cachePath(obj_file);
+      ppgso::mesh::saveCache(geometry, source, cache_file);
+
+      std::cout << obj_file << " -> " << cache_file << " (" << geometry.vertexCount << " vertices, "
+                << geometry.indexCount / 3 << " triangles, " << geometry.partCount << " parts, "
+                << geometry.indexSize * 8 << "bit indices, " << geometry.lodCount << " levels of detail)" << std::endl;
+    } catch (std::exception &e) {
+      std::cerr << "Failed to convert " << obj_file << ": " << e.what() << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
+  return result;
+}
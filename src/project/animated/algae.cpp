@@ -6,20 +6,20 @@
 #include <shaders/texture_frag_glsl.h>
 
 Algae::Algae(const std::string &tex_file) {
-    // Initialize static resources if needed
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG(tex_file));
+    // Shared resources, the asset registry loads every file once
+    shader = ppgso::assets::loadShader(texture_vert_glsl, texture_frag_glsl);
+    texture = ppgso::assets::loadTextureAlpha(tex_file);
 
     // Generate Bezier suface
     bezierPatch();
+    createBuffers();
 }
 
 Algae::~Algae() {
     // Delete data from OpenGL
-    glDeleteBuffers(1, &ibo);
-    glDeleteBuffers(1, &tbo);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    ppgso::gl::deleteBuffer(ibo);
+    ppgso::gl::deleteBuffer(tbo);
+    ppgso::gl::deleteVertexArray(vao);
 }
 
 glm::vec3 interpolate(const glm::vec3 &p0, const glm::vec3 &p1, const float t){
@@ -48,15 +48,9 @@ glm::vec3 bezierPoint(const glm::vec3 controlCurvePoints[4], float t) {
 }
 
 void Algae::bezierPatch() {
-    // Generate Bezier patch points and incidences
-    glDeleteBuffers(1, &ibo);
-    glDeleteBuffers(1, &tbo);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
-
+    // Generate Bezier patch points and incidences, only the points move
+    bool generateFaces = mesh.empty();
     vertices.clear();
-    texCoords.clear();
-    mesh.clear();
     
     unsigned int PATCH_SIZE = 10;
     for(unsigned int i = 0; i < PATCH_SIZE ; i++) {
@@ -72,9 +66,10 @@ void Algae::bezierPatch() {
             glm::vec3 point_v = bezierPoint(points_u, v);
 
             vertices.push_back(point_v);
-            texCoords.emplace_back(u, 1-v);
+            if (generateFaces) texCoords.emplace_back(u, 1-v);
         }
     }
+    if (!generateFaces) return;
     
     // Generate indices
     for(unsigned int i = 1; i < PATCH_SIZE; i++) {
@@ -100,24 +95,20 @@ void Algae::bezierPatch() {
             mesh.push_back(triangle4);
         }
     }
+}
 
+void Algae::createBuffers() {
     // Copy data to OpenGL
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    // Copy positions to gpu
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    ppgso::gl::bindVertexArray(vao);
 
-    // Set vertex program inputs
-    auto position_attrib = shader->getAttribLocation("Position");
+    // Positions are read from the dynamic buffer of the scene, the pointer is set in render
+    position_attrib = shader->getAttribLocation("Position");
     glEnableVertexAttribArray(position_attrib);
-    glVertexAttribPointer(position_attrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     // Copy texture positions to gpu
     glGenBuffers(1, &tbo);
-    glBindBuffer(GL_ARRAY_BUFFER, tbo);
+    ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, tbo);
     glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
 
     // Set vertex program inputs
@@ -127,12 +118,12 @@ void Algae::bezierPatch() {
 
     // Copy indices to gpu
     glGenBuffers(1, &ibo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.size() * sizeof(face), mesh.data(), GL_STATIC_DRAW);
 }
 
 bool Algae::update(Scene &scene, float dt) {
-    auto time = (float) glfwGetTime();
+    auto time = (float) ppgso::Window::getTime();
 
     float multi = 1;
     for (int i = 0; i < 3; i++){
@@ -149,6 +140,9 @@ bool Algae::update(Scene &scene, float dt) {
 }
 
 void Algae::render(Scene &scene) {
+    // Assets load in the background, the object appears once they are uploaded
+    if (!texture.ready()) return;
+
     shader->use();
 
     shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
@@ -157,10 +151,13 @@ void Algae::render(Scene &scene) {
     shader->setUniform("ModelMatrix", modelMatrix);
     shader->setUniform("Texture", *texture);
 
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-    glDrawElements(GL_TRIANGLES, mesh.size() * sizeof(face), GL_UNSIGNED_INT, nullptr);
+    // Positions change every frame, stream them through the ring buffer instead of recreating buffers
+    auto &buffer = scene.getDynamicBuffer();
+    auto offset = buffer.upload(vertices.data(), vertices.size() * sizeof(glm::vec3));
+    ppgso::gl::bindVertexArray(vao);
+    ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, buffer.getBuffer());
+    glVertexAttribPointer(position_attrib, 3, GL_FLOAT, GL_FALSE, 0, (const void *) offset);
+    glDrawElements(GL_TRIANGLES, mesh.size() * 3, GL_UNSIGNED_INT, nullptr);
 
     for(auto & i : children) {
         i->render(scene);
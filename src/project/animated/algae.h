@@ -5,8 +5,8 @@
 
 class Algae final : public Object{
 private:
-    std::unique_ptr<ppgso::Shader> shader;
-    std::unique_ptr<ppgso::TextureAlpha> texture;
+    ppgso::Asset<ppgso::Shader> shader;
+    ppgso::Asset<ppgso::TextureAlpha> texture;
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec2> texCoords;
 
@@ -22,13 +22,19 @@ private:
     };
 
     std::vector<face> mesh;
-    GLuint vao, vbo, tbo, ibo;
+    GLuint vao, tbo, ibo;
+    GLuint position_attrib;
 
     /*!
-     * Generate Bezier surface from control points along with uv coordinates and faces and pass the data to GPU
+     * Generate Bezier surface from control points, uv coordinates and faces are generated only once
      */
     void bezierPatch();
 
+    /*!
+     * Pass uv coordinates and faces to GPU, positions are streamed every frame in render
+     */
+    void createBuffers();
+
 public:
     /*!
      * Create a new Bezier object
@@ -5,13 +5,6 @@
 #include "boids_fish.h"
 
 class Boids final : public Object{
-private:
-    // Static resources (Shared between instances)
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::TextureAlpha> texture;
-
-
 public:
     /*!
      * Create a new Boid
@@ -2,18 +2,11 @@
 #include "src/project/scene.h"
 
 #include <ppgso/image_png.h>
-#include <shaders/light_vert_glsl.h>
-#include <shaders/light_frag_glsl.h>
-
-std::unique_ptr<ppgso::Mesh> BoidsFish::mesh;
-std::unique_ptr<ppgso::TextureAlpha> BoidsFish::texture;
-std::unique_ptr<ppgso::Shader> BoidsFish::shader;
 
 BoidsFish::BoidsFish() {
-    // Initialize static resources if needed
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG("animals/red_fish.png"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("animals/red_fish.obj");
-    if (!shader) shader = std::make_unique<ppgso::Shader>(light_vert_glsl, light_frag_glsl);
+    // Shared resources, the asset registry loads every file once
+    texture = ppgso::assets::loadTextureAlpha("animals/red_fish.png");
+    mesh = ppgso::assets::loadMesh("animals/red_fish.obj");
 
     scale = {0.3f, 0.3f, 0.3f};
 }
@@ -26,35 +19,24 @@ bool BoidsFish::update(Scene &scene, float dt) {
 }
 
 void BoidsFish::render(Scene &scene) {
-    shader->use();
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || !texture.ready()) return;
+
+    // Variant of the lighting shader matching the scene lights
+    auto &shader = scene.getLightShader();
+    shader.use();
 
     // Set up light
-    shader->setUniform("viewPos", scene.camera->cameraPosition);
-    shader->setUniform("numLights", scene.lights.size());
-
-    shader->setUniform("dirLight.direction", scene.lightDirection);
-    shader->setUniform("dirLight.ambient", scene.lightAmbient);
-    shader->setUniform("dirLight.diffuse", scene.lightDiffuse);
-    shader->setUniform("dirLight.specular", scene.lightSpecular);
-
-    for (unsigned long i = 0; i < scene.lights.size(); i++) {
-        shader->setUniform(setLightProperty("position", i), scene.lights[i].position);
-        shader->setUniform(setLightProperty("color", i), scene.lights[i].color);
-        shader->setUniform(setLightProperty("constant", i), scene.lights[i].constant);
-        shader->setUniform(setLightProperty("linear", i), scene.lights[i].linear);
-        shader->setUniform(setLightProperty("quadratic", i), scene.lights[i].quadratic);
-        shader->setUniform(setLightProperty("ambient", i), scene.lights[i].ambient);
-        shader->setUniform(setLightProperty("diffuse", i), scene.lights[i].diffuse);
-        shader->setUniform(setLightProperty("specular", i), scene.lights[i].specular);
-    }
+    shader.setUniform("viewPos", scene.camera->cameraPosition);
 
     // use camera
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
+    shader.setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
+    shader.setUniform("ViewMatrix", scene.camera->viewMatrix);
 
     // render mesh
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("material.diffuse", *texture);
-    shader->setUniform("material.shininess", shininess);
-    mesh->render();
+    shader.setUniform("ModelMatrix", modelMatrix);
+    shader.setUniform("material.diffuse", *texture);
+    shader.setUniform("material.shininess", shininess);
+    // Distant objects use a coarser level of detail, close ones skip clusters that can not be seen
+    mesh->render(shader, scene.camera->viewMatrix * modelMatrix, scene.camera->projectionMatrix);
 }
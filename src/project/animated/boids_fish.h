@@ -5,10 +5,9 @@
 
 class BoidsFish final : public Object{
 private:
-    // Static resources (Shared between instances)
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::TextureAlpha> texture;
+    // Shared resources (see ppgso::assets)
+    ppgso::Asset<ppgso::Mesh> mesh;
+    ppgso::Asset<ppgso::TextureAlpha> texture;
 
 
 public:
@@ -5,10 +5,9 @@
 
 class ChasedFish final : public Object{
 private:
-    // Static resources (Shared between instances)
-    std::unique_ptr<ppgso::Mesh> mesh;
-    std::unique_ptr<ppgso::Shader> shader;
-    std::unique_ptr<ppgso::TextureAlpha> texture;
+    // Shared resources (see ppgso::assets)
+    ppgso::Asset<ppgso::Mesh> mesh;
+    ppgso::Asset<ppgso::TextureAlpha> texture;
 
 
 public:
@@ -5,12 +5,6 @@
 #include "algae.h"
 
 class Foliage final : public Object{
-private:
-    // Static resources (Shared between instances)
-    static std::unique_ptr<ppgso::Mesh> mesh;
-    static std::unique_ptr<ppgso::Shader> shader;
-    static std::unique_ptr<ppgso::TextureAlpha> texture;
-
 public:
     /*!
      * Generate algae in passed boundaries
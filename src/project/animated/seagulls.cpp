@@ -6,10 +6,10 @@
 #include "src/project/scene.h"
 
 Seagulls::Seagulls() {
-    // Initialize static resources if needed
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG("animals/seagulls.png"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("animals/seagulls.obj");
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
+    // Shared resources, the asset registry loads every file once
+    texture = ppgso::assets::loadTextureAlpha("animals/seagulls.png");
+    mesh = ppgso::assets::loadMesh("animals/seagulls.obj");
+    shader = ppgso::assets::loadShader(texture_vert_glsl, texture_frag_glsl);
 }
 
 bool Seagulls::update(Scene &scene, float dt) {
@@ -23,6 +23,9 @@ bool Seagulls::update(Scene &scene, float dt) {
 }
 
 void Seagulls::render(Scene &scene) {
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || !texture.ready()) return;
+
     shader->use();
 
     // use camera
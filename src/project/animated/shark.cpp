@@ -1,15 +1,12 @@
  #include <ppgso/image_png.h>
-#include <shaders/light_vert_glsl.h>
-#include <shaders/light_frag_glsl.h>
 
 #include "shark.h"
 #include "src/project/scene.h"
 
 Shark::Shark() {
-    // Initialize static resources if needed
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG("animals/shark.png"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("animals/shark.obj");
-    if (!shader) shader = std::make_unique<ppgso::Shader>(light_vert_glsl, light_frag_glsl);
+    // Shared resources, the asset registry loads every file once
+    texture = ppgso::assets::loadTextureAlpha("animals/shark.png");
+    mesh = ppgso::assets::loadMesh("animals/shark.obj");
 
     // Animation keyframes
     // Wait
@@ -51,37 +48,26 @@ bool Shark::update(Scene &scene, float dt) {
 }
 
 void Shark::render(Scene &scene) {
-    shader->use();
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || !texture.ready()) return;
 
-    // Set up light
-    shader->setUniform("viewPos", scene.camera->cameraPosition);
-    shader->setUniform("numLights", scene.lights.size());
-
-    shader->setUniform("dirLight.direction", scene.lightDirection);
-    shader->setUniform("dirLight.ambient", scene.lightAmbient);
-    shader->setUniform("dirLight.diffuse", scene.lightDiffuse);
-    shader->setUniform("dirLight.specular", scene.lightSpecular);
+    // Variant of the lighting shader matching the scene lights
+    auto &shader = scene.getLightShader();
+    shader.use();
 
-    for (unsigned long i = 0; i < scene.lights.size(); i++) {
-        shader->setUniform(setLightProperty("position", i), scene.lights[i].position);
-        shader->setUniform(setLightProperty("color", i), scene.lights[i].color);
-        shader->setUniform(setLightProperty("constant", i), scene.lights[i].constant);
-        shader->setUniform(setLightProperty("linear", i), scene.lights[i].linear);
-        shader->setUniform(setLightProperty("quadratic", i), scene.lights[i].quadratic);
-        shader->setUniform(setLightProperty("ambient", i), scene.lights[i].ambient);
-        shader->setUniform(setLightProperty("diffuse", i), scene.lights[i].diffuse);
-        shader->setUniform(setLightProperty("specular", i), scene.lights[i].specular);
-    }
+    // Set up light
+    shader.setUniform("viewPos", scene.camera->cameraPosition);
 
     // use camera
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
+    shader.setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
+    shader.setUniform("ViewMatrix", scene.camera->viewMatrix);
 
     // render mesh
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("material.diffuse", *texture);
-    shader->setUniform("material.shininess", shininess);
-    mesh->render();
+    shader.setUniform("ModelMatrix", modelMatrix);
+    shader.setUniform("material.diffuse", *texture);
+    shader.setUniform("material.shininess", shininess);
+    // Distant objects use a coarser level of detail, close ones skip clusters that can not be seen
+    mesh->render(shader, scene.camera->viewMatrix * modelMatrix, scene.camera->projectionMatrix);
 
     for(auto & i : children) {
         i->render(scene);
@@ -1,6 +1,4 @@
 #include <ppgso/image_png.h>
-#include <shaders/light_vert_glsl.h>
-#include <shaders/light_frag_glsl.h>
 
 #include "whale.h"
 #include "whale_back.h"
@@ -8,10 +6,9 @@
 #include "src/project/scene.h"
 
 Whale::Whale() {
-    // Initialize static resources if needed
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG("animals/whale/whale.png"));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>("animals/whale/head.obj");
-    if (!shader) shader = std::make_unique<ppgso::Shader>(light_vert_glsl, light_frag_glsl);
+    // Shared resources, the asset registry loads every file once
+    texture = ppgso::assets::loadTextureAlpha("animals/whale/whale.png");
+    mesh = ppgso::assets::loadMesh("animals/whale/head.obj");
 
     auto back = new WhaleBack();
     back->position = {0.1f, -0.2f, -4.6f};
@@ -28,14 +25,13 @@ Whale::Whale() {
 }
 
 Whale::Whale(const std::string &mesh_file, const std::string &tex_file) {
-    // Initialize static resources if needed
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG(tex_file));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>(mesh_file);
-    if (!shader) shader = std::make_unique<ppgso::Shader>(light_vert_glsl, light_frag_glsl);
+    // Shared resources, the asset registry loads every file once
+    texture = ppgso::assets::loadTextureAlpha(tex_file);
+    mesh = ppgso::assets::loadMesh(mesh_file);
 }
 
 bool Whale::update(Scene &scene, float dt) {
-    auto time = (float) glfwGetTime();
+    auto time = (float) ppgso::Window::getTime();
 
     position.z += 0.01f;
     rotation.x = 0.1 * sin(time);
@@ -49,37 +45,25 @@ bool Whale::update(Scene &scene, float dt) {
 }
 
 void Whale::render(Scene &scene) {
-    shader->use();
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || !texture.ready()) return;
+
+    // Variant of the lighting shader matching the scene lights
+    auto &shader = scene.getLightShader();
+    shader.use();
 
     // Set up light
-    shader->setUniform("viewPos", scene.camera->cameraPosition);
-    shader->setUniform("numLights", scene.lights.size());
-
-    shader->setUniform("dirLight.direction", scene.lightDirection);
-    shader->setUniform("dirLight.ambient", scene.lightAmbient);
-    shader->setUniform("dirLight.diffuse", scene.lightDiffuse);
-    shader->setUniform("dirLight.specular", scene.lightSpecular);
-
-    for (unsigned long i = 0; i < scene.lights.size(); i++) {
-        shader->setUniform(setLightProperty("position", i), scene.lights[i].position);
-        shader->setUniform(setLightProperty("color", i), scene.lights[i].color);
-        shader->setUniform(setLightProperty("constant", i), scene.lights[i].constant);
-        shader->setUniform(setLightProperty("linear", i), scene.lights[i].linear);
-        shader->setUniform(setLightProperty("quadratic", i), scene.lights[i].quadratic);
-        shader->setUniform(setLightProperty("ambient", i), scene.lights[i].ambient);
-        shader->setUniform(setLightProperty("diffuse", i), scene.lights[i].diffuse);
-        shader->setUniform(setLightProperty("specular", i), scene.lights[i].specular);
-    }
+    shader.setUniform("viewPos", scene.camera->cameraPosition);
 
     // use camera
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
+    shader.setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
+    shader.setUniform("ViewMatrix", scene.camera->viewMatrix);
 
     // render mesh
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("material.diffuse", *texture);
-    shader->setUniform("material.shininess", shininess);
-    mesh->render();
+    shader.setUniform("ModelMatrix", modelMatrix);
+    shader.setUniform("material.diffuse", *texture);
+    shader.setUniform("material.shininess", shininess);
+    mesh->render(shader);
 
     for(auto & i : children) {
         i->render(scene);
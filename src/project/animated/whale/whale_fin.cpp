@@ -1,27 +1,22 @@
 #include <ppgso/image_png.h>
-#include <shaders/light_vert_glsl.h>
-#include <shaders/light_frag_glsl.h>
 
 #include "whale_fin.h"
 #include "src/project/scene.h"
 
 WhaleFin::WhaleFin(bool right) {
-    // Initialize static resources if needed
-    if (!mesh) {
-        if (right)
-            mesh = std::make_unique<ppgso::Mesh>("animals/whale/right_fin.obj");
-        else
-            mesh = std::make_unique<ppgso::Mesh>("animals/whale/left_fin.obj");
-    }
+    // Shared resources, the asset registry loads every file once
+    if (right)
+        mesh = ppgso::assets::loadMesh("animals/whale/right_fin.obj");
+    else
+        mesh = ppgso::assets::loadMesh("animals/whale/left_fin.obj");
 
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG("animals/whale/whale.png"));
-    if (!shader) shader = std::make_unique<ppgso::Shader>(light_vert_glsl, light_frag_glsl);
+    texture = ppgso::assets::loadTextureAlpha("animals/whale/whale.png");
 
     this->right = right;
 }
 
 bool WhaleFin::update(Scene &scene, float dt) {
-    auto time = (float) glfwGetTime();
+    auto time = (float) ppgso::Window::getTime();
 
     if(right)
         rotation.y = 0.1f * sin(time);
@@ -36,37 +31,25 @@ bool WhaleFin::update(Scene &scene, float dt) {
 }
 
 void WhaleFin::render(Scene &scene) {
-    shader->use();
-
-    // Set up light
-    shader->setUniform("viewPos", scene.camera->cameraPosition);
-    shader->setUniform("numLights", scene.lights.size());
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || !texture.ready()) return;
 
-    shader->setUniform("dirLight.direction", scene.lightDirection);
-    shader->setUniform("dirLight.ambient", scene.lightAmbient);
-    shader->setUniform("dirLight.diffuse", scene.lightDiffuse);
-    shader->setUniform("dirLight.specular", scene.lightSpecular);
+    // Variant of the lighting shader matching the scene lights
+    auto &shader = scene.getLightShader();
+    shader.use();
 
-    for (unsigned long i = 0; i < scene.lights.size(); i++) {
-        shader->setUniform(setLightProperty("position", i), scene.lights[i].position);
-        shader->setUniform(setLightProperty("color", i), scene.lights[i].color);
-        shader->setUniform(setLightProperty("constant", i), scene.lights[i].constant);
-        shader->setUniform(setLightProperty("linear", i), scene.lights[i].linear);
-        shader->setUniform(setLightProperty("quadratic", i), scene.lights[i].quadratic);
-        shader->setUniform(setLightProperty("ambient", i), scene.lights[i].ambient);
-        shader->setUniform(setLightProperty("diffuse", i), scene.lights[i].diffuse);
-        shader->setUniform(setLightProperty("specular", i), scene.lights[i].specular);
-    }
+    // Set up light
+    shader.setUniform("viewPos", scene.camera->cameraPosition);
 
     // use camera
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
+    shader.setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
+    shader.setUniform("ViewMatrix", scene.camera->viewMatrix);
 
     // render mesh
-    shader->setUniform("ModelMatrix", modelMatrix);
-    shader->setUniform("material.diffuse", *texture);
-    shader->setUniform("material.shininess", shininess);
-    mesh->render();
+    shader.setUniform("ModelMatrix", modelMatrix);
+    shader.setUniform("material.diffuse", *texture);
+    shader.setUniform("material.shininess", shininess);
+    mesh->render(shader);
 
     for(auto & i : children) {
         i->render(scene);
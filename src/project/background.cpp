@@ -6,10 +6,10 @@
 #include <shaders/texture_frag_glsl.h>
 
 Background::Background(const std::string &mesh_file, const std::string &tex_file) {
-    // Initialize static resources if needed
-    if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG(tex_file));
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>(mesh_file);
-    if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
+    // Shared resources, the asset registry loads every file once
+    texture = ppgso::assets::loadTextureAlpha(tex_file);
+    mesh = ppgso::assets::loadMesh(mesh_file);
+    shader = ppgso::assets::loadShader(texture_vert_glsl, texture_frag_glsl);
 }
 
 bool Background::update(Scene &scene, float dt) {
@@ -18,6 +18,9 @@ bool Background::update(Scene &scene, float dt) {
 }
 
 void Background::render(Scene &scene) {
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || !texture.ready()) return;
+
     shader->use();
 
     // use camera
@@ -8,10 +8,10 @@
 #include <shaders/texture_frag_glsl.h>
 
 Kelp::Kelp(const std::string &tex_file, int child_num, float child_offset) {
-	// Initialize static resources if needed
-	if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-	if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG(tex_file));
-	//if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(tex_file));
+	// Shared resources, the asset registry loads every file once
+	shader = ppgso::assets::loadShader(texture_vert_glsl, texture_frag_glsl);
+	texture = ppgso::assets::loadTextureAlpha(tex_file);
+	//texture = ppgso::assets::loadTexture(tex_file);
 	
 	vertices = {
 			{-1.0f, -2.0f, 0.0f}, // x_plane bottom left
@@ -59,10 +59,10 @@ void Kelp::create_children() {
 
 Kelp::~Kelp() {
 	// Delete data from OpenGL
-	glDeleteBuffers(1, &ibo);
-	glDeleteBuffers(1, &tbo);
-	glDeleteBuffers(1, &vbo);
-	glDeleteVertexArrays(1, &vao);
+	ppgso::gl::deleteBuffer(ibo);
+	ppgso::gl::deleteBuffer(tbo);
+	ppgso::gl::deleteBuffer(vbo);
+	ppgso::gl::deleteVertexArray(vao);
 }
 
 void Kelp::generateIndices() {
@@ -86,11 +86,11 @@ void Kelp::generateIndices() {
 void Kelp::updateBuffers() {
 	// Copy data to OpenGL
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	ppgso::gl::bindVertexArray(vao);
 	
 	// Copy positions to gpu
 	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
 	
 	// Set vertex program inputs
@@ -100,7 +100,7 @@ void Kelp::updateBuffers() {
 	
 	// Copy texture positions to gpu
 	glGenBuffers(1, &tbo);
-	glBindBuffer(GL_ARRAY_BUFFER, tbo);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, tbo);
 	glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
 	
 	// Set vertex program inputs
@@ -110,13 +110,13 @@ void Kelp::updateBuffers() {
 	
 	// Copy indices to gpu
 	glGenBuffers(1, &ibo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.size() * sizeof(face), mesh.data(), GL_STATIC_DRAW);
 }
 
 
 bool Kelp::update(Scene &scene, float dt) {
-	auto time = (float) glfwGetTime();
+	auto time = (float) ppgso::Window::getTime();
 	auto root_parent = getRootParent();
 	
 	if (this->parent != NULL){
@@ -156,6 +156,9 @@ bool Kelp::update(Scene &scene, float dt) {
 }
 
 void Kelp::render(Scene &scene) {
+	// Assets load in the background, the object appears once they are uploaded
+	if (!texture.ready()) return;
+
 	shader->use();
 	
 	shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
@@ -164,10 +167,9 @@ void Kelp::render(Scene &scene) {
 	shader->setUniform("ModelMatrix", modelMatrix);
 	shader->setUniform("Texture", *texture);
 	
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-	glDrawElements(GL_TRIANGLES, mesh.size() * sizeof(face), GL_UNSIGNED_INT, nullptr);
+	// The quads never change, their buffers were filled once by updateBuffers
+	ppgso::gl::bindVertexArray(vao);
+	glDrawElements(GL_TRIANGLES, mesh.size() * 3, GL_UNSIGNED_INT, nullptr);
 	
 	for(auto & i : children) {
 		i->render(scene);
@@ -5,9 +5,9 @@
 
 class Kelp final : public Object{
 private:
-	std::unique_ptr<ppgso::Shader> shader;
-	std::unique_ptr<ppgso::TextureAlpha> texture;
-	//std::unique_ptr<ppgso::Texture> texture;
+	ppgso::Asset<ppgso::Shader> shader;
+	ppgso::Asset<ppgso::TextureAlpha> texture;
+	//ppgso::Asset<ppgso::Texture> texture;
 	std::vector<glm::vec3> vertices;
 	std::vector<glm::vec2> texCoords;
 	
@@ -4,7 +4,6 @@
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/transform.hpp>
 #include <iostream>
-#include <sstream>
 
 #include "object.h"
 
@@ -23,12 +22,6 @@ void Object::generateModelMatrix() {
     }
 }
 
-std::string Object::setLightProperty(const char* propertyName, size_t lightIndex) {
-    std::ostringstream ss;
-    ss << "pointLights[" << lightIndex << "]." << propertyName;
-    return ss.str();
-}
-
 glm::vec3 Object::getRealPosition() {
 	if (this->parent != NULL){
 		return (this->parent->getRealPosition() + this->position);
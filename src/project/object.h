@@ -55,14 +55,6 @@ public:
      */
     virtual void addChild(Object *s) {};
 
-    /*!
-     * Create string to pass attributes of one point light to shader
-     * @param propertyName  name of the attribute in shader
-     * @param lightIndex    index of point light
-     * @return              string passing attribute to shader
-     */
-    std::string setLightProperty(const char* propertyName, size_t lightIndex);
-
     // Object properties
     glm::vec3 position{0,0,0};
     glm::vec3 rotation{0,0,0};
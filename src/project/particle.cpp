@@ -15,82 +15,76 @@
 //#include <shaders/diffuse_frag_glsl.h>
 
 Particle::Particle(const std::string &tex_file, float time_to_live, float gravity_effectiveness, glm::vec3 velocity, float wce) {
-	// Initialize static resources if needed
-	if (!shader) shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-	//if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(tex_file));
-	if (!texture) texture = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG(tex_file));
+	// Shared resources, the asset registry loads every file once
+	shader = ppgso::assets::loadShader(texture_vert_glsl, texture_frag_glsl);
+	//texture = ppgso::assets::loadTexture(tex_file);
+	texture = ppgso::assets::loadTextureAlpha(tex_file);
 	
 	this->time_to_live = time_to_live;
 	this->velocity = velocity;
 	this->gravity_effectiveness = gravity_effectiveness;
 	this->water_current_effectiveness = wce;
 	
-	
-	vertices = {
+	quad = ppgso::assets::share<Quad>("particle_quad", [this] { return std::make_unique<Quad>(*shader); });
+}
+
+Particle::Quad::Quad(const ppgso::Shader &shader) {
+	std::vector<glm::vec3> vertices = {
 			{-0.5f, -0.5f, 0.0f},
 			{-0.5f, 0.5f, 0.0f},
 			{0.5f, 0.5f, 0.0f},
 			{0.5f, -0.5f, 0.0f},
 	};
-	
-	face triangle1 = {0,1,2};
-	face triangle2 = {0,2,3};
-	face triangle1_inv = {2,1,0};
-	face triangle2_inv = {3,2,0};
-	mesh = {
-		triangle1_inv,
-		triangle2_inv,
-	};
-	texCoords = {
+	std::vector<glm::vec2> texCoords = {
 			{1, 0},
 			{1, 1},
 			{0, 1},
 			{0, 0},
 	};
-	updateBuffers();
+	std::vector<face> mesh = {
+			{2, 1, 0},
+			{3, 2, 0},
+	};
+	count = (GLsizei) mesh.size() * 3;
 	
-}
-
-Particle::~Particle() {
-	// Delete data from OpenGL
-	glDeleteBuffers(1, &ibo);
-	glDeleteBuffers(1, &tbo);
-	glDeleteBuffers(1, &vbo);
-	glDeleteVertexArrays(1, &vao);
-}
-
-
-void Particle::updateBuffers() {
 	// Copy data to OpenGL
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	ppgso::gl::bindVertexArray(vao);
 	
 	// Copy positions to gpu
 	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
 	
 	// Set vertex program inputs
-	auto position_attrib = shader->getAttribLocation("Position");
+	auto position_attrib = shader.getAttribLocation("Position");
 	glEnableVertexAttribArray(position_attrib);
 	glVertexAttribPointer(position_attrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
 	
 	// Copy texture positions to gpu
 	glGenBuffers(1, &tbo);
-	glBindBuffer(GL_ARRAY_BUFFER, tbo);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, tbo);
 	glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
 	
 	// Set vertex program inputs
-	auto texCoord_attrib = shader->getAttribLocation("TexCoord");
+	auto texCoord_attrib = shader.getAttribLocation("TexCoord");
 	glEnableVertexAttribArray(texCoord_attrib);
 	glVertexAttribPointer(texCoord_attrib, 2, GL_FLOAT, GL_FALSE, 0, 0);
 	
 	// Copy indices to gpu
 	glGenBuffers(1, &ibo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.size() * sizeof(face), mesh.data(), GL_STATIC_DRAW);
 }
 
+Particle::Quad::~Quad() {
+	// Delete data from OpenGL
+	ppgso::gl::deleteBuffer(ibo);
+	ppgso::gl::deleteBuffer(tbo);
+	ppgso::gl::deleteBuffer(vbo);
+	ppgso::gl::deleteVertexArray(vao);
+}
+
 
 bool Particle::update(Scene &scene, float dt) {
 	
@@ -114,6 +108,9 @@ bool Particle::update(Scene &scene, float dt) {
 }
 
 void Particle::render(Scene &scene) {
+	// Assets load in the background, the object appears once they are uploaded
+	if (!texture.ready()) return;
+
 	shader->use();
 	
 	shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
@@ -123,10 +120,8 @@ void Particle::render(Scene &scene) {
 	shader->setUniform("Texture", *texture);
 	
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-	glDrawElements(GL_TRIANGLES, mesh.size() * sizeof(face), GL_UNSIGNED_INT, nullptr);
+	ppgso::gl::bindVertexArray(quad->vao);
+	glDrawElements(GL_TRIANGLES, quad->count, GL_UNSIGNED_INT, nullptr);
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	for(auto & i : children) {
 		i->render(scene);
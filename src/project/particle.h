@@ -6,18 +6,25 @@
 
 class Particle final : public Object{
 private:
-	std::unique_ptr<ppgso::Shader> shader;
-	//std::unique_ptr<ppgso::Texture> texture;
-	std::unique_ptr<ppgso::TextureAlpha> texture;
-	std::vector<glm::vec3> vertices;
-	std::vector<glm::vec2> texCoords;
+	ppgso::Asset<ppgso::Shader> shader;
+	//ppgso::Asset<ppgso::Texture> texture;
+	ppgso::Asset<ppgso::TextureAlpha> texture;
 	
 	struct face {
 		GLuint v0, v1, v2;
 	};
 
-	std::vector<face> mesh;
-	GLuint vao, vbo, tbo, ibo;
+	/*!
+	 * Quad geometry shared by all particles, so spawning a particle creates no OpenGL objects
+	 */
+	struct Quad {
+		GLuint vao, vbo, tbo, ibo;
+		GLsizei count;
+		
+		Quad(const ppgso::Shader &shader);
+		~Quad();
+	};
+	ppgso::Asset<Quad> quad;
 	
 	float gravity_effectiveness;
 	float time_to_live;
@@ -25,16 +32,12 @@ private:
 	
 	glm::vec3 velocity;
 	
-	void updateBuffers();
-	
 	float water_current_effectiveness;
 	
 public:
 
 	Particle(const std::string &tex_file, float time_to_live, float gravity_effectiveness, glm::vec3 velocity, float wce);
 	
-	~Particle();
-	
 	bool update(Scene &scene, float dt) override;
 	
 	void render(Scene &scene) override;
@@ -9,6 +9,7 @@ ParticleEmitter::ParticleEmitter(glm::vec3 pos, const std::string &tex_file, flo
 	
 	this->position = pos;
 	this->tex_file = tex_file;
+	this->texture = ppgso::assets::loadTextureAlpha(tex_file);
 	this->prod_time_delay = time_delay;
 	this->particles_to_produce = particle_num;
 	this->gravity_effectiveness = grav;
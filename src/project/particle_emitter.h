@@ -10,6 +10,8 @@ class ParticleEmitter final : public Object{
 private:
 	
 	std::string tex_file;
+	// Keeps the particle texture registered between particle generations
+	ppgso::Asset<ppgso::TextureAlpha> texture;
 	float prod_time_delay;
 	int particles_to_produce;
 	float time_elapsed = 0.0f;
@@ -38,6 +38,22 @@
 const unsigned int SIZEW = 1280;
 const unsigned int SIZEH = 720;
 
+// Milliseconds per frame spent creating OpenGL objects of assets loaded in the background
+const double ASSET_UPLOAD_BUDGET = 4.0;
+
+// GPU memory for textures, ones that were not drawn recently drop to a small mip tail beyond it
+const size_t TEXTURE_BUDGET = 48 << 20;
+
+// Frames captured into a timeline trace when L is pressed
+const unsigned TRACE_FRAMES = 120;
+
+// Coral textures share one texture array, corals select their layer
+const std::vector<std::string> CORAL_TEXTURES = {
+        "corals/coral_blue.bmp", "corals/coral_gray.bmp", "corals/coral_green.bmp",
+        "corals/coral_green2.bmp", "corals/coral_orange.bmp", "corals/coral_pink.bmp",
+        "corals/coral_purple.bmp", "corals/coral_red.bmp", "corals/coral_yellow.bmp"
+};
+
 float randfloat(float min, float max)
 {
 	float range = (max - min);
@@ -52,13 +68,20 @@ class SceneWindow : public ppgso::Window {
 private:
     Scene scene;
     bool animate = true;
+    bool shaderSetupReported = false;
+
+    // OpenGL state changes of the previous frame
+    ppgso::gl::Counters frameCalls;
 
     /*!
      * Reset and initialize the game scene
      * Creating unique smart pointers to objects that are stored in the scene object list
      */
     void initScene() {
+        // Old objects hold their assets until the new ones requested them, so a reset loads nothing again
+        auto previous = std::move(scene.objects);
         scene.objects.clear();
+        scene.lights.clear();
 
         // Create a camera
         auto camera = std::make_unique<Camera>(60.0f, 1.0f, 0.1f, 400.0f);
@@ -175,94 +198,94 @@ private:
         cave->position = {-7.0f, 7.7f, 0.0f};
         cave->scale = {2.0f, 3.0f, 2.0f};
 
-        auto coral = new StaticObject("corals/coral.obj", "corals/coral_green2.bmp", LIGHT_SHADER);
+        auto coral = new StaticObject("corals/coral.obj", CORAL_TEXTURES, "corals/coral_green2.bmp");
         coral->scale = {1.0f, 2.0f, 1.0f};
         coral->position = {0.0f, -3.2f, -7.8f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral.obj", "corals/coral_green2.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral.obj", CORAL_TEXTURES, "corals/coral_green2.bmp");
         coral->scale = {2.0f, 2.0f, 2.0f};
         coral->position = {5.0f, -3.3f, -3.6f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral.obj", "corals/coral_green.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral.obj", CORAL_TEXTURES, "corals/coral_green.bmp");
         coral->position = {-4.0f, -3.3f, -3.8f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral1.obj", "corals/coral_red.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral1.obj", CORAL_TEXTURES, "corals/coral_red.bmp");
         coral->rotation = {ppgso::PI, 0.0f, 0.0f};
         coral->position = {0.57f, 2.2f, -7.0f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral1.obj", "corals/coral_yellow.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral1.obj", CORAL_TEXTURES, "corals/coral_yellow.bmp");
         coral->scale = {1.5f, 1.5f, 1.5f};
         coral->rotation = {0.0f, 0.0f, ppgso::PI/2};
         coral->position = {2.0f, -3.5f, -4.5f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral1.obj", "corals/coral_pink.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral1.obj", CORAL_TEXTURES, "corals/coral_pink.bmp");
         coral->position = {-1.0f, -3.4f, -7.0f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral2.obj", "corals/coral_blue.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral2.obj", CORAL_TEXTURES, "corals/coral_blue.bmp");
         coral->scale = {2.5f, 2.5f, 2.5f};
         coral->position = {2.0f, -3.3f, -7.5f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral2.obj", "corals/coral_pink.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral2.obj", CORAL_TEXTURES, "corals/coral_pink.bmp");
         coral->rotation = {-ppgso::PI/2 + 0.4f, 0.0f, 0.0f};
         coral->position = {0.0f, -0.5f, -3.8f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral2.obj", "corals/coral_blue.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral2.obj", CORAL_TEXTURES, "corals/coral_blue.bmp");
         coral->scale = {1.2f, 1.2f, 1.2f};
         coral->rotation = {ppgso::PI + 0.2f, 0.0f, 0.0f};
         coral->position = {0.0f, 2.5f, -5.5f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral3.obj", "corals/coral_purple.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral3.obj", CORAL_TEXTURES, "corals/coral_purple.bmp");
         coral->scale = {1.2f, 1.2f, 1.2f};
         coral->position = {3.5f, -3.2f, -7.2f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral4.obj", "corals/coral_orange.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral4.obj", CORAL_TEXTURES, "corals/coral_orange.bmp");
         coral->scale = {1.2f, 1.2f, 1.2f};
         coral->rotation = {ppgso::PI + 0.1f, 0.0f, 0.0f};
         coral->position = {1.0f, 2.5f, -4.6f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral4.obj", "corals/coral_red.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral4.obj", CORAL_TEXTURES, "corals/coral_red.bmp");
         coral->scale = {1.5f, 1.5f, 1.5f};
         coral->rotation = {0.0f, 0.0f, 3.0f};
         coral->position = {0.7f, -3.3f, -6.5f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral5.obj", "corals/coral_green2.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral5.obj", CORAL_TEXTURES, "corals/coral_green2.bmp");
         coral->position = {0.0f, -3.3f, -4.2f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral5.obj", "corals/coral_green.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral5.obj", CORAL_TEXTURES, "corals/coral_green.bmp");
         coral->scale = {2.0f, 2.0f, 2.0f};
         coral->position = {-4.0f, -3.3f, -7.2f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral5.obj", "corals/coral_green.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral5.obj", CORAL_TEXTURES, "corals/coral_green.bmp");
         coral->scale = {0.7f, 0.7f, 0.7f};
         coral->position = {2.5f, -3.2f, -6.7f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral6.obj", "corals/coral_blue.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral6.obj", CORAL_TEXTURES, "corals/coral_blue.bmp");
         coral->scale = {1.5f, 1.5f, 1.5f};
         coral->position = {-2.0f, -3.3f, -4.5f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral6.obj", "corals/coral_red.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral6.obj", CORAL_TEXTURES, "corals/coral_red.bmp");
         coral->scale = {1.5f, 1.5f, 1.5f};
         coral->rotation = {0.0f, 0.0f, 1.0f};
         coral->position = {3.5f, -3.3f, -4.0f};
         cave->addChild(coral);
 
-        coral = new StaticObject("corals/coral6.obj", "corals/coral_pink.bmp", LIGHT_SHADER);
+        coral = new StaticObject("corals/coral6.obj", CORAL_TEXTURES, "corals/coral_pink.bmp");
         coral->rotation = {ppgso::PI, 0.4f, 0.0f};
         coral->position = {-2.0f, 2.4f, -5.6f};
         cave->addChild(coral);
@@ -316,24 +339,28 @@ public:
      * Construct custom game window
      */
     SceneWindow() : Window{"project", SIZEW, SIZEH} {
+        // Nothing reads textures on the CPU once they are uploaded
+        ppgso::Texture::setKeepImages(false);
+        ppgso::residency::setBudget(TEXTURE_BUDGET);
+
         //hideCursor();
-        glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
+        if (window) glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
 
         // Initialize OpenGL state
         // Enable Z-buffer
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+        ppgso::gl::depthFunc(GL_LEQUAL);
 
         // Enable polygon culling
-        glEnable(GL_CULL_FACE);
+        ppgso::gl::setEnabled(GL_CULL_FACE, true);
         glFrontFace(GL_CCW);
-        glCullFace(GL_BACK);
+        ppgso::gl::cullFace(GL_BACK);
 
         //glEnable(GL_BLEND);
         //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		
         //disables cursor and binds mouse to window
-	    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	    disableCursor();
 
 	    if (FILTER) {
             // Disable mipmapping on the quadTexture
@@ -341,6 +368,9 @@ public:
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
+            // The texture is only rendered to, its image is not needed
+            quadTexture.releaseImage();
+
             // Initialize framebuffer, its color texture (the sphere will be rendered to it) and its render buffer for depth info storage
             glGenFramebuffers(1, &fbo);
             glBindFramebuffer(GL_FRAMEBUFFER, fbo);
@@ -351,7 +381,7 @@ public:
             glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
 
             // Associate the quadTexture with it
-            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, quadTexture.image.width, quadTexture.image.height);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, quadTexture.getWidth(), quadTexture.getHeight());
             glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, quadTexture.getTexture(), 0);
 
             if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
@@ -393,6 +423,30 @@ public:
             animate = !animate;
         }
 
+        // Print how many state changes reached OpenGL in the last frame
+        if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+            printf("OpenGL state calls in last frame: %lu issued, %lu skipped\n", frameCalls.issued, frameCalls.skipped);
+        }
+
+        // Print where the recent frames spent their time
+        if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+            ppgso::profiler::report(std::cout);
+        }
+
+        // Capture a timeline of the next frames for Perfetto
+        if (key == GLFW_KEY_L && action == GLFW_PRESS) {
+            ppgso::trace::capture(TRACE_FRAMES, "trace.json");
+        }
+
+        // Print CPU and GPU memory held by the loaded assets
+        if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+            ppgso::assets::reportMemory(std::cout);
+            auto residency = ppgso::residency::getStatistics();
+            printf("Textures: %zu tracked, %zu evicted, %zu restoring, %.1f of %.1f MiB resident (%lu evictions, %lu restores)\n",
+                   residency.tracked, residency.evicted, residency.restoring, residency.resident / 1048576.0,
+                   residency.budget / 1048576.0, residency.evictions, residency.restores);
+        }
+
         if (key == GLFW_KEY_C && action == GLFW_PRESS) {
             if (scene.camera->keyframes.empty()) {
                 printf("Starting animation...\n");
@@ -458,27 +512,60 @@ public:
      */
     void onIdle() override {
         // Track time
-        static auto time = (float) glfwGetTime();
+        static auto time = (float) getTime();
 
         // Compute time delta
-        float dt = animate ? (float) glfwGetTime() - time : 0;
+        float dt = animate ? (float) getTime() - time : 0;
 
-        time = (float) glfwGetTime();
+        time = (float) getTime();
 
-        if (FILTER) {
-            glViewport(0, 0, SIZEW, SIZEH);
-            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-        }
+        frameCalls = ppgso::gl::getCounters();
+        ppgso::gl::resetCounters();
+
+        {
+            ppgso::profiler::Scope scope{"assets"};
+            PPGSO_TRACE_SCOPE("assets");
+
+            // Objects requested their meshes and textures when created, they appear as uploads finish
+            ppgso::assets::upload(ASSET_UPLOAD_BUDGET);
 
-        // Clear the framebuffer
-        glClearColor(.5f, .5f, .5f, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // Evict textures that were not drawn recently, bring back the ones that are needed again
+            ppgso::residency::update();
+        }
 
         // Update and render all objects
-        scene.update(dt);
-        scene.render();
+        {
+            ppgso::profiler::Scope scope{"update"};
+            PPGSO_TRACE_SCOPE("update");
+            scene.update(dt);
+        }
+
+        {
+            ppgso::profiler::Scope scope{"render", true};
+            PPGSO_TRACE_SCOPE("render");
+            if (FILTER) {
+                glViewport(0, 0, SIZEW, SIZEH);
+                glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            }
+
+            // Clear the framebuffer
+            glClearColor(.5f, .5f, .5f, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            scene.render();
+        }
+
+        // Shaders finish compiling when they are first used, so the setup cost is known after the first frame
+        if (!shaderSetupReported) {
+            auto &shaders = ppgso::Shader::getStatistics();
+            printf("Shader setup took %.1f ms (%d compiled, %d from cache, %d shared)\n",
+                   shaders.milliseconds, shaders.compiled, shaders.loaded, shaders.reused);
+            shaderSetupReported = true;
+        }
 
         if (FILTER) {
+            ppgso::profiler::Scope scope{"post-process", true};
+            PPGSO_TRACE_SCOPE("post-process");
             resetViewport();
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
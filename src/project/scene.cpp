@@ -1,6 +1,41 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <typeindex>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
 #include "scene.h"
 #include "static_object.h"
 
+#include <shaders/light_vert_glsl.h>
+#include <shaders/light_frag_glsl.h>
+#include <shaders/lights_glsl.h>
+
+constexpr size_t Scene::MAX_LIGHTS;
+constexpr GLuint Scene::LIGHTS_BINDING;
+constexpr size_t Scene::DYNAMIC_BUFFER_SIZE;
+
+
+// Class of the object shown in traces, nullptr outside of a capture
+static const char *traceName(const Object &object) {
+    if (!ppgso::trace::isCapturing()) return nullptr;
+
+    static std::map<std::type_index, std::string> names;
+    auto &name = names[typeid(object)];
+    if (name.empty()) {
+        name = typeid(object).name();
+#ifdef __GNUG__
+        int status;
+        if (auto demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status)) {
+            name = demangled;
+            std::free(demangled);
+        }
+#endif
+    }
+    return name.c_str();
+}
 
 float randfrom(float min, float max)
 {
@@ -34,6 +69,7 @@ void Scene::update(float dt) {
     while (i != std::end(objects)) {
         // Update and remove from list if needed
         auto obj = i->get();
+        PPGSO_TRACE_SCOPE("update", traceName(*obj));
         if (!obj->update(*this, dt))
             i = objects.erase(i); // NOTE: no need to call destructors as we store shared pointers in the scene
         else
@@ -42,9 +78,65 @@ void Scene::update(float dt) {
 }
 
 void Scene::render() {
-    // Simply render all objects
-    for ( auto& obj : objects )
+    // Upload lights once per frame, all lit programs read them from the same buffer
+    if (!lightBuffer) lightBuffer = std::make_unique<ppgso::UniformBuffer>(sizeof(LightBlock), LIGHTS_BINDING);
+
+    LightBlock block{};
+    block.direction = lightDirection;
+    block.ambient = lightAmbient;
+    block.diffuse = lightDiffuse;
+    block.specular = lightSpecular;
+    block.numLights = (int) std::min(lights.size(), MAX_LIGHTS);
+    for (int i = 0; i < block.numLights; i++) {
+        auto &light = lights[i];
+        auto &target = block.pointLights[i];
+        target.position = light.position;
+        target.color = light.color;
+        target.constant = light.constant;
+        target.linear = light.linear;
+        target.quadratic = light.quadratic;
+        target.ambient = light.ambient;
+        target.diffuse = light.diffuse;
+        target.specular = light.specular;
+    }
+    // Only the used part of the array is uploaded
+    lightBuffer->update(&block, offsetof(LightBlock, pointLights) + block.numLights * sizeof(PointLightBlock));
+
+    // Render all objects
+    for ( auto& obj : objects ) {
+        PPGSO_TRACE_SCOPE("render", traceName(*obj));
         obj->render(*this);
+    }
+
+    // Vertex data of this frame is reused once the GPU is done with it
+    if (dynamicBuffer) dynamicBuffer->endFrame();
+}
+
+ppgso::Shader &Scene::getLightShader(bool specularMap, bool textureArray) {
+    auto count = std::min<size_t>(lights.size(), MAX_LIGHTS);
+    if (count != lightShaderCount) {
+        for (auto &shader : lightShaders)
+            shader.reset();
+        lightShaderCount = count;
+    }
+
+    auto &variant = lightShaders[specularMap + 2 * textureArray];
+    if (!variant) {
+        // Fragment cost follows the scene: the light loop has a constant trip count
+        ppgso::ShaderLibrary::Defines defines{{"NUM_LIGHTS", std::to_string(count)}};
+        if (specularMap) defines["SPECULAR_MAP"] = "1";
+        if (textureArray) defines["TEXTURE_ARRAY"] = "1";
+
+        shaderLibrary.add("lights.glsl", lights_glsl);
+        variant = shaderLibrary.get(light_vert_glsl, light_frag_glsl, defines);
+        variant->setUniformBlock("Lights", LIGHTS_BINDING);
+    }
+    return *variant;
+}
+
+ppgso::DynamicBuffer &Scene::getDynamicBuffer() {
+    if (!dynamicBuffer) dynamicBuffer = std::make_unique<ppgso::DynamicBuffer>(DYNAMIC_BUFFER_SIZE);
+    return *dynamicBuffer;
 }
 
 std::vector<Object*> Scene::intersect(const glm::vec3 &position, const glm::vec3 &direction) {
@@ -22,10 +22,25 @@ class Scene {
     void update(float dt);
 
     /*!
-     * Render all objects in the scene
+     * Upload lights to the uniform buffer and render all objects in the scene
      */
     void render();
 
+    /*!
+     * Get lighting shader (light_vert.glsl, light_frag.glsl) specialized for the current number of lights,
+     * its light uniform block is connected to the buffer updated in render
+     * @param specularMap - Material binds a specular texture
+     * @param textureArray - Diffuse texture is a layer of a ppgso::TextureArray selected by the Layer uniform
+     * @return Shader variant
+     */
+    ppgso::Shader &getLightShader(bool specularMap = false, bool textureArray = false);
+
+    /*!
+     * Get ring buffer for vertex data that changes every frame, render marks the end of each frame
+     * @return Dynamic buffer shared by all objects
+     */
+    ppgso::DynamicBuffer &getDynamicBuffer();
+
     /*!
      * Pick objects using a ray
      * @param position - Position in the scene to pick object from
@@ -52,6 +67,12 @@ class Scene {
     glm::vec3 lightSpecular{0.2f, 0.2f, 0.2f};
 
     std::vector<Light> lights;
+
+    // Maximum number of point lights, MAX_LIGHTS in light_frag.glsl
+    static constexpr size_t MAX_LIGHTS = 30;
+
+    // Binding point of the "Lights" uniform block
+    static constexpr GLuint LIGHTS_BINDING = 0;
     
     
     glm::vec3 water_current = {0.0f, 0.0f, 0.0f};
@@ -65,6 +86,48 @@ class Scene {
       double last_x, last_y; //records positions of x and y from the last call
       bool left, right;
     } cursor;
+
+  private:
+    // std140 layout of the "Lights" uniform block, scalars fill the padding after vec3
+    struct PointLightBlock {
+      glm::vec3 position;
+      float constant;
+      glm::vec3 color;
+      float linear;
+      glm::vec3 ambient;
+      float quadratic;
+      glm::vec3 diffuse;
+      float padding0;
+      glm::vec3 specular;
+      float padding1;
+    };
+
+    struct LightBlock {
+      glm::vec3 direction;
+      float padding0;
+      glm::vec3 ambient;
+      float padding1;
+      glm::vec3 diffuse;
+      float padding2;
+      glm::vec3 specular;
+      float padding3;
+      int numLights;
+      int padding4[3];
+      PointLightBlock pointLights[MAX_LIGHTS];
+    };
+    static_assert(sizeof(PointLightBlock) == 80, "PointLightBlock does not match std140 layout");
+    static_assert(sizeof(LightBlock) == 80 + 80 * MAX_LIGHTS, "LightBlock does not match std140 layout");
+
+    std::unique_ptr<ppgso::UniformBuffer> lightBuffer;
+
+    // Size of the ring for per-frame vertex data, holds a few frames of the water surface
+    static constexpr size_t DYNAMIC_BUFFER_SIZE = 8 * 1024 * 1024;
+    std::unique_ptr<ppgso::DynamicBuffer> dynamicBuffer;
+
+    // Lighting shader variants, indexed by specular map presence + 2 * texture array use, valid for lightShaderCount lights
+    ppgso::ShaderLibrary shaderLibrary;
+    std::shared_ptr<ppgso::Shader> lightShaders[4];
+    size_t lightShaderCount = 0;
 };
 
 #endif // _PPGSO_SCENE_H
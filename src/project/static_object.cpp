@@ -2,6 +2,8 @@
 #include "scene.h"
 
 #include <string>
+#include <algorithm>
+#include <stdexcept>
 
 #include <shaders/color_vert_glsl.h>
 #include <shaders/color_frag_glsl.h>
@@ -9,39 +11,47 @@
 #include <shaders/texture_frag_glsl.h>
 #include <shaders/diffuse_vert_glsl.h>
 #include <shaders/diffuse_frag_glsl.h>
-#include <shaders/light_vert_glsl.h>
-#include <shaders/light_frag_glsl.h>
 
 #include <shaders/shadowmap_vert_glsl.h>
 #include <shaders/shadowmap_frag_glsl.h>
 
 StaticObject::StaticObject(const std::string &mesh_file, const std::string &tex_file, int shader_type) {
-    // Initialize static resources if needed
+    // Shared resources, the asset registry loads every file once
     if (tex_file[tex_file.size() - 1] == 'p'){
-	    if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(tex_file));
+	    texture = ppgso::assets::loadTexture(tex_file);
 	    tex_type = 0;
     }
     else {
-	    if (!texture_alpha) texture_alpha = std::make_unique<ppgso::TextureAlpha>(ppgso::image::loadPNG(tex_file));
+	    texture_alpha = ppgso::assets::loadTextureAlpha(tex_file);
 	    tex_type = 1;
     }
     
-    if (!mesh) mesh = std::make_unique<ppgso::Mesh>(mesh_file);
-
-    if (!shader) {
-        if (shader_type == COLOR_SHADER) {
-            shader = std::make_unique<ppgso::Shader>(color_vert_glsl, color_frag_glsl);
-        }
-        else if (shader_type == TEXTURE_SHADER) {
-            shader = std::make_unique<ppgso::Shader>(texture_vert_glsl, texture_frag_glsl);
-        }
-        else if (shader_type == DIFFUSE_SHADER) {
-            shader = std::make_unique<ppgso::Shader>(diffuse_vert_glsl, diffuse_frag_glsl);
-        }
-        else if (shader_type == LIGHT_SHADER) {
-            shader = std::make_unique<ppgso::Shader>(light_vert_glsl, light_frag_glsl);
-        }
+    // Large terrain and prop meshes use the compressed vertex format
+    mesh = ppgso::assets::loadMesh(mesh_file, ppgso::Mesh::Format::Quantized);
+
+    if (shader_type == COLOR_SHADER) {
+        shader = ppgso::assets::loadShader(color_vert_glsl, color_frag_glsl);
+    }
+    else if (shader_type == TEXTURE_SHADER) {
+        shader = ppgso::assets::loadShader(texture_vert_glsl, texture_frag_glsl);
+    }
+    else if (shader_type == DIFFUSE_SHADER) {
+        shader = ppgso::assets::loadShader(diffuse_vert_glsl, diffuse_frag_glsl);
     }
+    // LIGHT_SHADER uses the variant from the scene that matches its lights
+}
+
+StaticObject::StaticObject(const std::string &mesh_file, const std::vector<std::string> &tex_files, const std::string &tex_file) {
+    auto found = std::find(tex_files.begin(), tex_files.end(), tex_file);
+    if (found == tex_files.end())
+        throw std::runtime_error("Texture " + tex_file + " is not part of the texture set");
+
+    // Shared resources, the asset registry loads the texture set once
+    texture_array = ppgso::assets::loadTextureArray(tex_files);
+    tex_type = 2;
+    layer = (int) (found - tex_files.begin());
+
+    mesh = ppgso::assets::loadMesh(mesh_file, ppgso::Mesh::Format::Quantized);
 }
 
 bool StaticObject::update(Scene &scene, float dt) {
@@ -55,46 +65,44 @@ bool StaticObject::update(Scene &scene, float dt) {
 }
 
 void StaticObject::render(Scene &scene) {
-    shader->use();
+    // Assets load in the background, the object appears once they are uploaded
+    if (!mesh.ready() || (tex_type == 0 ? !texture.ready() : tex_type == 1 ? !texture_alpha.ready() : !texture_array.ready())) return;
 
-    // Set up light
-    shader->setUniform("viewPos", scene.camera->cameraPosition);
-    shader->setUniform("numLights", scene.lights.size());
-
-    // Directional light
-    shader->setUniform("dirLight.direction", scene.lightDirection);
-    shader->setUniform("dirLight.ambient", scene.lightAmbient);
-    shader->setUniform("dirLight.diffuse", scene.lightDiffuse);
-    shader->setUniform("dirLight.specular", scene.lightSpecular);
-
-    // Point lights
-    for (unsigned long i = 0; i < scene.lights.size(); i++) {
-        shader->setUniform(setLightProperty("position", i), scene.lights[i].position);
-        shader->setUniform(setLightProperty("color", i), scene.lights[i].color);
-        shader->setUniform(setLightProperty("constant", i), scene.lights[i].constant);
-        shader->setUniform(setLightProperty("linear", i), scene.lights[i].linear);
-        shader->setUniform(setLightProperty("quadratic", i), scene.lights[i].quadratic);
-        shader->setUniform(setLightProperty("ambient", i), scene.lights[i].ambient);
-        shader->setUniform(setLightProperty("diffuse", i), scene.lights[i].diffuse);
-        shader->setUniform(setLightProperty("specular", i), scene.lights[i].specular);
+    // Objects outside the view do not bind their textures, so the residency manager can evict them
+    // Children have their own bounds and are checked separately
+    auto modelViewMatrix = scene.camera->viewMatrix * modelMatrix;
+    if (!mesh->isVisible(modelViewMatrix, scene.camera->projectionMatrix)) {
+        for (auto &i : children) i->render(scene);
+        return;
     }
 
+    auto &program = shader ? *shader : scene.getLightShader(false, tex_type == 2);
+    program.use();
+
+    // Set up light
+    program.setUniform("viewPos", scene.camera->cameraPosition);
+
     // use camera
-    shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
-    shader->setUniform("ViewMatrix", scene.camera->viewMatrix);
+    program.setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
+    program.setUniform("ViewMatrix", scene.camera->viewMatrix);
 
     // render mesh
-    shader->setUniform("ModelMatrix", modelMatrix);
+    program.setUniform("ModelMatrix", modelMatrix);
     
     if (tex_type == 0){
-	    shader->setUniform("material.diffuse", *texture);
+	    program.setUniform("material.diffuse", *texture);
+    }
+    else if (tex_type == 1) {
+	    program.setUniform("material.diffuse", *texture_alpha);
     }
     else {
-	    shader->setUniform("material.diffuse", *texture_alpha);
+	    program.setUniform("material.diffuse", *texture_array);
+	    program.setUniform("Layer", layer);
     }
     
-    shader->setUniform("material.shininess", shininess);
-    mesh->render();
+    program.setUniform("material.shininess", shininess);
+    // Distant objects use a coarser level of detail, close ones skip clusters that can not be seen
+    mesh->render(program, modelViewMatrix, scene.camera->projectionMatrix);
 
     // Render children
     for(auto & i : children) {
@@ -6,13 +6,15 @@
 
 class StaticObject final : public Object{
 private:
-    // Static resources (Shared between instances)
-    std::unique_ptr<ppgso::Mesh> mesh;
-    std::unique_ptr<ppgso::Shader> shader;
-    std::unique_ptr<ppgso::Texture> texture;
-	std::unique_ptr<ppgso::TextureAlpha> texture_alpha;
+    // Shared resources (see ppgso::assets)
+    ppgso::Asset<ppgso::Mesh> mesh;
+    ppgso::Asset<ppgso::Shader> shader;
+    ppgso::Asset<ppgso::Texture> texture;
+	ppgso::Asset<ppgso::TextureAlpha> texture_alpha;
+	ppgso::Asset<ppgso::TextureArray> texture_array;
 	
 	int tex_type = 0;
+	int layer = 0;
 
 
 public:
@@ -28,6 +30,16 @@ public:
                  const std::string &tex_file,
                  int shader_type);
 
+    /*!
+     * Create a new lit static object textured by a layer of a texture array
+     * Objects created from the same texture set share the array, so they are drawn without texture switches
+     * @param tex_files - Same sized BMP textures packed into the array
+     * @param tex_file - Texture of this object, one of tex_files
+     */
+    StaticObject(const std::string &mesh_file,
+                 const std::vector<std::string> &tex_files,
+                 const std::string &tex_file);
+
     /*!
      * Update static object
      * @param scene Scene to update
@@ -14,9 +14,9 @@
 #include <shaders/water_surface_frag_glsl.h>
 
 WaterSurface::WaterSurface(const std::string &tex_file, int len_x_in, int len_z_in) {
-	// Initialize static resources if needed
-	if (!shader) shader = std::make_unique<ppgso::Shader>(water_surface_vert_glsl, water_surface_frag_glsl);
-	if (!texture) texture = std::make_unique<ppgso::Texture>(ppgso::image::loadBMP(tex_file));
+	// Shared resources, the asset registry loads every file once
+	shader = ppgso::assets::loadShader(water_surface_vert_glsl, water_surface_frag_glsl);
+	texture = ppgso::assets::loadTexture(tex_file);
 	
 	len_x = len_x_in;
 	len_z = len_z_in;
@@ -57,19 +57,18 @@ WaterSurface::WaterSurface(const std::string &tex_file, int len_x_in, int len_z_
 	
 	// Generate Bezier suface
 	for (int wp_idx = 0; wp_idx < water_planes.size(); wp_idx++){
-		bezierPatches(water_planes[wp_idx]);
+		bezierPatches(water_planes[wp_idx], true);
 	}
 
-	updateBuffers();
+	createBuffers();
 	
 }
 
 WaterSurface::~WaterSurface() {
 	// Delete data from OpenGL
-	glDeleteBuffers(1, &ibo);
-	glDeleteBuffers(1, &tbo);
-	glDeleteBuffers(1, &vbo);
-	glDeleteVertexArrays(1, &vao);
+	ppgso::gl::deleteBuffer(ibo);
+	ppgso::gl::deleteBuffer(tbo);
+	ppgso::gl::deleteVertexArray(vao);
 }
 
 glm::vec3 WaterSurface::interpolate(const glm::vec3 &p0, const glm::vec3 &p1, const float t){
@@ -97,7 +96,7 @@ glm::vec3 WaterSurface::bezierPoint(const glm::vec3 controlCurvePoints[4], float
 	return cubic_p1;
 }
 
-void WaterSurface::bezierPatches(waterPlane plane_in) {
+void WaterSurface::bezierPatches(waterPlane plane_in, bool faces) {
 	// Generate Bezier patch points and incidences
 	
 	unsigned int PATCH_SIZE = 10;
@@ -114,9 +113,10 @@ void WaterSurface::bezierPatches(waterPlane plane_in) {
 			glm::vec3 point_v = bezierPoint(points_u, v);
 			
 			vertices.push_back(point_v);
-			texCoords.emplace_back(u, 1-v);
+			if (faces) texCoords.emplace_back(u, 1-v);
 		}
 	}
+	if (!faces) return;
 	
 	
 	// Generate indices for upward facing triangles
@@ -153,24 +153,18 @@ void WaterSurface::bezierPatches(waterPlane plane_in) {
 	}
 }
 
-void WaterSurface::updateBuffers() {
+void WaterSurface::createBuffers() {
 	// Copy data to OpenGL
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	ppgso::gl::bindVertexArray(vao);
 	
-	// Copy positions to gpu
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-	
-	// Set vertex program inputs
-	auto position_attrib = shader->getAttribLocation("Position");
+	// Positions are read from the dynamic buffer of the scene, the pointer is set in render
+	position_attrib = shader->getAttribLocation("Position");
 	glEnableVertexAttribArray(position_attrib);
-	glVertexAttribPointer(position_attrib, 3, GL_FLOAT, GL_FALSE, 0, 0);
 	
 	// Copy texture positions to gpu
 	glGenBuffers(1, &tbo);
-	glBindBuffer(GL_ARRAY_BUFFER, tbo);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, tbo);
 	glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
 	
 	// Set vertex program inputs
@@ -180,7 +174,7 @@ void WaterSurface::updateBuffers() {
 	
 	/*
 	glGenBuffers(1, &nbo);
-	glBindBuffer(GL_ARRAY_BUFFER, nbo);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, nbo);
 	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(float), normals.data(),
 	             GL_STATIC_DRAW);
 	
@@ -191,13 +185,13 @@ void WaterSurface::updateBuffers() {
 	
 	// Copy indices to gpu
 	glGenBuffers(1, &ibo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.size() * sizeof(face), mesh.data(), GL_STATIC_DRAW);
 }
 
 
 bool WaterSurface::update(Scene &scene, float dt) {
-	auto time = (float) glfwGetTime();
+	auto time = (float) ppgso::Window::getTime();
 	
 	
 	for (int i = 0; i < len_x; i ++){
@@ -231,27 +225,22 @@ bool WaterSurface::update(Scene &scene, float dt) {
 		}
 	}
 
-    glDeleteBuffers(1, &ibo);
-    glDeleteBuffers(1, &tbo);
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
-	
+	// Only the points move, uv coordinates and faces stay on the GPU
 	vertices.clear();
-	texCoords.clear();
-	mesh.clear();
 	
 	// Generate Bezier suface
 	for (int wp_idx = 0; wp_idx < water_planes.size(); wp_idx++){
-		bezierPatches(water_planes[wp_idx]);
+		bezierPatches(water_planes[wp_idx], false);
 	}
 	
-	updateBuffers();
-	
 	generateModelMatrix();
 	return true;
 }
 
 void WaterSurface::render(Scene &scene) {
+	// Assets load in the background, the object appears once they are uploaded
+	if (!texture.ready()) return;
+
 	shader->use();
 	
 	shader->setUniform("ProjectionMatrix", scene.camera->projectionMatrix);
@@ -263,10 +252,13 @@ void WaterSurface::render(Scene &scene) {
 	shader->setUniform("cameraPosition", scene.camera->cameraPosition);
 	
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-	glDrawElements(GL_TRIANGLES, mesh.size() * sizeof(face), GL_UNSIGNED_INT, nullptr);
+	// Positions change every frame, stream them through the ring buffer instead of recreating buffers
+	auto &buffer = scene.getDynamicBuffer();
+	auto offset = buffer.upload(vertices.data(), vertices.size() * sizeof(glm::vec3));
+	ppgso::gl::bindVertexArray(vao);
+	ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, buffer.getBuffer());
+	glVertexAttribPointer(position_attrib, 3, GL_FLOAT, GL_FALSE, 0, (const void *) offset);
+	glDrawElements(GL_TRIANGLES, mesh.size() * 3, GL_UNSIGNED_INT, nullptr);
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	for(auto & i : children) {
 		i->render(scene);
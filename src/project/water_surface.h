@@ -6,9 +6,9 @@
 
 class WaterSurface final : public Object{
 private:
-	std::unique_ptr<ppgso::Shader> shader;
-	std::unique_ptr<ppgso::Texture> texture;
-	//std::unique_ptr<ppgso::TextureAlpha> texture;
+	ppgso::Asset<ppgso::Shader> shader;
+	ppgso::Asset<ppgso::Texture> texture;
+	//ppgso::Asset<ppgso::TextureAlpha> texture;
 	std::vector<glm::vec3> vertices;
 	std::vector<glm::vec3> normals;
 	std::vector<glm::vec2> texCoords;
@@ -33,7 +33,8 @@ private:
 	
 	std::vector<waterPlane> water_planes;
 	std::vector<face> mesh;
-	GLuint vao, vbo, tbo, ibo, nbo;
+	GLuint vao, tbo, ibo;
+	GLuint position_attrib;
 	
 	int len_x;
 	int len_z;
@@ -42,10 +43,15 @@ private:
 	std::normal_distribution<float> normal_dist;
 	
 	/*!
-	 * Generate Bezier surface from control points along with uv coordinates and faces and pass the data to GPU
+	 * Generate Bezier surface from control points along with uv coordinates and faces
+	 * @param faces - Generate uv coordinates and faces too, they do not change after the first call
 	 */
-	void bezierPatches(waterPlane plane_in);
-	void updateBuffers();
+	void bezierPatches(waterPlane plane_in, bool faces);
+
+	/*!
+	 * Pass uv coordinates and faces to GPU, positions are streamed every frame in render
+	 */
+	void createBuffers();
 	
 	glm::vec3 interpolate(const glm::vec3 &p0, const glm::vec3 &p1, const float t);
 	glm::vec3 bezierPoint(const glm::vec3 controlCurvePoints[4], float t);
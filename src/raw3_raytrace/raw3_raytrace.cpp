@@ -4,6 +4,7 @@
 // - Materials are extended to support simple specular reflections and transparency with refraction index
 
 #include <iostream>
+#include <random>
 #include <ppgso/ppgso.h>
 
 // Global constants
@@ -11,6 +12,18 @@ constexpr double INF = std::numeric_limits<double>::max();       // Will be used
 constexpr double EPS = std::numeric_limits<double>::epsilon();   // Numerical epsilon
 const double DELTA = sqrt(EPS);                             // Delta to use
 
+// Random generator used for sampling, seeded separately for each pixel
+using Random = std::mt19937;
+
+/*!
+ * Generate a uniformly distributed random number
+ * @param random Generator to draw from
+ * @return Random number in the [0, 1) range
+ */
+inline double uniform(Random &random) {
+  return std::uniform_real_distribution<double>{0.0, 1.0}(random);
+}
+
 /*!
  * Structure holding origin and direction that represents a ray
  */
@@ -62,9 +75,10 @@ struct Camera {
    * @param y Vertical position in the viewport
    * @param width Width of the viewport
    * @param height Height of the viewport
+   * @param random Generator used for the sub-pixel offset
    * @return Ray for the giver viewport position with small random deviation applied to support multi-sampling
    */
-  Ray generateRay(int x, int y, int width, int height) const {
+  Ray generateRay(int x, int y, int width, int height, Random &random) const {
     // Camera deltas
     glm::dvec3 vdu = 2.0 * right / (double)width;
     glm::dvec3 vdv = 2.0 * -up / (double)height;
@@ -72,8 +86,8 @@ struct Camera {
     Ray ray;
     ray.origin = position;
     ray.direction = -back
-                  + vdu * ((double)(-width/2 + x) + glm::linearRand(0.0, 1.0))
-                  + vdv * ((double)(-height/2 + y) + glm::linearRand(0.0, 1.0));
+                  + vdu * ((double)(-width/2 + x) + uniform(random))
+                  + vdv * ((double)(-height/2 + y) + uniform(random));
     ray.direction = normalize(ray.direction);
     return ray;
   }
@@ -124,18 +138,18 @@ struct Sphere {
 /*!
  * Generate a normalized vector that sits on the surface of a half-sphere which is defined using a normal. Used to generate random diffuse reflections.
  * @param normal Normal that defines the dome/half-sphere direction
+ * @param random Generator to draw from
  * @return Random 3D vector on the dome surface
  */
-inline glm::dvec3 RandomDome(const glm::dvec3 &normal) {
-  double d;
-  glm::dvec3 p;
-
-  do {
-    p = glm::sphericalRand(1.0);
-    d = dot(p, normal);
-  } while(d < 0);
-
-  return p;
+inline glm::dvec3 RandomDome(const glm::dvec3 &normal, Random &random) {
+  // Uniform point on the unit sphere
+  double z = 2.0 * uniform(random) - 1.0;
+  double phi = 2.0 * glm::pi<double>() * uniform(random);
+  double r = sqrt(1.0 - z * z);
+  glm::dvec3 p{r * cos(phi), r * sin(phi), z};
+
+  // Mirror it into the dome
+  return dot(p, normal) < 0 ? -p : p;
 }
 
 /*!
@@ -166,9 +180,10 @@ struct World {
    * Trace a ray as it collides with objects in the world
    * @param ray Ray to trace
    * @param depth Maximum number of collisions to trace
+   * @param random Generator used for the random reflections and refractions
    * @return Color representing the accumulated lighting for each ray collision
    */
-  inline glm::dvec3 trace(const Ray &ray, unsigned int depth) const {
+  inline glm::dvec3 trace(const Ray &ray, unsigned int depth, Random &random) const {
     if (depth == 0) return {0, 0, 0};
 
     const Hit hit = cast(ray);
@@ -180,7 +195,7 @@ struct World {
     glm::dvec3 color = hit.material.emission;
 
     // Decide to reflect or refract using linear random
-    if (glm::linearRand(0.0f, 1.0f) < hit.material.transparency) {
+    if (uniform(random) < hit.material.transparency) {
       // Flip normal if the ray is "inside" a sphere
       glm::dvec3 normal = dot(ray.direction, hit.normal) < 0 ? hit.normal : -hit.normal;
       // Reverse the refraction index as well
@@ -192,11 +207,11 @@ struct World {
       // Modulate the refraction color with diffuse color
       glm::dvec3 refractionColor = lerp(hit.material.diffuse, {1,1,1}, hit.material.transparency);
       // Trace the ray recursively
-      color += refractionColor * trace(refractionRay, depth - 1);
+      color += refractionColor * trace(refractionRay, depth - 1, random);
     } else {
       // Calculate reflection
       // Random diffuse reflection
-      glm::dvec3 diffuse = RandomDome(hit.normal);
+      glm::dvec3 diffuse = RandomDome(hit.normal, random);
       // Ideal specular reflection
       glm::dvec3 reflection = reflect(ray.direction, hit.normal);
       // Ray that combines reflection direction depending on the material reflectivness
@@ -204,41 +219,52 @@ struct World {
       // Reflection color is white for specular reflections, otherwise diffuse color is used
       glm::dvec3 reflectionColor = lerp(hit.material.diffuse, {1, 1, 1}, hit.material.reflectivity);
       // Trace the ray recursively
-      color += reflectionColor * trace(reflectedRay, depth - 1);
+      color += reflectionColor * trace(reflectedRay, depth - 1, random);
     }
 
     return color;
   }
 
   /*!
-   * Render the world to the provided image
-   * @param image Image to render to
+   * Render the world to the provided image, samples are accumulated on top of what the image already holds
+   * @param image HDR image to accumulate samples to
+   * @param samples Number of samples per pixel to add
+   * @param depth Maximum number of collisions to trace
    */
-  void render(ppgso::Image& image, unsigned int samples, unsigned int depth) const {
+  void render(ppgso::ImageHDR& image, unsigned int samples, unsigned int depth) const {
     // For each pixel generate rays
     #pragma omp parallel for
     for (int y = 0; y < image.height; ++y) {
       for (int x = 0; x < image.width; ++x) {
         glm::dvec3 color{};
 
+        // Seed from the pixel and the samples accumulated so far so resumed renders add new samples
+        std::seed_seq seed{(unsigned int)image.samples, (unsigned int)(y * image.width + x)};
+        Random random{seed};
+
         // Generate multiple samples
         for (unsigned int i = 0; i < samples; ++i) {
-          auto ray = camera.generateRay(x, y, image.width, image.height);
-          color = color + trace(ray, depth);
+          auto ray = camera.generateRay(x, y, image.width, image.height, random);
+          color = color + trace(ray, depth, random);
         }
         // Collect the data
-        color = color / (double) samples;
-        image.setPixel(x, y, (float)color.r, (float)color.g, (float)color.b);
+        image.addPixel(x, y, {(float)color.r, (float)color.g, (float)color.b});
       }
     }
+    image.samples += samples;
   }
 };
 
 int main() {
   std::cout << "This will take a while ..." << std::endl;
 
-  // Image to render to
-  ppgso::Image image{512, 512};
+  // Accumulation buffer, resume from previous dump if there is one
+  ppgso::ImageHDR accumulator{512, 512};
+  std::ifstream dump{"raw3_raytrace.hdr"};
+  if (dump.good()) {
+    accumulator = ppgso::image::loadHDR("raw3_raytrace.hdr");
+    std::cout << "Resuming from " << accumulator.samples << " samples per pixel" << std::endl;
+  }
 
   // World to render
   const World world{
@@ -262,9 +288,14 @@ int main() {
   };
 
   // Render the scene
-  world.render(image, 32, 5);
+  world.render(accumulator, 32, 5);
+
+  // Keep the raw samples so the render can be continued or tone mapped differently later
+  ppgso::image::saveHDR(accumulator, "raw3_raytrace.hdr");
 
   // Save the result
+  ppgso::Image image{accumulator.width, accumulator.height};
+  accumulator.toneMap(image, ppgso::ImageHDR::ToneMapping::Linear);
   ppgso::image::saveBMP(image, "raw3_raytrace.bmp");
 
   std::cout << "Done." << std::endl;
@@ -125,11 +125,11 @@ public:
         // Generate a vertex array object
         // This keeps track of what attributes are associated with buffers
         glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
 
         // Generate a vertex buffer object, this will feed data to the vertex shader
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
 
         // TODO: Pass the control points to the GPU
         glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec3), points.data(), GL_STATIC_DRAW);
@@ -149,8 +149,8 @@ public:
     }
 
     ~BezierWindow() final {
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
+        ppgso::gl::deleteBuffer(vbo);
+        ppgso::gl::deleteVertexArray(vao);
     }
 
     void onIdle() final {
@@ -161,7 +161,7 @@ public:
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Draw shape
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
 
         // TODO: Define the correct render mode
         glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) points.size());
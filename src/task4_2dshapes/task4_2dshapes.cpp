@@ -72,11 +72,11 @@ public:
     Shape() {
         // Copy data to OpenGL
         glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
 
         // Copy positions to gpu
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vetrices.size() * sizeof(glm::vec3), vetrices.data(), GL_STATIC_DRAW);
 
         // Set vertex program inputs
@@ -86,7 +86,7 @@ public:
 
         // Copy mesh indices to gpu
         glGenBuffers(1, &ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.size() * sizeof(Face), mesh.data(), GL_STATIC_DRAW);
 
         // Set projection matrices to identity
@@ -96,10 +96,10 @@ public:
     // Clean up
     ~Shape() {
         // Delete data from OpenGL
-        glDeleteBuffers(1, &ibo);
-        glDeleteBuffers(1, &cbo);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
+        ppgso::gl::deleteBuffer(ibo);
+        ppgso::gl::deleteBuffer(cbo);
+        ppgso::gl::deleteBuffer(vbo);
+        ppgso::gl::deleteVertexArray(vao);
     }
 
     // Set the object transformation matrix
@@ -119,7 +119,7 @@ public:
         program.setUniform("OverallColor", color);
         program.setUniform("ModelMatrix", modelMatrix);
 
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
         glDrawElements(GL_TRIANGLES, (GLsizei) mesh.size() * 3, GL_UNSIGNED_INT, 0);
     };
 };
@@ -146,7 +146,7 @@ public:
 
         // Move and Render shape
         // Get time for animation
-        auto t = (float) glfwGetTime();
+        auto t = (float) getTime();
 
         // TODO: manipuate shape1 and shape2 position to rotate clockwise
         float vel = 0.01f;
@@ -180,7 +180,7 @@ public:
 
 int main() {
     // Create our window
-    auto window = ShapeWindow{};
+    ShapeWindow window;
 
     // Main execution loop
     while (window.pollEvents()) {}
@@ -78,11 +78,11 @@ public:
     Cube() {
         // Copy data to OpenGL
         glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
 
         // Copy positions to gpu
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
 
         // Set vertex program inputs
@@ -92,7 +92,7 @@ public:
 
         // Copy indices to gpu
         glGenBuffers(1, &ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(Face), indices.data(), GL_STATIC_DRAW);
 
         // Set projection matrices to identity
@@ -103,10 +103,10 @@ public:
     // Clean up
     ~Cube() {
         // Delete data from OpenGL
-        glDeleteBuffers(1, &ibo);
-        glDeleteBuffers(1, &cbo);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
+        ppgso::gl::deleteBuffer(ibo);
+        ppgso::gl::deleteBuffer(cbo);
+        ppgso::gl::deleteBuffer(vbo);
+        ppgso::gl::deleteVertexArray(vao);
     }
 
     // Set the object transformation matrix
@@ -138,7 +138,7 @@ public:
         program.setUniform("ModelMatrix", modelMatrix);
         program.setUniform("ViewMatrix", viewMatrix);
 
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
         glDrawElements(GL_TRIANGLES, (GLsizei) indices.size() * 3, GL_UNSIGNED_INT, 0);
     };
 };
@@ -174,11 +174,11 @@ public:
         glClearColor(.1f,.1f,.1f,1.0f);
         // Clear depth and color buffers
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+        ppgso::gl::depthFunc(GL_LEQUAL);
 
         // Move and Render shape\    // Get time for animation
-        float t = (float) glfwGetTime();
+        float t = (float) getTime();
 
         // Set rotation and scale
         cube.rotation.y = t * 2.0f;
@@ -209,7 +209,7 @@ public:
 
 int main() {
     // Create our window
-    auto window = OriginWindow{};
+    OriginWindow window;
 
     // Main execution loop
     while (window.pollEvents()) {}
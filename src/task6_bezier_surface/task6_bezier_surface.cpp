@@ -117,11 +117,11 @@ public:
 
         // Copy data to OpenGL
         glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
 
         // Copy positions to gpu
         glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
 
         // Set vertex program inputs
@@ -131,7 +131,7 @@ public:
 
         // Copy texture positions to gpu
         glGenBuffers(1, &tbo);
-        glBindBuffer(GL_ARRAY_BUFFER, tbo);
+        ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, tbo);
         glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
 
         // Set vertex program inputs
@@ -141,17 +141,17 @@ public:
 
         // Copy indices to gpu
         glGenBuffers(1, &ibo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        ppgso::gl::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.size() * sizeof(face), mesh.data(), GL_STATIC_DRAW);
 
     };
     // Clean up
     ~BezierPatch() {
         // Delete data from OpenGL
-        glDeleteBuffers(1, &ibo);
-        glDeleteBuffers(1, &tbo);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
+        ppgso::gl::deleteBuffer(ibo);
+        ppgso::gl::deleteBuffer(tbo);
+        ppgso::gl::deleteBuffer(vbo);
+        ppgso::gl::deleteVertexArray(vao);
     }
     // Set the object transformation matrix
     void update() {
@@ -187,10 +187,10 @@ public:
         // Bind texture
         program.setUniform("Texture", texture);
 
-        glBindVertexArray(vao);
+        ppgso::gl::bindVertexArray(vao);
         // TODO: Use correct rendering mode to draw the result
         //glDrawElements(??);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        ppgso::gl::bindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
         glDrawElements(GL_TRIANGLES, (GLsizei)mesh.size() * 3, GL_UNSIGNED_INT, 0);
     };
@@ -211,8 +211,8 @@ public:
     BezierSurfaceWindow() : Window{"task6_bezier_surface", SIZE, SIZE} {
         // Initialize OpenGL state
         // Enable Z-buffer
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+        ppgso::gl::depthFunc(GL_LEQUAL);
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
 
@@ -224,7 +224,7 @@ public:
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Move and Render shape
-        auto time = (float) glfwGetTime();
+        auto time = (float) getTime();
 
         int multi = 1;
         for (int i = 0; i < 4; i++){
@@ -248,7 +248,7 @@ public:
 
 int main() {
     // Create new window
-    auto window = BezierSurfaceWindow{};
+    BezierSurfaceWindow window;
 
     // Main execution loop
     while (window.pollEvents()) {}
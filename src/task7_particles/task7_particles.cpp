@@ -246,8 +246,8 @@ public:
     ParticleWindow() : Window{"task7_particles", SIZE, SIZE} {
         // Initialize OpenGL state
         // Enable Z-buffer
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        ppgso::gl::setEnabled(GL_DEPTH_TEST, true);
+        ppgso::gl::depthFunc(GL_LEQUAL);
     }
 
     void onKey(int key, int scanCode, int action, int mods) override {
@@ -275,10 +275,10 @@ public:
 
     void onIdle() override {
         // Track time
-        static auto time = (float) glfwGetTime();
+        static auto time = (float) getTime();
         // Compute time delta
-        float dTime = (float)glfwGetTime() - time;
-        time = (float) glfwGetTime();
+        float dTime = (float)getTime() - time;
+        time = (float) getTime();
 
         // Set gray background
         glClearColor(0.0f,0.0f,0.0f,1.0f);
@@ -319,7 +319,7 @@ public:
 
 int main() {
     // Create new window
-    auto window = ParticleWindow{};
+    ParticleWindow window;
 
     // Main execution loop
     while (window.pollEvents()) {}